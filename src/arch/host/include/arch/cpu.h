@@ -32,6 +32,9 @@
 #ifndef __INCLUDE_ARCH_CPU__
 #define __INCLUDE_ARCH_CPU__
 
+/* core emulated by the calling thread, set by host scheduler workers */
+extern __thread int host_cpu_id;
+
 static inline void arch_cpu_enable_core(int id)
 {
 }
@@ -47,7 +50,7 @@ static inline int arch_cpu_is_core_enabled(int id)
 
 static inline int arch_cpu_get_id(void)
 {
-	return 0;
+	return host_cpu_id;
 }
 
 static inline void cpu_write_threadptr(int threadptr)
@@ -36,11 +36,30 @@
 #include <errno.h>
 #include <pthread.h>
 
+/* real lock as testbench tasks can run on several threads */
 typedef struct {
+	uint32_t lock;
 } spinlock_t;
 
-static inline void arch_spinlock_init(spinlock_t *lock) {}
-static inline void arch_spin_lock(spinlock_t *lock) {}
-static inline void arch_spin_unlock(spinlock_t *lock) {}
+static inline void arch_spinlock_init(spinlock_t *lock)
+{
+	lock->lock = 0;
+}
+
+static inline int arch_try_lock(spinlock_t *lock)
+{
+	return !__atomic_exchange_n(&lock->lock, 1, __ATOMIC_ACQUIRE);
+}
+
+static inline void arch_spin_lock(spinlock_t *lock)
+{
+	while (!arch_try_lock(lock))
+		;
+}
+
+static inline void arch_spin_unlock(spinlock_t *lock)
+{
+	__atomic_store_n(&lock->lock, 0, __ATOMIC_RELEASE);
+}
 
 #endif
@@ -54,6 +54,24 @@ static inline void arch_atomic_init(atomic_t *a, int32_t value)
 	arch_atomic_set(a, value);
 }
 
+static inline int32_t arch_atomic_read_acquire(const atomic_t *a)
+{
+	int32_t value = a->value;
+
+	/* following memory accesses can't be reordered before the load */
+	__asm__ __volatile__("memw" : : : "memory");
+
+	return value;
+}
+
+static inline void arch_atomic_set_release(atomic_t *a, int32_t value)
+{
+	/* previous memory accesses can't be reordered after the store */
+	__asm__ __volatile__("memw" : : : "memory");
+
+	a->value = value;
+}
+
 static inline int32_t arch_atomic_add(atomic_t *a, int32_t value)
 {
 	int32_t result, current;
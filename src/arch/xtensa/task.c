@@ -146,8 +146,11 @@ static void _irq_task(void *arg)
 		/* run task without holding task lock */
 		spin_unlock_irq(&irq_task->lock, flags);
 
-		if (run_task)
+		if (run_task) {
+			schedule_load_enter();
 			task->func(task->data);
+			schedule_load_exit();
+		}
 
 		spin_lock_irq(&irq_task->lock, flags);
 		schedule_task_complete(task);
@@ -45,23 +45,147 @@
 #include <sof/audio/pipeline.h>
 #include <sof/audio/buffer.h>
 
-/* create a new component in the pipeline */
-struct comp_buffer *buffer_new(struct sof_ipc_buffer *desc)
+/* Buffers freed on topology teardown are kept with their memory and given
+ * to new buffers of the same size class and caps, so repeated stream
+ * open/close doesn't churn and fragment the buffer heap. Buffers are only
+ * created and freed by IPC on the master core.
+ */
+struct buffer_pool {
+	struct list_item list;	/* pooled buffers, most recently freed first */
+	uint32_t count;		/* number of pooled buffers */
+	spinlock_t lock;
+};
+
+static struct buffer_pool *pool;
+
+/* size class is the number of buffer heap blocks used by the memory */
+static inline uint32_t buffer_size_class(uint32_t bytes)
 {
-	struct comp_buffer *buffer;
-	int err;
+	return (bytes + HEAP_BUFFER_BLOCK_SIZE - 1) / HEAP_BUFFER_BLOCK_SIZE;
+}
 
-	trace_buffer("buffer_new()");
+/* take pooled buffer with memory suitable for desc, the memory must be at
+ * least desc size and of the same size class to not waste bigger blocks
+ */
+static struct comp_buffer *buffer_pool_get(struct sof_ipc_buffer *desc)
+{
+	struct comp_buffer *buffer = NULL;
+	struct list_item *blist;
+	uint32_t alloc_size;
+	uint32_t flags;
+	void *addr;
 
-	/* validate request */
-	if (desc->size == 0 || desc->size > HEAP_BUFFER_SIZE) {
-		trace_buffer_error("buffer_new() error: "
-				   "new size = %u is invalid", desc->size);
+	if (!pool)
 		return NULL;
+
+	spin_lock_irq(&pool->lock, flags);
+
+	list_for_item(blist, &pool->list) {
+		buffer = container_of(blist, struct comp_buffer, source_list);
+		if (buffer->ipc_buffer.caps == desc->caps &&
+		    buffer->alloc_size >= desc->size &&
+		    buffer_size_class(buffer->alloc_size) ==
+		    buffer_size_class(desc->size)) {
+			list_item_del(&buffer->source_list);
+			pool->count--;
+			break;
+		}
+		buffer = NULL;
 	}
 
-	/* allocate new buffer */
+	spin_unlock_irq(&pool->lock, flags);
+
+	if (!buffer)
+		return NULL;
+
+	tracev_buffer("buffer_pool_get(), reusing %u bytes for %u bytes",
+		      buffer->alloc_size, desc->size);
+
+	/* start from clean state as with newly allocated buffer, the
+	 * memory keeps its allocated size
+	 */
+	addr = buffer->addr;
+	alloc_size = buffer->alloc_size;
+	bzero(buffer, sizeof(*buffer));
+	buffer->addr = addr;
+	buffer->alloc_size = alloc_size;
+
+	return buffer;
+}
+
+/* keep buffer with its memory for reuse, returns false if pool is full */
+static bool buffer_pool_put(struct comp_buffer *buffer)
+{
+	uint32_t flags;
+	bool pooled = false;
+
+	if (!pool)
+		return false;
+
+	spin_lock_irq(&pool->lock, flags);
+
+	if (pool->count < BUFFER_POOL_DEPTH) {
+		list_item_prepend(&buffer->source_list, &pool->list);
+		pool->count++;
+		pooled = true;
+	}
+
+	spin_unlock_irq(&pool->lock, flags);
+
+	return pooled;
+}
+
+int buffer_pool_trim(void)
+{
+	struct comp_buffer *buffer;
+	struct list_item *blist;
+	struct list_item *tmp;
+	uint32_t flags;
+	int count = 0;
+
+	if (!pool)
+		return 0;
+
+	spin_lock_irq(&pool->lock, flags);
+
+	list_for_item_safe(blist, tmp, &pool->list) {
+		buffer = container_of(blist, struct comp_buffer, source_list);
+		list_item_del(&buffer->source_list);
+		rfree(buffer->addr);
+		rfree(buffer);
+		count++;
+	}
+
+	pool->count = 0;
+
+	spin_unlock_irq(&pool->lock, flags);
+
+	trace_buffer("buffer_pool_trim(), freed %d buffers", count);
+
+	return count;
+}
+
+void sys_buffer_init(void)
+{
+	pool = rzalloc(RZONE_SYS, SOF_MEM_CAPS_RAM, sizeof(*pool));
+	list_init(&pool->list);
+	spinlock_init(&pool->lock);
+
+	/* pooled memory is given back when any buffer heap user runs out */
+	heap_set_buffer_reclaim(buffer_pool_trim);
+}
+
+/* allocate buffer and its memory, pooled buffers are given back to the
+ * heap if it's running out of memory, the buffer heap does it by itself
+ */
+static struct comp_buffer *buffer_alloc(struct sof_ipc_buffer *desc)
+{
+	struct comp_buffer *buffer;
+
 	buffer = rzalloc(RZONE_RUNTIME, SOF_MEM_CAPS_RAM, sizeof(*buffer));
+	if (!buffer && buffer_pool_trim())
+		buffer = rzalloc(RZONE_RUNTIME, SOF_MEM_CAPS_RAM,
+				 sizeof(*buffer));
 	if (!buffer) {
 		trace_buffer_error("buffer_new() error: "
 				   "could not alloc structure");
@@ -78,10 +202,39 @@ struct comp_buffer *buffer_new(struct sof_ipc_buffer *desc)
 		return NULL;
 	}
 
+	buffer->alloc_size = desc->size;
+
+	return buffer;
+}
+
+/* create a new component in the pipeline */
+struct comp_buffer *buffer_new(struct sof_ipc_buffer *desc)
+{
+	struct comp_buffer *buffer;
+	int err;
+
+	trace_buffer("buffer_new()");
+
+	/* validate request */
+	if (desc->size == 0 || desc->size > HEAP_BUFFER_SIZE) {
+		trace_buffer_error("buffer_new() error: "
+				   "new size = %u is invalid", desc->size);
+		return NULL;
+	}
+
+	/* reuse pooled buffer or allocate new one */
+	buffer = buffer_pool_get(desc);
+	if (!buffer) {
+		buffer = buffer_alloc(desc);
+		if (!buffer)
+			return NULL;
+	}
+
 	err = memcpy_s(&buffer->ipc_buffer, sizeof(buffer->ipc_buffer),
 		       desc, sizeof(*desc));
 
 	if (err) {
+		rfree(buffer->addr);
 		rfree(buffer);
 		trace_buffer_error("buffer_new() error: "
 				   "could not coppy data");
@@ -89,7 +242,6 @@ struct comp_buffer *buffer_new(struct sof_ipc_buffer *desc)
 	}
 
 	buffer->size = desc->size;
-	buffer->alloc_size = desc->size;
 	buffer->ipc_buffer = *desc;
 	buffer->w_ptr = buffer->addr;
 	buffer->r_ptr = buffer->addr;
@@ -104,6 +256,12 @@ struct comp_buffer *buffer_new(struct sof_ipc_buffer *desc)
 	return buffer;
 }
 
+/* only buffers outside of alias chain can be bypassed by copies */
+static void buffer_alias_bypass(struct comp_buffer *buffer)
+{
+	buffer->no_bypass = buffer->alias || buffer->alias_next;
+}
+
 /* free component in the pipeline */
 void buffer_free(struct comp_buffer *buffer)
 {
@@ -111,31 +269,128 @@ void buffer_free(struct comp_buffer *buffer)
 
 	list_item_del(&buffer->source_list);
 	list_item_del(&buffer->sink_list);
-	rfree(buffer->addr);
+
+	/* shared memory is freed with the last buffer using it */
+	if (!buffer->alias && !buffer->alias_next) {
+		if (buffer_pool_put(buffer))
+			return;
+
+		rfree(buffer->addr);
+	}
+
+	if (buffer->alias) {
+		buffer->alias->alias_next = buffer->alias_next;
+		buffer_alias_bypass(buffer->alias);
+	}
+	if (buffer->alias_next) {
+		buffer->alias_next->alias = buffer->alias;
+		buffer_alias_bypass(buffer->alias_next);
+	}
+
 	rfree(buffer);
 }
 
-void comp_update_buffer_produce(struct comp_buffer *buffer, uint32_t bytes)
+int buffer_alias(struct comp_buffer *buffer, struct comp_buffer *source)
 {
-	uint32_t flags;
-	uint32_t head = bytes;
-	uint32_t tail = 0;
+	if (buffer->alias || buffer->alias_next || source->alias_next ||
+	    buffer->ipc_buffer.size != source->ipc_buffer.size ||
+	    buffer->ipc_buffer.caps != source->ipc_buffer.caps) {
+		trace_buffer_error("buffer_alias() error: buffer %u can't "
+				   "alias buffer %u",
+				   buffer->ipc_buffer.comp.id,
+				   source->ipc_buffer.comp.id);
+		return -EINVAL;
+	}
 
-	/* return if no bytes */
-	if (!bytes) {
-		trace_buffer("comp_update_buffer_produce(), "
-			     "no bytes to produce");
-		return;
+	trace_buffer("buffer_alias(), buffer %u aliases buffer %u",
+		     buffer->ipc_buffer.comp.id, source->ipc_buffer.comp.id);
+
+	rfree(buffer->addr);
+
+	buffer->alias = source;
+	source->alias_next = buffer;
+	buffer_alias_bypass(buffer);
+	buffer_alias_bypass(source);
+
+	/* shared memory is what source has allocated */
+	buffer->addr = source->addr;
+	buffer->alloc_size = source->alloc_size;
+	buffer->end_addr = buffer->addr + buffer->size;
+	buffer_reset_pos(buffer);
+
+	return 0;
+}
+
+int buffer_unalias(struct comp_buffer *buffer)
+{
+	struct comp_buffer *alias;
+	void *addr;
+
+	if (!buffer->alias)
+		return 0;
+
+	trace_buffer("buffer_unalias(), buffer %u",
+		     buffer->ipc_buffer.comp.id);
+
+	addr = rballoc(RZONE_BUFFER, buffer->ipc_buffer.caps,
+		       buffer->alloc_size);
+	if (!addr) {
+		trace_buffer_error("buffer_unalias() error: could not alloc "
+				   "size = %u bytes", buffer->alloc_size);
+		return -ENOMEM;
 	}
 
-	spin_lock_irq(&buffer->lock, flags);
+	buffer->alias->alias_next = NULL;
+	buffer_alias_bypass(buffer->alias);
+	buffer->alias = NULL;
+	buffer_alias_bypass(buffer);
 
-	/* calculate head and tail size for dcache circular wrap ops */
-	if (buffer->w_ptr + bytes > buffer->end_addr) {
-		head = buffer->end_addr - buffer->w_ptr;
-		tail = bytes - head;
+	/* downstream buffers keep sharing memory with this one */
+	for (alias = buffer; alias; alias = alias->alias_next) {
+		alias->addr = addr;
+		alias->end_addr = addr + alias->size;
+		buffer_reset_pos(alias);
 	}
 
+	return 0;
+}
+
+/* aliased buffers share free space, it's tracked by the first buffer */
+/* first buffer of alias chain accounts for data of all, its lock held */
+static void buffer_alias_free(struct comp_buffer *head)
+{
+	struct comp_buffer *buffer;
+	uint32_t used = 0;
+
+	for (buffer = head; buffer; buffer = buffer->alias_next)
+		used += buffer->avail;
+
+	head->free = head->size - used;
+}
+
+static void buffer_alias_update(struct comp_buffer *buffer)
+{
+	struct comp_buffer *head = buffer;
+	uint32_t flags;
+
+	while (head->alias)
+		head = head->alias;
+
+	spin_lock_irq(&head->lock, flags);
+	buffer_alias_free(head);
+	spin_unlock_irq(&head->lock, flags);
+}
+
+/* handle consistency for buffer and cache for newly produced data */
+static void buffer_produce_cache(struct comp_buffer *buffer, uint32_t bytes)
+{
+	struct buffer_span spans[2];
+	int count;
+	int i;
+
+	/* get head and tail regions for dcache circular wrap ops */
+	count = buffer_write_spans(buffer, bytes, spans);
+
 	/*
 	 * new data produce, handle consistency for buffer and cache:
 	 * 1. source(DMA) --> buffer --> sink(non-DMA): invalidate cache.
@@ -146,22 +401,68 @@ void comp_update_buffer_produce(struct comp_buffer *buffer, uint32_t bytes)
 	if (buffer->source->is_dma_connected &&
 	    !buffer->sink->is_dma_connected) {
 		/* need invalidate cache for sink component to use */
-		dcache_invalidate_region(buffer->w_ptr, head);
-		if (tail)
-			dcache_invalidate_region(buffer->addr, tail);
+		for (i = 0; i < count; i++)
+			dcache_invalidate_region(spans[i].ptr, spans[i].bytes);
 	} else if (!buffer->source->is_dma_connected &&
 		   buffer->sink->is_dma_connected) {
 		/* need write back to memory for sink component to use */
-		dcache_writeback_region(buffer->w_ptr, head);
-		if (tail)
-			dcache_writeback_region(buffer->addr, tail);
+		for (i = 0; i < count; i++)
+			dcache_writeback_region(spans[i].ptr, spans[i].bytes);
 	}
+}
+
+/* calculate available and free bytes from SPSC counters */
+static void buffer_spsc_update(struct comp_buffer *buffer)
+{
+	buffer->avail = (uint32_t)atomic_read_acquire(&buffer->w_idx) -
+		(uint32_t)atomic_read_acquire(&buffer->r_idx);
+	buffer->free = buffer->size - buffer->avail;
+}
+
+void buffer_set_spsc(struct comp_buffer *buffer, bool spsc)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&buffer->lock, flags);
 
-	buffer->w_ptr += bytes;
+	/* counters start from the current fill level */
+	atomic_init(&buffer->r_idx, 0);
+	atomic_init(&buffer->w_idx, buffer->avail);
+	buffer->spsc = spsc;
 
-	/* check for pointer wrap */
-	if (buffer->w_ptr >= buffer->end_addr)
-		buffer->w_ptr = buffer->addr + (buffer->w_ptr - buffer->end_addr);
+	spin_unlock_irq(&buffer->lock, flags);
+
+	tracev_buffer("buffer_set_spsc(), buffer->ipc_buffer.comp.id = %u, "
+		      "spsc = %d", buffer->ipc_buffer.comp.id, spsc);
+}
+
+/* lock free produce, only producer updates w_ptr and w_idx */
+static void buffer_produce_spsc(struct comp_buffer *buffer, uint32_t bytes)
+{
+	buffer_produce_cache(buffer, bytes);
+
+	buffer->w_ptr = buffer_wrap(buffer, buffer->w_ptr + bytes);
+
+	/* publish data to consumer after it has been written */
+	atomic_set_release(&buffer->w_idx,
+			   atomic_read(&buffer->w_idx) + bytes);
+
+	buffer_spsc_update(buffer);
+
+	if (buffer->cb && buffer->cb_type & BUFF_CB_TYPE_PRODUCE)
+		buffer->cb(buffer->cb_data, bytes);
+}
+
+static void buffer_produce_locked(struct comp_buffer *buffer, uint32_t bytes)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&buffer->lock, flags);
+
+	buffer_produce_cache(buffer, bytes);
+
+	buffer->w_ptr = buffer_wrap(buffer, buffer->w_ptr + bytes);
+	atomic_set(&buffer->w_idx, atomic_read(&buffer->w_idx) + bytes);
 
 	/* calculate available bytes */
 	if (buffer->r_ptr < buffer->w_ptr)
@@ -173,11 +474,31 @@ void comp_update_buffer_produce(struct comp_buffer *buffer, uint32_t bytes)
 
 	/* calculate free bytes */
 	buffer->free = buffer->size - buffer->avail;
+	if (buffer->alias_next)
+		buffer_alias_free(buffer);
 
 	if (buffer->cb && buffer->cb_type & BUFF_CB_TYPE_PRODUCE)
 		buffer->cb(buffer->cb_data, bytes);
 
 	spin_unlock_irq(&buffer->lock, flags);
+}
+
+void comp_update_buffer_produce(struct comp_buffer *buffer, uint32_t bytes)
+{
+	/* return if no bytes */
+	if (!bytes) {
+		trace_buffer("comp_update_buffer_produce(), "
+			     "no bytes to produce");
+		return;
+	}
+
+	if (buffer->spsc)
+		buffer_produce_spsc(buffer, bytes);
+	else
+		buffer_produce_locked(buffer, bytes);
+
+	if (buffer->alias || buffer->alias_next)
+		buffer_alias_update(buffer);
 
 	tracev_buffer("comp_update_buffer_produce(), ((buffer->avail << 16) | "
 		      "buffer->free) = %08x, ((buffer->ipc_buffer.comp.id << "
@@ -190,25 +511,29 @@ void comp_update_buffer_produce(struct comp_buffer *buffer, uint32_t bytes)
 		      (buffer->w_ptr - buffer->addr));
 }
 
-void comp_update_buffer_consume(struct comp_buffer *buffer, uint32_t bytes)
+/* lock free consume, only consumer updates r_ptr and r_idx */
+static void buffer_consume_spsc(struct comp_buffer *buffer, uint32_t bytes)
 {
-	uint32_t flags;
+	buffer->r_ptr = buffer_wrap(buffer, buffer->r_ptr + bytes);
 
-	/* return if no bytes */
-	if (!bytes) {
-		trace_buffer("comp_update_buffer_consume(), "
-			     "no bytes to consume");
-		return;
-	}
+	/* release space to producer after data has been read */
+	atomic_set_release(&buffer->r_idx,
+			   atomic_read(&buffer->r_idx) + bytes);
 
-	spin_lock_irq(&buffer->lock, flags);
+	buffer_spsc_update(buffer);
 
-	buffer->r_ptr += bytes;
+	if (buffer->cb && buffer->cb_type & BUFF_CB_TYPE_CONSUME)
+		buffer->cb(buffer->cb_data, bytes);
+}
 
-	/* check for pointer wrap */
-	if (buffer->r_ptr >= buffer->end_addr)
-		buffer->r_ptr = buffer->addr +
-			(buffer->r_ptr - buffer->end_addr);
+static void buffer_consume_locked(struct comp_buffer *buffer, uint32_t bytes)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&buffer->lock, flags);
+
+	buffer->r_ptr = buffer_wrap(buffer, buffer->r_ptr + bytes);
+	atomic_set(&buffer->r_idx, atomic_read(&buffer->r_idx) + bytes);
 
 	/* calculate available bytes */
 	if (buffer->r_ptr < buffer->w_ptr)
@@ -220,6 +545,8 @@ void comp_update_buffer_consume(struct comp_buffer *buffer, uint32_t bytes)
 
 	/* calculate free bytes */
 	buffer->free = buffer->size - buffer->avail;
+	if (buffer->alias_next)
+		buffer_alias_free(buffer);
 
 	if (buffer->sink->is_dma_connected &&
 	    !buffer->source->is_dma_connected)
@@ -229,6 +556,24 @@ void comp_update_buffer_consume(struct comp_buffer *buffer, uint32_t bytes)
 		buffer->cb(buffer->cb_data, bytes);
 
 	spin_unlock_irq(&buffer->lock, flags);
+}
+
+void comp_update_buffer_consume(struct comp_buffer *buffer, uint32_t bytes)
+{
+	/* return if no bytes */
+	if (!bytes) {
+		trace_buffer("comp_update_buffer_consume(), "
+			     "no bytes to consume");
+		return;
+	}
+
+	if (buffer->spsc)
+		buffer_consume_spsc(buffer, bytes);
+	else
+		buffer_consume_locked(buffer, bytes);
+
+	if (buffer->alias || buffer->alias_next)
+		buffer_alias_update(buffer);
 
 	tracev_buffer("comp_update_buffer_consume(), %u, %u, %u",
 		      (buffer->avail << 16) | buffer->free,
@@ -237,6 +237,28 @@ void comp_set_period_bytes(struct comp_dev *dev, uint32_t frames,
 	*period_bytes = frames * comp_frame_bytes(dev);
 }
 
+void *comp_arena_alloc(struct comp_dev *dev, size_t bytes)
+{
+	if (!dev->pipeline) {
+		trace_comp_error("comp_arena_alloc() error: comp %u is not "
+				 "in a pipeline", dev->comp.id);
+		return NULL;
+	}
+
+	dev->arena_released = false;
+
+	return pipeline_arena_alloc(dev->pipeline, bytes);
+}
+
+void comp_arena_free(struct comp_dev *dev, void *ptr)
+{
+	/* released arena memory may be in use by someone else already */
+	if (!ptr || !dev->pipeline || dev->arena_released)
+		return;
+
+	pipeline_arena_free(dev->pipeline, ptr);
+}
+
 void sys_comp_init(void)
 {
 	cd = rzalloc(RZONE_SYS, SOF_MEM_CAPS_RAM, sizeof(*cd));
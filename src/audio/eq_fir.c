@@ -33,7 +33,9 @@
 #include <stdbool.h>
 #include <sof/sof.h>
 #include <sof/audio/component.h>
+#include <sof/audio/eq_fir.h>
 #include <sof/ipc.h>
+#include <sof/ut.h>
 #include <uapi/user/eq.h>
 #include "fir_config.h"
 
@@ -49,6 +51,8 @@
 #include "fir_hifi3.h"
 #endif
 
+#include "fir_fft.h"
+
 #ifdef MODULE_TEST
 #include <stdio.h>
 #endif
@@ -58,9 +62,14 @@
 #define trace_eq_error(__e, ...) \
 	trace_error(TRACE_CLASS_EQ_FIR, __e, ##__VA_ARGS__)
 
+/* Responses longer than this are run with FFT convolution */
+#define EQ_FIR_FFT_THRESHOLD	SOF_EQ_FIR_MAX_LENGTH
+
 /* src component private data */
 struct comp_data {
 	struct fir_state_32x16 fir[PLATFORM_MAX_CHANNELS]; /**< filters state */
+	struct fir_fft_state fft[PLATFORM_MAX_CHANNELS]; /**< FFT filters */
+	int fft_count;			  /**< channels with FFT filter */
 	struct sof_eq_fir_config *config; /**< pointer to setup blob */
 	enum sof_ipc_frame source_format; /**< source frame format */
 	enum sof_ipc_frame sink_format;   /**< sink frame format */
@@ -74,6 +83,10 @@ struct comp_data {
 			    struct comp_buffer *source,
 			    struct comp_buffer *sink,
 			    int frames, int nch);
+	void (*eq_fir_fft_func)(struct fir_fft_state fft[],
+				struct comp_buffer *source,
+				struct comp_buffer *sink,
+				int frames, int nch);
 };
 
 /* The optimized FIR functions variants need to be updated into function
@@ -147,19 +160,26 @@ static inline int set_fir_func(struct comp_dev *dev)
 	case SOF_IPC_FRAME_S16_LE:
 		trace_eq("set_fir_func(), SOF_IPC_FRAME_S16_LE");
 		set_s16_fir(cd);
+		cd->eq_fir_fft_func = eq_fir_fft_s16;
 		break;
 	case SOF_IPC_FRAME_S24_4LE:
 		trace_eq("set_fir_func(), SOF_IPC_FRAME_S24_4LE");
 		set_s24_fir(cd);
+		cd->eq_fir_fft_func = eq_fir_fft_s24;
 		break;
 	case SOF_IPC_FRAME_S32_LE:
 		trace_eq("set_fir_func(), SOF_IPC_FRAME_S32_LE");
 		set_s32_fir(cd);
+		cd->eq_fir_fft_func = eq_fir_fft_s32;
 		break;
 	default:
 		trace_eq_error("set_fir_func(), invalid frame_fmt");
 		return -EINVAL;
 	}
+
+	if (!cd->fft_count)
+		cd->eq_fir_fft_func = NULL;
+
 	return 0;
 }
 
@@ -207,6 +227,8 @@ static inline int set_pass_func(struct comp_dev *dev)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
 
+	cd->eq_fir_fft_func = NULL;
+
 	switch (dev->params.frame_fmt) {
 	case SOF_IPC_FRAME_S16_LE:
 		trace_eq("set_pass_func(), SOF_IPC_FRAME_S16_LE");
@@ -237,35 +259,47 @@ static void eq_fir_free_parameters(struct sof_eq_fir_config **config)
 	*config = NULL;
 }
 
-static void eq_fir_free_delaylines(struct comp_data *cd)
+static void eq_fir_free_delaylines(struct comp_dev *dev)
 {
+	struct comp_data *cd = comp_get_drvdata(dev);
 	struct fir_state_32x16 *fir = cd->fir;
 	int i = 0;
 
 	/* Free the common buffer for all EQs and point then
 	 * each FIR channel delay line to NULL.
 	 */
-	rfree(cd->fir_delay);
+	comp_arena_free(dev, cd->fir_delay);
+	cd->fir_delay = NULL;
 	cd->fir_delay_size = 0;
-	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
+	cd->fft_count = 0;
+	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++) {
 		fir[i].delay = NULL;
+		fir_fft_reset(&cd->fft[i]);
+	}
 }
 
-static int eq_fir_setup(struct comp_data *cd, int nch)
+static int eq_fir_setup(struct comp_dev *dev, int nch)
 {
+	struct comp_data *cd = comp_get_drvdata(dev);
 	struct fir_state_32x16 *fir = cd->fir;
+	struct fir_fft_state *fft = cd->fft;
 	struct sof_eq_fir_config *config = cd->config;
 	struct sof_eq_fir_coef_data *lookup[SOF_EQ_FIR_MAX_RESPONSES];
 	struct sof_eq_fir_coef_data *eq;
 	int32_t *fir_delay;
 	int16_t *coef_data;
 	int16_t *assign_response;
+	int block;
 	int resp;
+	int ret;
 	int i;
 	int j;
 	size_t s;
 	size_t size_sum = 0;
 
+	/* Free existing FIR channels data if it was allocated */
+	eq_fir_free_delaylines(dev);
+
 	trace_eq("eq_fir_setup(), "
 		 "channels_in_config = %u, number_of_responses = %u",
 		 config->channels_in_config, config->number_of_responses);
@@ -324,18 +358,45 @@ static int eq_fir_setup(struct comp_data *cd, int nch)
 		if (resp >= config->number_of_responses)
 			return -EINVAL;
 
-		/* Initialize EQ coefficients. */
+		/* Initialize EQ coefficients. A long response is run with
+		 * FFT convolution and the direct form filter is bypassed.
+		 */
 		eq = lookup[resp];
-		s = fir_init_coef(&fir[i], eq);
-		if (s > 0)
-			size_sum += s;
-		else
-			return -EINVAL;
+		if (eq->length > EQ_FIR_FFT_THRESHOLD) {
+			fir_reset(&fir[i]);
+			ret = fir_fft_init_coef(&fft[i], eq, dev->frames);
+			if (ret < 0)
+				return ret;
+
+			size_sum += ret;
+			cd->fft_count++;
+			trace_eq("eq_fir_setup(), ch = %d FFT block = %d",
+				 i, fft[i].block);
+		} else {
+			s = fir_init_coef(&fir[i], eq);
+			if (s > 0)
+				size_sum += s;
+			else
+				return -EINVAL;
+		}
 
 		trace_eq("eq_fir_setup(), "
 			 "ch = %d initialized to response = %d", i, resp);
 	}
 
+	/* The FFT filters delay their output by one block. Delay all other
+	 * channels by the same amount to keep the channels aligned.
+	 */
+	if (cd->fft_count) {
+		block = 0;
+		for (i = 0; i < nch; i++)
+			block = MAX(block, fft[i].block);
+
+		for (i = 0; i < nch; i++)
+			if (!fft[i].partitions)
+				size_sum += fir_fft_init_align(&fft[i], block);
+	}
+
 	/* If all channels were set to bypass there's no need to
 	 * allocate delay. Just return with success.
 	 */
@@ -345,7 +406,7 @@ static int eq_fir_setup(struct comp_data *cd, int nch)
 		return 0;
 
 	/* Allocate all FIR channels data in a big chunk and clear it */
-	cd->fir_delay = rballoc(RZONE_RUNTIME, SOF_MEM_CAPS_RAM, size_sum);
+	cd->fir_delay = comp_arena_alloc(dev, size_sum);
 	if (!cd->fir_delay) {
 		trace_eq_error("eq_fir_setup() error: alloc failed, size = %u",
 			       size_sum);
@@ -355,10 +416,11 @@ static int eq_fir_setup(struct comp_data *cd, int nch)
 	/* Initialize 2nd phase to set EQ delay lines pointers */
 	fir_delay = cd->fir_delay;
 	for (i = 0; i < nch; i++) {
-		resp = assign_response[i];
-		if (resp >= 0) {
+		if (fir[i].length)
 			fir_init_delay(&fir[i], &fir_delay);
-		}
+
+		if (fft[i].block)
+			fir_fft_init_delay(&fft[i], &fir_delay);
 	}
 
 	return 0;
@@ -463,7 +525,7 @@ static void eq_fir_free(struct comp_dev *dev)
 
 	trace_eq("eq_fir_free()");
 
-	eq_fir_free_delaylines(cd);
+	eq_fir_free_delaylines(dev);
 	eq_fir_free_parameters(&cd->config);
 
 	rfree(cd);
@@ -536,6 +598,7 @@ static int fir_cmd_set_data(struct comp_dev *dev,
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
 	struct sof_ipc_ctrl_value_comp *compv;
+	struct sof_eq_fir_config *config;
 	unsigned char *dst, *src;
 	uint32_t offset;
 	int i;
@@ -594,19 +657,18 @@ static int fir_cmd_set_data(struct comp_dev *dev,
 			return -EINVAL;
 
 		if (cdata->msg_index == 0) {
-			/* Check and free old config */
-			eq_fir_free_parameters(&cd->config);
-
-			/* Allocate buffer for copy of the blob. */
-			cd->config = rballoc(RZONE_RUNTIME, SOF_MEM_CAPS_RAM,
-					     cdata->num_elems +
-					     cdata->elems_remaining);
-
-			if (!cd->config) {
+			/* Reuse old config memory for copy of the blob. */
+			config = rrealloc(cd->config, RZONE_BUFFER,
+					  SOF_MEM_CAPS_RAM, cdata->num_elems +
+					  cdata->elems_remaining);
+			if (!config) {
 				trace_eq_error("fir_cmd_set_data() error: "
 					       "buffer allocation failed");
+				eq_fir_free_parameters(&cd->config);
 				return -EINVAL;
 			}
+
+			cd->config = config;
 			offset = 0;
 		} else {
 			offset = cd->config->size - cdata->elems_remaining -
@@ -693,9 +755,31 @@ static int eq_fir_copy(struct comp_dev *dev)
 	else
 		cd->eq_fir_func_even(fir, cl.source, cl.sink, cl.frames, nch);
 
+	/* Overwrite the bypassed channels that have FFT filter */
+	if (cd->eq_fir_fft_func)
+		cd->eq_fir_fft_func(cd->fft, cl.source, cl.sink, cl.frames,
+				    nch);
+
 	/* calc new free and available */
-	comp_update_buffer_consume(cl.source, cl.source_bytes);
 	comp_update_buffer_produce(cl.sink, cl.sink_bytes);
+	comp_update_buffer_consume(cl.source, cl.source_bytes);
+
+	return 0;
+}
+
+static int eq_fir_process(struct comp_dev *dev, struct comp_buffer *source,
+			  struct comp_buffer *sink, uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int nch = dev->params.channels;
+
+	if (frames & 1)
+		cd->eq_fir_func(cd->fir, source, sink, frames, nch);
+	else
+		cd->eq_fir_func_even(cd->fir, source, sink, frames, nch);
+
+	if (cd->eq_fir_fft_func)
+		cd->eq_fir_fft_func(cd->fft, source, sink, frames, nch);
 
 	return 0;
 }
@@ -750,7 +834,7 @@ static int eq_fir_prepare(struct comp_dev *dev)
 
 	/* Initialize EQ */
 	if (cd->config) {
-		ret = eq_fir_setup(cd, dev->params.channels);
+		ret = eq_fir_setup(dev, dev->params.channels);
 		if (ret < 0) {
 			trace_eq_error("eq_fir_prepare() error: "
 				       "eq_fir_setup failed.");
@@ -776,10 +860,11 @@ static int eq_fir_reset(struct comp_dev *dev)
 
 	trace_eq("eq_fir_reset()");
 
-	eq_fir_free_delaylines(cd);
+	eq_fir_free_delaylines(dev);
 
 	cd->eq_fir_func_even = eq_fir_s32_passthrough;
 	cd->eq_fir_func = eq_fir_s32_passthrough;
+	cd->eq_fir_fft_func = NULL;
 	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
 		fir_reset(&cd->fir[i]);
 
@@ -831,6 +916,7 @@ static void eq_fir_cache(struct comp_dev *dev, int cmd)
 
 struct comp_driver comp_eq_fir = {
 	.type = SOF_COMP_EQ_FIR,
+	.flags = COMP_DRV_INPLACE,
 	.ops = {
 		.new = eq_fir_new,
 		.free = eq_fir_free,
@@ -838,13 +924,14 @@ struct comp_driver comp_eq_fir = {
 		.cmd = eq_fir_cmd,
 		.trigger = eq_fir_trigger,
 		.copy = eq_fir_copy,
+		.process = eq_fir_process,
 		.prepare = eq_fir_prepare,
 		.reset = eq_fir_reset,
 		.cache = eq_fir_cache,
 	},
 };
 
-static void sys_comp_eq_fir_init(void)
+UT_STATIC void sys_comp_eq_fir_init(void)
 {
 	comp_register(&comp_eq_fir);
 }
@@ -41,6 +41,7 @@
 #include <sof/ipc.h>
 #include <sof/audio/component.h>
 #include <sof/audio/format.h>
+#include <sof/math/numbers.h>
 #include <uapi/user/eq.h>
 #include "eq_iir.h"
 #include "iir.h"
@@ -66,153 +67,193 @@ struct comp_data {
 			    struct comp_buffer *source,
 			    struct comp_buffer *sink,
 			    uint32_t frames);
+	int lanes[PLATFORM_MAX_CHANNELS];   /**< channels run in lockstep */
+	int32_t block_x[IIR_BLOCK_SIZE * IIR_LANES_MAX]; /**< block input */
+	int32_t block_y[IIR_BLOCK_SIZE * IIR_LANES_MAX]; /**< block output */
+	int32_t block_w[IIR_BLOCK_SIZE * IIR_LANES_MAX]; /**< block work */
 };
 
 /*
  * EQ IIR algorithm code
  */
 
-static void eq_iir_s16_default(struct comp_dev *dev,
-			       struct comp_buffer *source,
-			       struct comp_buffer *sink,
-			       uint32_t frames)
+typedef void (*eq_iir_read)(struct comp_buffer *source, int32_t *x, int idx,
+			    int nch, int lanes, int frames);
 
+typedef void (*eq_iir_write)(struct comp_buffer *sink, int32_t *y, int idx,
+			     int nch, int lanes, int frames);
+
+/* The read functions copy frames of lanes channels starting from idx to
+ * block buffer in Q1.31 and the write functions copy them back to sink
+ * in the sink format.
+ */
+static void eq_iir_read_s16(struct comp_buffer *source, int32_t *x, int idx,
+			    int nch, int lanes, int frames)
 {
-	struct comp_data *cd = comp_get_drvdata(dev);
-	struct iir_state_df2t *filter;
-	int16_t *x;
-	int16_t *y;
-	int32_t z;
-	int ch;
+	int16_t *s;
 	int i;
-	int idx;
-	int nch = dev->params.channels;
+	int j;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = buffer_read_frag_s16(source, idx);
-			y = buffer_write_frag_s16(sink, idx);
-			z = iir_df2t(filter, *x << 16);
-			*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
-			idx += nch;
+	for (i = 0; i < frames; i++) {
+		for (j = 0; j < lanes; j++) {
+			s = buffer_read_frag_s16(source, idx + j);
+			*x++ = *s << 16;
 		}
+		idx += nch;
 	}
 }
 
-static void eq_iir_s24_default(struct comp_dev *dev,
-			       struct comp_buffer *source,
-			       struct comp_buffer *sink,
-			       uint32_t frames)
+static void eq_iir_read_s24(struct comp_buffer *source, int32_t *x, int idx,
+			    int nch, int lanes, int frames)
+{
+	int32_t *s;
+	int i;
+	int j;
+
+	for (i = 0; i < frames; i++) {
+		for (j = 0; j < lanes; j++) {
+			s = buffer_read_frag_s32(source, idx + j);
+			*x++ = *s << 8;
+		}
+		idx += nch;
+	}
+}
 
+static void eq_iir_read_s32(struct comp_buffer *source, int32_t *x, int idx,
+			    int nch, int lanes, int frames)
 {
-	struct comp_data *cd = comp_get_drvdata(dev);
-	struct iir_state_df2t *filter;
-	int32_t *x;
-	int32_t *y;
-	int32_t z;
-	int idx;
-	int ch;
+	int32_t *s;
 	int i;
-	int nch = dev->params.channels;
+	int j;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = buffer_read_frag_s32(source, idx);
-			y = buffer_write_frag_s32(sink, idx);
-			z = iir_df2t(filter, *x << 8);
-			*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
-			idx += nch;
+	for (i = 0; i < frames; i++) {
+		for (j = 0; j < lanes; j++) {
+			s = buffer_read_frag_s32(source, idx + j);
+			*x++ = *s;
 		}
+		idx += nch;
 	}
 }
 
-static void eq_iir_s32_default(struct comp_dev *dev,
-			       struct comp_buffer *source,
-			       struct comp_buffer *sink,
-			       uint32_t frames)
+static void eq_iir_write_s16(struct comp_buffer *sink, int32_t *y, int idx,
+			     int nch, int lanes, int frames)
+{
+	int16_t *d;
+	int i;
+	int j;
+
+	for (i = 0; i < frames; i++) {
+		for (j = 0; j < lanes; j++) {
+			d = buffer_write_frag_s16(sink, idx + j);
+			*d = sat_int16(Q_SHIFT_RND(*y++, 31, 15));
+		}
+		idx += nch;
+	}
+}
 
+static void eq_iir_write_s24(struct comp_buffer *sink, int32_t *y, int idx,
+			     int nch, int lanes, int frames)
 {
-	struct comp_data *cd = comp_get_drvdata(dev);
-	struct iir_state_df2t *filter;
-	int32_t *x;
-	int32_t *y;
-	int idx;
-	int ch;
+	int32_t *d;
 	int i;
-	int nch = dev->params.channels;
+	int j;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = buffer_read_frag_s32(source, idx);
-			y = buffer_write_frag_s32(sink, idx);
-			*y = iir_df2t(filter, *x);
-			idx += nch;
+	for (i = 0; i < frames; i++) {
+		for (j = 0; j < lanes; j++) {
+			d = buffer_write_frag_s32(sink, idx + j);
+			*d = sat_int24(Q_SHIFT_RND(*y++, 31, 23));
 		}
+		idx += nch;
 	}
 }
 
-static void eq_iir_s32_16_default(struct comp_dev *dev,
-				  struct comp_buffer *source,
-				  struct comp_buffer *sink,
-				  uint32_t frames)
+static void eq_iir_write_s32(struct comp_buffer *sink, int32_t *y, int idx,
+			     int nch, int lanes, int frames)
+{
+	int32_t *d;
+	int i;
+	int j;
 
+	for (i = 0; i < frames; i++) {
+		for (j = 0; j < lanes; j++) {
+			d = buffer_write_frag_s32(sink, idx + j);
+			*d = *y++;
+		}
+		idx += nch;
+	}
+}
+
+/* Run the filters in blocks of IIR_BLOCK_SIZE frames. The channels that
+ * were grouped in setup are filtered in lockstep.
+ */
+static void eq_iir_run(struct comp_dev *dev, struct comp_buffer *source,
+		       struct comp_buffer *sink, uint32_t frames,
+		       eq_iir_read read, eq_iir_write write)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	struct iir_state_df2t *filter;
-	int32_t *x;
-	int16_t *y;
-	int32_t z;
+	int nch = dev->params.channels;
+	int lanes;
 	int idx;
 	int ch;
 	int i;
-	int nch = dev->params.channels;
-
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = buffer_read_frag_s32(source, idx);
-			y = buffer_write_frag_s16(sink, idx);
-			z = iir_df2t(filter, *x);
-			*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
-			idx += nch;
+	int n;
+
+	for (ch = 0; ch < nch; ch += lanes) {
+		lanes = cd->lanes[ch];
+		for (i = 0; i < frames; i += n) {
+			n = MIN((int)frames - i, IIR_BLOCK_SIZE);
+			idx = i * nch + ch;
+			read(source, cd->block_x, idx, nch, lanes, n);
+			iir_df2t_block(&cd->iir[ch], lanes, cd->block_x,
+				       cd->block_y, cd->block_w, n);
+			write(sink, cd->block_y, idx, nch, lanes, n);
 		}
 	}
 }
 
-static void eq_iir_s32_24_default(struct comp_dev *dev,
+static void eq_iir_s16_default(struct comp_dev *dev,
+			       struct comp_buffer *source,
+			       struct comp_buffer *sink,
+			       uint32_t frames)
+{
+	eq_iir_run(dev, source, sink, frames, eq_iir_read_s16,
+		   eq_iir_write_s16);
+}
+
+static void eq_iir_s24_default(struct comp_dev *dev,
+			       struct comp_buffer *source,
+			       struct comp_buffer *sink,
+			       uint32_t frames)
+{
+	eq_iir_run(dev, source, sink, frames, eq_iir_read_s24,
+		   eq_iir_write_s24);
+}
+
+static void eq_iir_s32_default(struct comp_dev *dev,
+			       struct comp_buffer *source,
+			       struct comp_buffer *sink,
+			       uint32_t frames)
+{
+	eq_iir_run(dev, source, sink, frames, eq_iir_read_s32,
+		   eq_iir_write_s32);
+}
+
+static void eq_iir_s32_16_default(struct comp_dev *dev,
 				  struct comp_buffer *source,
 				  struct comp_buffer *sink,
 				  uint32_t frames)
-
 {
-	struct comp_data *cd = comp_get_drvdata(dev);
-	struct iir_state_df2t *filter;
-	int32_t *x;
-	int32_t *y;
-	int32_t z;
-	int idx;
-	int ch;
-	int i;
-	int nch = dev->params.channels;
+	eq_iir_run(dev, source, sink, frames, eq_iir_read_s32,
+		   eq_iir_write_s16);
+}
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = buffer_read_frag_s32(source, idx);
-			y = buffer_write_frag_s32(sink, idx);
-			z = iir_df2t(filter, *x);
-			*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
-			idx += nch;
-		}
-	}
+static void eq_iir_s32_24_default(struct comp_dev *dev,
+				  struct comp_buffer *source,
+				  struct comp_buffer *sink,
+				  uint32_t frames)
+{
+	eq_iir_run(dev, source, sink, frames, eq_iir_read_s32,
+		   eq_iir_write_s24);
 }
 
 static void eq_iir_s16_pass(struct comp_dev *dev,
@@ -332,22 +373,25 @@ static void eq_iir_free_parameters(struct sof_eq_iir_config **config)
 	*config = NULL;
 }
 
-static void eq_iir_free_delaylines(struct comp_data *cd)
+static void eq_iir_free_delaylines(struct comp_dev *dev)
 {
+	struct comp_data *cd = comp_get_drvdata(dev);
 	struct iir_state_df2t *iir = cd->iir;
 	int i = 0;
 
 	/* Free the common buffer for all EQs and point then
 	 * each IIR channel delay line to NULL.
 	 */
-	rfree(cd->iir_delay);
+	comp_arena_free(dev, cd->iir_delay);
+	cd->iir_delay = NULL;
 	cd->iir_delay_size = 0;
 	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
 		iir[i].delay = NULL;
 }
 
-static int eq_iir_setup(struct comp_data *cd, int nch)
+static int eq_iir_setup(struct comp_dev *dev, int nch)
 {
+	struct comp_data *cd = comp_get_drvdata(dev);
 	struct iir_state_df2t *iir = cd->iir;
 	struct sof_eq_iir_config *config = cd->config;
 	struct sof_eq_iir_header_df2t *lookup[SOF_EQ_IIR_MAX_RESPONSES];
@@ -361,7 +405,7 @@ static int eq_iir_setup(struct comp_data *cd, int nch)
 	int resp;
 
 	/* Free existing IIR channels data if it was allocated */
-	eq_iir_free_delaylines(cd);
+	eq_iir_free_delaylines(dev);
 
 	trace_eq("eq_iir_setup(), "
 		 "channels_in_config = %u, number_of_responses = %u",
@@ -434,6 +478,10 @@ static int eq_iir_setup(struct comp_data *cd, int nch)
 			 "ch = %d initialized to response = %d", i, resp);
 	}
 
+	/* Group the channels that can be filtered in lockstep */
+	for (i = 0; i < nch; i += cd->lanes[i])
+		cd->lanes[i] = iir_df2t_lanes(&iir[i], nch - i);
+
 	/* If all channels were set to bypass there's no need to
 	 * allocate delay. Just return with success.
 	 */
@@ -442,12 +490,10 @@ static int eq_iir_setup(struct comp_data *cd, int nch)
 	if (!size_sum)
 		return 0;
 	/* Allocate all IIR channels data in a big chunk and clear it */
-	cd->iir_delay = rzalloc(RZONE_RUNTIME, SOF_MEM_CAPS_RAM, size_sum);
+	cd->iir_delay = comp_arena_alloc(dev, size_sum);
 	if (!cd->iir_delay)
 		return -ENOMEM;
 
-	memset(cd->iir_delay, 0, size_sum);
-
 	/* Initialize 2nd phase to set EQ delay lines pointers */
 	iir_delay = cd->iir_delay;
 	for (i = 0; i < nch; i++) {
@@ -546,8 +592,10 @@ static struct comp_dev *eq_iir_new(struct sof_ipc_comp *comp)
 		return NULL;
 	}
 
-	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
+	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++) {
 		iir_reset_df2t(&cd->iir[i]);
+		cd->lanes[i] = 1;
+	}
 
 	dev->state = COMP_STATE_READY;
 	return dev;
@@ -559,7 +607,7 @@ static void eq_iir_free(struct comp_dev *dev)
 
 	trace_eq("eq_iir_free()");
 
-	eq_iir_free_delaylines(cd);
+	eq_iir_free_delaylines(dev);
 	eq_iir_free_parameters(&cd->config);
 
 	rfree(cd);
@@ -668,9 +716,6 @@ static int iir_cmd_set_data(struct comp_dev *dev,
 			return -EBUSY;
 		}
 
-		/* Check and free old config */
-		eq_iir_free_parameters(&cd->config);
-
 		/* Copy new config, find size from header */
 		cfg = (struct sof_eq_iir_config *)cdata->data->data;
 		bs = cfg->size;
@@ -678,17 +723,21 @@ static int iir_cmd_set_data(struct comp_dev *dev,
 		if (bs > SOF_EQ_IIR_MAX_SIZE || bs == 0) {
 			trace_eq_error("iir_cmd_set_data() error: "
 				       "invalid blob size");
+			eq_iir_free_parameters(&cd->config);
 			return -EINVAL;
 		}
 
-		/* Allocate and make a copy of the blob and setup IIR */
-		cd->config = rzalloc(RZONE_RUNTIME, SOF_MEM_CAPS_RAM, bs);
-		if (!cd->config) {
+		/* Reuse old config memory for copy of the blob */
+		cfg = rrealloc(cd->config, RZONE_RUNTIME, SOF_MEM_CAPS_RAM, bs);
+		if (!cfg) {
 			trace_eq_error("iir_cmd_set_data() error: "
 				       "alloc failed");
+			eq_iir_free_parameters(&cd->config);
 			return -EINVAL;
 		}
 
+		cd->config = cfg;
+
 		/* Just copy the configurate. The EQ will be initialized in
 		 * prepare().
 		 */
@@ -760,8 +809,18 @@ static int eq_iir_copy(struct comp_dev *dev)
 	cd->eq_iir_func(dev, cl.source, cl.sink, cl.frames);
 
 	/* calc new free and available */
-	comp_update_buffer_consume(cl.source, cl.source_bytes);
 	comp_update_buffer_produce(cl.sink, cl.sink_bytes);
+	comp_update_buffer_consume(cl.source, cl.source_bytes);
+
+	return 0;
+}
+
+static int eq_iir_process(struct comp_dev *dev, struct comp_buffer *source,
+			  struct comp_buffer *sink, uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+
+	cd->eq_iir_func(dev, source, sink, frames);
 
 	return 0;
 }
@@ -818,7 +877,7 @@ static int eq_iir_prepare(struct comp_dev *dev)
 	trace_eq("eq_iir_prepare(), source_format=%d, sink_format=%d",
 		 cd->source_format, cd->sink_format);
 	if (cd->config) {
-		ret = eq_iir_setup(cd, dev->params.channels);
+		ret = eq_iir_setup(dev, dev->params.channels);
 		if (ret < 0) {
 			trace_eq_error("eq_iir_prepare() error: "
 				       "eq_iir_setup failed.");
@@ -862,11 +921,13 @@ static int eq_iir_reset(struct comp_dev *dev)
 
 	trace_eq("eq_iir_reset()");
 
-	eq_iir_free_delaylines(cd);
+	eq_iir_free_delaylines(dev);
 
 	cd->eq_iir_func = eq_iir_s32_default;
-	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
+	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++) {
 		iir_reset_df2t(&cd->iir[i]);
+		cd->lanes[i] = 1;
+	}
 
 	comp_set_state(dev, COMP_TRIGGER_RESET);
 	return 0;
@@ -917,6 +978,7 @@ static void eq_iir_cache(struct comp_dev *dev, int cmd)
 
 struct comp_driver comp_eq_iir = {
 	.type = SOF_COMP_EQ_IIR,
+	.flags = COMP_DRV_INPLACE,
 	.ops = {
 		.new = eq_iir_new,
 		.free = eq_iir_free,
@@ -924,6 +986,7 @@ struct comp_driver comp_eq_iir = {
 		.cmd = eq_iir_cmd,
 		.trigger = eq_iir_trigger,
 		.copy = eq_iir_copy,
+		.process = eq_iir_process,
 		.prepare = eq_iir_prepare,
 		.reset = eq_iir_reset,
 		.cache = eq_iir_cache,
@@ -72,13 +72,98 @@ size_t fir_init_coef(struct fir_state_32x16 *fir,
 	if (fir->length > SOF_EQ_FIR_MAX_LENGTH || fir->length < 1)
 		return -EINVAL;
 
-	return fir->length * sizeof(int32_t);
+	/* The linearized delay line holds two copies of the samples */
+	return 2 * fir->length * sizeof(int32_t);
 }
 
 void fir_init_delay(struct fir_state_32x16 *fir, int32_t **data)
 {
 	fir->delay = *data;
-	*data += fir->length; /* Point to next delay line start */
+	*data += 2 * fir->length; /* Point to next delay line start */
+}
+
+/* Process n samples of one channel, FIR_BLOCK samples at a time when
+ * the delay line write index allows it and one at a time otherwise.
+ */
+static void fir_run_s16(struct fir_state_32x16 *filter, int16_t *x,
+			int16_t *y, int n, int nch)
+{
+	int32_t in[FIR_BLOCK];
+	int32_t out[FIR_BLOCK];
+	int32_t z;
+	int i = 0;
+	int j;
+
+	while (i < n) {
+		if (n - i >= FIR_BLOCK && fir_32x16_block_fits(filter)) {
+			for (j = 0; j < FIR_BLOCK; j++)
+				in[j] = x[(i + j) * nch] << 16;
+
+			fir_32x16_block(filter, in, out);
+			for (j = 0; j < FIR_BLOCK; j++)
+				y[(i + j) * nch] =
+					sat_int16(Q_SHIFT_RND(out[j], 31, 15));
+
+			i += FIR_BLOCK;
+		} else {
+			z = fir_32x16(filter, x[i * nch] << 16);
+			y[i * nch] = sat_int16(Q_SHIFT_RND(z, 31, 15));
+			i++;
+		}
+	}
+}
+
+static void fir_run_s24(struct fir_state_32x16 *filter, int32_t *x,
+			int32_t *y, int n, int nch)
+{
+	int32_t in[FIR_BLOCK];
+	int32_t out[FIR_BLOCK];
+	int32_t z;
+	int i = 0;
+	int j;
+
+	while (i < n) {
+		if (n - i >= FIR_BLOCK && fir_32x16_block_fits(filter)) {
+			for (j = 0; j < FIR_BLOCK; j++)
+				in[j] = x[(i + j) * nch] << 8;
+
+			fir_32x16_block(filter, in, out);
+			for (j = 0; j < FIR_BLOCK; j++)
+				y[(i + j) * nch] =
+					sat_int24(Q_SHIFT_RND(out[j], 31, 23));
+
+			i += FIR_BLOCK;
+		} else {
+			z = fir_32x16(filter, x[i * nch] << 8);
+			y[i * nch] = sat_int24(Q_SHIFT_RND(z, 31, 23));
+			i++;
+		}
+	}
+}
+
+static void fir_run_s32(struct fir_state_32x16 *filter, int32_t *x,
+			int32_t *y, int n, int nch)
+{
+	int32_t in[FIR_BLOCK];
+	int32_t out[FIR_BLOCK];
+	int i = 0;
+	int j;
+
+	while (i < n) {
+		if (n - i >= FIR_BLOCK && fir_32x16_block_fits(filter)) {
+			for (j = 0; j < FIR_BLOCK; j++)
+				in[j] = x[(i + j) * nch];
+
+			fir_32x16_block(filter, in, out);
+			for (j = 0; j < FIR_BLOCK; j++)
+				y[(i + j) * nch] = out[j];
+
+			i += FIR_BLOCK;
+		} else {
+			y[i * nch] = fir_32x16(filter, x[i * nch]);
+			i++;
+		}
+	}
 }
 
 void eq_fir_s16(struct fir_state_32x16 fir[], struct comp_buffer *source,
@@ -87,20 +172,25 @@ void eq_fir_s16(struct fir_state_32x16 fir[], struct comp_buffer *source,
 	struct fir_state_32x16 *filter;
 	int16_t *x;
 	int16_t *y;
-	int32_t z;
-	int idx;
+	int remaining;
 	int ch;
-	int i;
+	int n;
 
 	for (ch = 0; ch < nch; ch++) {
 		filter = &fir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = buffer_read_frag_s16(source, idx);
-			y = buffer_write_frag_s16(sink, idx);
-			z = fir_32x16(filter, *x << 16);
-			*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
-			idx += nch;
+		x = buffer_read_frag_s16(source, ch);
+		y = buffer_write_frag_s16(sink, ch);
+		remaining = frames;
+		while (remaining) {
+			/* channel samples until source or sink wraps */
+			n = MIN(buffer_samples_without_wrap_s16(source, x),
+				buffer_samples_without_wrap_s16(sink, y));
+			n = MIN((n + nch - 1) / nch, remaining);
+			fir_run_s16(filter, x, y, n, nch);
+
+			remaining -= n;
+			x = buffer_wrap(source, x + n * nch);
+			y = buffer_wrap(sink, y + n * nch);
 		}
 	}
 }
@@ -111,20 +201,25 @@ void eq_fir_s24(struct fir_state_32x16 fir[], struct comp_buffer *source,
 	struct fir_state_32x16 *filter;
 	int32_t *x;
 	int32_t *y;
-	int32_t z;
-	int idx;
+	int remaining;
 	int ch;
-	int i;
+	int n;
 
 	for (ch = 0; ch < nch; ch++) {
 		filter = &fir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = buffer_read_frag_s32(source, idx);
-			y = buffer_write_frag_s32(sink, idx);
-			z = fir_32x16(filter, *x << 8);
-			*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
-			idx += nch;
+		x = buffer_read_frag_s32(source, ch);
+		y = buffer_write_frag_s32(sink, ch);
+		remaining = frames;
+		while (remaining) {
+			/* channel samples until source or sink wraps */
+			n = MIN(buffer_samples_without_wrap_s32(source, x),
+				buffer_samples_without_wrap_s32(sink, y));
+			n = MIN((n + nch - 1) / nch, remaining);
+			fir_run_s24(filter, x, y, n, nch);
+
+			remaining -= n;
+			x = buffer_wrap(source, x + n * nch);
+			y = buffer_wrap(sink, y + n * nch);
 		}
 	}
 }
@@ -135,18 +230,25 @@ void eq_fir_s32(struct fir_state_32x16 fir[], struct comp_buffer *source,
 	struct fir_state_32x16 *filter;
 	int32_t *x;
 	int32_t *y;
-	int idx;
+	int remaining;
 	int ch;
-	int i;
+	int n;
 
 	for (ch = 0; ch < nch; ch++) {
 		filter = &fir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = buffer_read_frag_s32(source, idx);
-			y = buffer_write_frag_s32(sink, idx);
-			*y = fir_32x16(filter, *x);
-			idx += nch;
+		x = buffer_read_frag_s32(source, ch);
+		y = buffer_write_frag_s32(sink, ch);
+		remaining = frames;
+		while (remaining) {
+			/* channel samples until source or sink wraps */
+			n = MIN(buffer_samples_without_wrap_s32(source, x),
+				buffer_samples_without_wrap_s32(sink, y));
+			n = MIN((n + nch - 1) / nch, remaining);
+			fir_run_s32(filter, x, y, n, nch);
+
+			remaining -= n;
+			x = buffer_wrap(source, x + n * nch);
+			y = buffer_wrap(sink, y + n * nch);
 		}
 	}
 }
@@ -40,13 +40,16 @@
 #include <sof/audio/format.h>
 
 struct fir_state_32x16 {
-	int rwi; /* Circular read and write index */
+	int rwi; /* Write index to lower half of delay line */
 	int length; /* Number of FIR taps */
 	int out_shift; /* Amount of right shifts at output */
 	int16_t *coef; /* Pointer to FIR coefficients */
-	int32_t *delay; /* Pointer to FIR delay line */
+	int32_t *delay; /* Pointer to FIR delay line, 2 x length samples */
 };
 
+/* Number of outputs computed per pass over the coefficients */
+#define FIR_BLOCK	4
+
 void fir_reset(struct fir_state_32x16 *fir);
 
 size_t fir_init_coef(struct fir_state_32x16 *fir,
@@ -63,64 +66,126 @@ void eq_fir_s24(struct fir_state_32x16 *fir, struct comp_buffer *source,
 void eq_fir_s32(struct fir_state_32x16 *fir, struct comp_buffer *source,
 		struct comp_buffer *sink, int frames, int nch);
 
-/* The next functions are inlined to optmize execution speed */
+/* The next functions are inlined to optmize execution speed.
+ *
+ * The delay line is linearized by storing every sample twice, at rwi and
+ * at rwi + length. The latest length samples are then always found in
+ * one contiguous run ending at delay[rwi + length] and the dot product
+ * needs no circular wrap handling. The upper copy is written before the
+ * outputs are computed and the lower copy after it, so a block of new
+ * samples does not overwrite the oldest samples still needed by the
+ * first outputs of the block.
+ */
 
-static inline void fir_part_32x16(int64_t *y, int taps, const int16_t c[],
-				  int *ic, int32_t d[], int *id)
+static inline void fir_32x16_commit(struct fir_state_32x16 *fir,
+				    const int32_t x[], int n)
 {
-	int n;
+	int i;
 
-	/* Data is Q8.24, coef is Q1.15, product is Q9.39 */
-	for (n = 0; n < taps; n++) {
-		*y += (int64_t)c[*ic] * d[*id];
-		(*ic)++;
-		(*id)--;
-	}
+	for (i = 0; i < n; i++)
+		fir->delay[fir->rwi + i] = x[i];
+
+	fir->rwi += n;
+	if (fir->rwi == fir->length)
+		fir->rwi = 0;
 }
 
 static inline int32_t fir_32x16(struct fir_state_32x16 *fir, int32_t x)
 {
+	const int16_t *c = fir->coef;
+	int32_t *d;
 	int64_t y = 0;
-	int n1;
-	int n2;
-	int i = 0; /* Start from 1st tap */
-	int tmp_ri;
+	int i;
 
 	/* Bypass is set with length set to zero. */
 	if (!fir->length)
 		return x;
 
-	/* Write sample to delay */
-	fir->delay[fir->rwi] = x;
+	/* Point to newest sample in the upper copy */
+	d = &fir->delay[fir->rwi + fir->length];
+	*d = x;
+
+	/* Data is Q8.24, coef is Q1.15, product is Q9.39 */
+	for (i = 0; i < fir->length; i++)
+		y += (int64_t)c[i] * d[-i];
+
+	fir_32x16_commit(fir, &x, 1);
 
-	/* Start FIR calculation. Calculate first number of taps possible to
-	 * calculate before circular wrap need.
+	/* Q9.39 -> Q9.24, saturate to Q8.24 */
+	return sat_int32(y >> (15 + fir->out_shift));
+}
+
+/* Returns true when the next FIR_BLOCK samples fit in the lower half of
+ * the delay line without a wrap in the write index.
+ */
+static inline int fir_32x16_block_fits(struct fir_state_32x16 *fir)
+{
+	return fir->length && fir->rwi + FIR_BLOCK <= fir->length;
+}
+
+static inline void fir_32x16_block(struct fir_state_32x16 *fir,
+				   const int32_t x[FIR_BLOCK],
+				   int32_t y[FIR_BLOCK])
+{
+	const int16_t *c = fir->coef;
+	int32_t *d;
+	int32_t *p;
+	int64_t y0 = 0;
+	int64_t y1 = 0;
+	int64_t y2 = 0;
+	int64_t y3 = 0;
+	int32_t d0;
+	int32_t d1;
+	int32_t d2;
+	int32_t d3;
+	int32_t dm;
+	int16_t c0;
+	int16_t c1;
+	int shift = 15 + fir->out_shift;
+	int i;
+
+	/* Point to newest sample of first output in the upper copy */
+	d = &fir->delay[fir->rwi + fir->length];
+	d[0] = x[0];
+	d[1] = x[1];
+	d[2] = x[2];
+	d[3] = x[3];
+
+	/* Four outputs share each pair of coefficients and five data
+	 * samples. Output j accumulates c[i] * d[j - i].
 	 */
-	n1 = fir->rwi + 1;
-	/* Point to newest sample and advance read index */
-	tmp_ri = (fir->rwi)++;
-	if (fir->rwi == fir->length)
-		fir->rwi = 0;
+	for (i = 0; i + 1 < fir->length; i += 2) {
+		c0 = c[i];
+		c1 = c[i + 1];
+		p = d - i;
+		dm = p[-1];
+		d0 = p[0];
+		d1 = p[1];
+		d2 = p[2];
+		d3 = p[3];
+		y0 += (int64_t)c0 * d0 + (int64_t)c1 * dm;
+		y1 += (int64_t)c0 * d1 + (int64_t)c1 * d0;
+		y2 += (int64_t)c0 * d2 + (int64_t)c1 * d1;
+		y3 += (int64_t)c0 * d3 + (int64_t)c1 * d2;
+	}
 
-	if (n1 > fir->length) {
-		/* No need to un-wrap fir read index, make sure ri
-		 * is >= 0 after FIR computation.
-		 */
-		fir_part_32x16(&y, fir->length, fir->coef, &i, fir->delay,
-			       &tmp_ri);
-	} else {
-		n2 = fir->length - n1;
-		/* Part 1, loop n1 times, fir_ri becomes -1 */
-		fir_part_32x16(&y, n1, fir->coef, &i, fir->delay, &tmp_ri);
-
-		/* Part 2, unwrap fir_ri, continue rest of filter */
-		tmp_ri = fir->length - 1;
-		fir_part_32x16(&y, n2, fir->coef, &i, fir->delay, &tmp_ri);
+	/* Odd number of taps */
+	if (i < fir->length) {
+		c0 = c[i];
+		p = d - i;
+		y0 += (int64_t)c0 * p[0];
+		y1 += (int64_t)c0 * p[1];
+		y2 += (int64_t)c0 * p[2];
+		y3 += (int64_t)c0 * p[3];
 	}
-	/* Q9.39 -> Q9.24, saturate to Q8.24 */
-	y = sat_int32(y >> (15 + fir->out_shift));
 
-	return (int32_t)y;
+	fir_32x16_commit(fir, x, FIR_BLOCK);
+
+	/* Q9.39 -> Q9.24, saturate to Q8.24 */
+	y[0] = sat_int32(y0 >> shift);
+	y[1] = sat_int32(y1 >> shift);
+	y[2] = sat_int32(y2 >> shift);
+	y[3] = sat_int32(y3 >> shift);
 }
 
 #endif
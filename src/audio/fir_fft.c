@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sof/audio/component.h>
+#include <sof/audio/format.h>
+#include <sof/math/numbers.h>
+#include <sof/math/fft.h>
+#include <uapi/user/eq.h>
+#include "fir_fft.h"
+
+/* Right shift of the 64 bit spectrum products before accumulation. It
+ * keeps 15 fractional bits more than Q1.31 for quiet input.
+ */
+#define FIR_FFT_ACC_SHIFT	16
+
+/* Number of int32_t words the filter needs from the delay line chunk. One
+ * word is reserved for aligning the 64 bit accumulator.
+ */
+static int fir_fft_words(struct fir_fft_state *fft)
+{
+	int bins = fft->block + 1;
+
+	/* delay only */
+	if (!fft->partitions)
+		return fft->block;
+
+	return 3 * fft->block + /* in, out */
+		4 * bins + 1 + /* acc */
+		4 * fft->block + /* buf */
+		4 * fft->partitions * bins; /* coef_fd, fdl */
+}
+
+void fir_fft_reset(struct fir_fft_state *fft)
+{
+	fft->block = 0;
+	fft->block_bits = 0;
+	fft->partitions = 0;
+	fft->length = 0;
+	fft->out_shift = 0;
+	fft->pos = 0;
+	fft->fdl_idx = 0;
+	fft->coef = NULL;
+	fft->in = NULL;
+	fft->out = NULL;
+	fft->acc = NULL;
+	fft->buf = NULL;
+	fft->coef_fd = NULL;
+	fft->fdl = NULL;
+}
+
+int fir_fft_init_coef(struct fir_fft_state *fft,
+		      struct sof_eq_fir_coef_data *config, int frames)
+{
+	fir_fft_reset(fft);
+	fft->length = (int)config->length;
+	fft->out_shift = (int)config->out_shift;
+	fft->coef = &config->coef[0];
+
+	if (fft->length > FIR_FFT_MAX_LENGTH || fft->length < 1)
+		return -EINVAL;
+
+	/* The partition is the largest power of two that fits in a period
+	 * so the added delay does not exceed one period.
+	 */
+	fft->block = 1;
+	while (2 * fft->block <= frames &&
+	       2 * fft->block <= FIR_FFT_BLOCK_MAX) {
+		fft->block <<= 1;
+		fft->block_bits++;
+	}
+
+	fft->partitions = ceil_divide(fft->length, fft->block);
+	fft->fdl_idx = fft->partitions - 1;
+
+	return fir_fft_words(fft) * sizeof(int32_t);
+}
+
+/* Sets up a channel without FFT filter to be delayed by the block of
+ * the FFT channels, so that all channels stay aligned. Returns the delay
+ * line size in bytes.
+ */
+int fir_fft_init_align(struct fir_fft_state *fft, int block)
+{
+	fir_fft_reset(fft);
+	fft->block = block;
+
+	return fir_fft_words(fft) * sizeof(int32_t);
+}
+
+void fir_fft_init_delay(struct fir_fft_state *fft, int32_t **data)
+{
+	struct icomplex32 *buf;
+	struct icomplex32 *h;
+	int32_t *p = *data;
+	int block = fft->block;
+	int bins = block + 1;
+	int size = 2 * block;
+	int n;
+	int i;
+	int k;
+
+	if (!fft->partitions) {
+		fft->out = p;
+		*data += fir_fft_words(fft);
+		return;
+	}
+
+	if ((uintptr_t)p & (sizeof(int64_t) - 1))
+		p++;
+
+	fft->acc = (int64_t *)p;
+	p += 4 * bins;
+	fft->buf = (struct icomplex32 *)p;
+	p += 2 * size;
+	fft->coef_fd = (struct icomplex32 *)p;
+	p += 2 * fft->partitions * bins;
+	fft->fdl = (struct icomplex32 *)p;
+	p += 2 * fft->partitions * bins;
+	fft->in = p;
+	p += size;
+	fft->out = p;
+
+	*data += fir_fft_words(fft); /* Point to next delay line start */
+
+	/* Compute spectrum of each zero padded partition of response */
+	buf = fft->buf;
+	for (i = 0; i < fft->partitions; i++) {
+		n = MIN(block, fft->length - i * block);
+		memset(buf, 0, size * sizeof(*buf));
+		for (k = 0; k < n; k++)
+			buf[k].real = (int32_t)fft->coef[i * block + k] << 16;
+
+		fft_32(buf, size, 0);
+
+		/* The FFT output is DFT divided by size, store as DFT divided
+		 * by block. The magnitude can't exceed one.
+		 */
+		h = &fft->coef_fd[i * bins];
+		for (k = 0; k < bins; k++) {
+			h[k].real = sat_int32((int64_t)buf[k].real << 1);
+			h[k].imag = sat_int32((int64_t)buf[k].imag << 1);
+		}
+	}
+}
+
+void fir_fft_block(struct fir_fft_state *fft)
+{
+	struct icomplex32 *buf = fft->buf;
+	struct icomplex32 *x;
+	struct icomplex32 *h;
+	int64_t *acc = fft->acc;
+	int64_t peak = 0;
+	int64_t re;
+	int64_t y;
+	int64_t im;
+	int block = fft->block;
+	int bins = block + 1;
+	int size = 2 * block;
+	int shift;
+	int idx;
+	int s;
+	int i;
+	int k;
+
+	/* Spectrum of previous and current input blocks, the FFT output is
+	 * DFT divided by size.
+	 */
+	for (i = 0; i < size; i++) {
+		buf[i].real = fft->in[i];
+		buf[i].imag = 0;
+	}
+
+	fft_32(buf, size, 0);
+
+	/* Only the bins up to Nyquist are stored since input is real */
+	fft->fdl_idx++;
+	if (fft->fdl_idx == fft->partitions)
+		fft->fdl_idx = 0;
+
+	memcpy(&fft->fdl[fft->fdl_idx * bins], buf, bins * sizeof(*buf));
+	memcpy(fft->in, &fft->in[block], block * sizeof(int32_t));
+
+	/* Multiply and accumulate newest input spectrum with first response
+	 * partition, previous with second partition, etc.
+	 */
+	for (k = 0; k < bins; k++) {
+		re = 0;
+		im = 0;
+		idx = fft->fdl_idx;
+		for (i = 0; i < fft->partitions; i++) {
+			x = &fft->fdl[idx * bins + k];
+			h = &fft->coef_fd[i * bins + k];
+			re += ((int64_t)x->real * h->real -
+			       (int64_t)x->imag * h->imag) >> FIR_FFT_ACC_SHIFT;
+			im += ((int64_t)x->real * h->imag +
+			       (int64_t)x->imag * h->real) >> FIR_FFT_ACC_SHIFT;
+			if (--idx < 0)
+				idx = fft->partitions - 1;
+		}
+
+		acc[2 * k] = re;
+		acc[2 * k + 1] = im;
+		peak |= (re < 0 ? -re : re) | (im < 0 ? -im : im);
+	}
+
+	if (!peak) {
+		memset(fft->out, 0, block * sizeof(int32_t));
+		return;
+	}
+
+	/* Normalize the spectrum to 30 bits for the inverse FFT */
+	for (s = -30; peak >> (s + 30); s++)
+		;
+
+	for (k = 0; k < bins; k++) {
+		if (s >= 0) {
+			buf[k].real = acc[2 * k] >> s;
+			buf[k].imag = acc[2 * k + 1] >> s;
+		} else {
+			buf[k].real = acc[2 * k] << -s;
+			buf[k].imag = acc[2 * k + 1] << -s;
+		}
+	}
+
+	/* Conjugate symmetric upper half for real output */
+	for (k = 1; k < block; k++) {
+		buf[size - k].real = buf[k].real;
+		buf[size - k].imag = -buf[k].imag;
+	}
+
+	fft_32(buf, size, 1);
+
+	/* The last block samples are the valid linear convolution. Undo the
+	 * 1 / size and 1 / block scaling of spectra, the accumulator and
+	 * normalize shifts, and apply the response output shift.
+	 */
+	shift = 2 * fft->block_bits + 1 + FIR_FFT_ACC_SHIFT - 31 + s -
+		fft->out_shift;
+	shift = MIN(shift, 32);
+	for (i = 0; i < block; i++) {
+		y = buf[block + i].real;
+		if (shift >= 0)
+			y <<= shift;
+		else
+			y = Q_SHIFT_RND(y, -shift, 0);
+
+		fft->out[i] = sat_int32(y);
+	}
+}
+
+/* Filter n samples of a channel from x to y. A channel without FFT filter
+ * only delays the direct form output already in y.
+ */
+static void fir_fft_span_s16(struct fir_fft_state *fft, int16_t *x,
+			     int16_t *y, int n, int nch)
+{
+	int32_t z;
+	int i;
+
+	if (!fft->partitions) {
+		for (i = 0; i < n; i++)
+			y[i * nch] = fir_fft_align_32(fft, y[i * nch]);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		z = fir_fft_32(fft, x[i * nch] << 16);
+		y[i * nch] = sat_int16(Q_SHIFT_RND(z, 31, 15));
+	}
+}
+
+static void fir_fft_span_s24(struct fir_fft_state *fft, int32_t *x,
+			     int32_t *y, int n, int nch)
+{
+	int32_t z;
+	int i;
+
+	if (!fft->partitions) {
+		for (i = 0; i < n; i++)
+			y[i * nch] = fir_fft_align_32(fft, y[i * nch]);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		z = fir_fft_32(fft, x[i * nch] << 8);
+		y[i * nch] = sat_int24(Q_SHIFT_RND(z, 31, 23));
+	}
+}
+
+static void fir_fft_span_s32(struct fir_fft_state *fft, int32_t *x,
+			     int32_t *y, int n, int nch)
+{
+	int i;
+
+	if (!fft->partitions) {
+		for (i = 0; i < n; i++)
+			y[i * nch] = fir_fft_align_32(fft, y[i * nch]);
+		return;
+	}
+
+	for (i = 0; i < n; i++)
+		y[i * nch] = fir_fft_32(fft, x[i * nch]);
+}
+
+void eq_fir_fft_s16(struct fir_fft_state fft[], struct comp_buffer *source,
+		    struct comp_buffer *sink, int frames, int nch)
+{
+	struct fir_fft_state *filter;
+	int16_t *x;
+	int16_t *y;
+	int remaining;
+	int ch;
+	int n;
+
+	for (ch = 0; ch < nch; ch++) {
+		filter = &fft[ch];
+		if (!filter->block)
+			continue;
+
+		x = buffer_read_frag_s16(source, ch);
+		y = buffer_write_frag_s16(sink, ch);
+		remaining = frames;
+		while (remaining) {
+			/* channel samples until source or sink wraps */
+			n = MIN(buffer_samples_without_wrap_s16(source, x),
+				buffer_samples_without_wrap_s16(sink, y));
+			n = MIN((n + nch - 1) / nch, remaining);
+			fir_fft_span_s16(filter, x, y, n, nch);
+
+			remaining -= n;
+			x = buffer_wrap(source, x + n * nch);
+			y = buffer_wrap(sink, y + n * nch);
+		}
+	}
+}
+
+void eq_fir_fft_s24(struct fir_fft_state fft[], struct comp_buffer *source,
+		    struct comp_buffer *sink, int frames, int nch)
+{
+	struct fir_fft_state *filter;
+	int32_t *x;
+	int32_t *y;
+	int remaining;
+	int ch;
+	int n;
+
+	for (ch = 0; ch < nch; ch++) {
+		filter = &fft[ch];
+		if (!filter->block)
+			continue;
+
+		x = buffer_read_frag_s32(source, ch);
+		y = buffer_write_frag_s32(sink, ch);
+		remaining = frames;
+		while (remaining) {
+			/* channel samples until source or sink wraps */
+			n = MIN(buffer_samples_without_wrap_s32(source, x),
+				buffer_samples_without_wrap_s32(sink, y));
+			n = MIN((n + nch - 1) / nch, remaining);
+			fir_fft_span_s24(filter, x, y, n, nch);
+
+			remaining -= n;
+			x = buffer_wrap(source, x + n * nch);
+			y = buffer_wrap(sink, y + n * nch);
+		}
+	}
+}
+
+void eq_fir_fft_s32(struct fir_fft_state fft[], struct comp_buffer *source,
+		    struct comp_buffer *sink, int frames, int nch)
+{
+	struct fir_fft_state *filter;
+	int32_t *x;
+	int32_t *y;
+	int remaining;
+	int ch;
+	int n;
+
+	for (ch = 0; ch < nch; ch++) {
+		filter = &fft[ch];
+		if (!filter->block)
+			continue;
+
+		x = buffer_read_frag_s32(source, ch);
+		y = buffer_write_frag_s32(sink, ch);
+		remaining = frames;
+		while (remaining) {
+			/* channel samples until source or sink wraps */
+			n = MIN(buffer_samples_without_wrap_s32(source, x),
+				buffer_samples_without_wrap_s32(sink, y));
+			n = MIN((n + nch - 1) / nch, remaining);
+			fir_fft_span_s32(filter, x, y, n, nch);
+
+			remaining -= n;
+			x = buffer_wrap(source, x + n * nch);
+			y = buffer_wrap(sink, y + n * nch);
+		}
+	}
+}
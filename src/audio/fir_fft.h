@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FIR_FFT_H
+#define FIR_FFT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sof/math/fft.h>
+#include <uapi/user/eq.h>
+
+struct comp_buffer;
+
+/* Largest partition length, the FFT size is twice the partition */
+#define FIR_FFT_BLOCK_MAX	(FFT_SIZE_MAX / 2)
+
+/* Max length for a response run with FFT convolution */
+#define FIR_FFT_MAX_LENGTH	2048
+
+/* Uniformly partitioned overlap-save FFT convolution for long responses.
+ * The response is split into partitions of block taps and the spectra of
+ * the latest input blocks are kept in a frequency domain delay line. The
+ * output is delayed by block samples. Other channels of the same stream
+ * are only delayed by block samples, partitions is zero for them.
+ */
+struct fir_fft_state {
+	int block; /* Partition length and hop size, power of two */
+	int block_bits; /* Base 2 logarithm of block */
+	int partitions; /* Number of partitions, zero if not in use */
+	int length; /* Number of FIR taps */
+	int out_shift; /* Amount of right shifts at output */
+	int pos; /* Sample index in current block */
+	int fdl_idx; /* Index of newest spectrum in delay line */
+	int16_t *coef; /* Pointer to FIR coefficients */
+	int32_t *in; /* Previous and current input block */
+	int32_t *out; /* Output of last processed block */
+	int64_t *acc; /* Spectrum accumulator, block + 1 bins */
+	struct icomplex32 *buf; /* FFT work buffer */
+	struct icomplex32 *coef_fd; /* Spectra of response partitions */
+	struct icomplex32 *fdl; /* Spectra of input blocks */
+};
+
+void fir_fft_reset(struct fir_fft_state *fft);
+
+int fir_fft_init_coef(struct fir_fft_state *fft,
+		      struct sof_eq_fir_coef_data *config, int frames);
+
+int fir_fft_init_align(struct fir_fft_state *fft, int block);
+
+void fir_fft_init_delay(struct fir_fft_state *fft, int32_t **data);
+
+void fir_fft_block(struct fir_fft_state *fft);
+
+void eq_fir_fft_s16(struct fir_fft_state *fft, struct comp_buffer *source,
+		    struct comp_buffer *sink, int frames, int nch);
+
+void eq_fir_fft_s24(struct fir_fft_state *fft, struct comp_buffer *source,
+		    struct comp_buffer *sink, int frames, int nch);
+
+void eq_fir_fft_s32(struct fir_fft_state *fft, struct comp_buffer *source,
+		    struct comp_buffer *sink, int frames, int nch);
+
+/* Returns the output of block samples ago and runs the convolution
+ * when a full block of input has been collected.
+ */
+static inline int32_t fir_fft_32(struct fir_fft_state *fft, int32_t x)
+{
+	int32_t y = fft->out[fft->pos];
+
+	fft->in[fft->block + fft->pos] = x;
+	if (++fft->pos == fft->block) {
+		fir_fft_block(fft);
+		fft->pos = 0;
+	}
+
+	return y;
+}
+
+/* Returns the sample of block samples ago */
+static inline int32_t fir_fft_align_32(struct fir_fft_state *fft, int32_t x)
+{
+	int32_t y = fft->out[fft->pos];
+
+	fft->out[fft->pos] = x;
+	if (++fft->pos == fft->block)
+		fft->pos = 0;
+
+	return y;
+}
+
+#endif
@@ -131,6 +131,253 @@ int32_t iir_df2t(struct iir_state_df2t *iir, int32_t x)
 	return out;
 }
 
+/* Block processing of a biquad section over all frames with coefficients
+ * and state kept in registers. The arithmetic is the same as in
+ * iir_df2t() so output is bit exact with it.
+ */
+static void iir_section_df2t(struct iir_state_df2t *iir, int c, int d,
+			     const int32_t *x, int32_t *y, int frames)
+{
+	const int32_t *coef = &iir->coef[c];
+	const int64_t a2 = coef[0];
+	const int64_t a1 = coef[1];
+	const int64_t b2 = coef[2];
+	const int64_t b1 = coef[3];
+	const int64_t b0 = coef[4];
+	const int shift = 45 + coef[5];
+	const int64_t gain = coef[6];
+	int64_t d0 = iir->delay[d];
+	int64_t d1 = iir->delay[d + 1];
+	int64_t acc;
+	int32_t tmp;
+	int32_t in;
+	int i;
+
+	for (i = 0; i < frames; i++) {
+		in = x[i];
+		acc = b0 * in + d0;
+		tmp = (int32_t)Q_SHIFT_RND(acc, 61, 31);
+		d0 = d1 + b1 * in + a1 * tmp;
+		d1 = b2 * in + a2 * tmp;
+		acc = gain * tmp;
+		y[i] = sat_int32(Q_SHIFT_RND(acc, shift, 31));
+	}
+
+	iir->delay[d] = d0;
+	iir->delay[d + 1] = d1;
+}
+
+/* The lockstep versions run the same section of two or four channels with
+ * their own coefficients in the lanes of GCC vector types. Samples are
+ * interleaved by channel.
+ */
+typedef int64_t iir_v2i64 __attribute__((vector_size(2 * sizeof(int64_t))));
+typedef int64_t iir_v4i64 __attribute__((vector_size(4 * sizeof(int64_t))));
+typedef uint64_t iir_v2u64 __attribute__((vector_size(2 * sizeof(int64_t))));
+typedef uint64_t iir_v4u64 __attribute__((vector_size(4 * sizeof(int64_t))));
+
+static inline void iir_sat_int32_2ch(iir_v2i64 *x)
+{
+	iir_v2i64 m;
+
+	m = *x > INT32_MAX;
+	*x = (*x & ~m) | (INT32_MAX & m);
+	m = *x < INT32_MIN;
+	*x = (*x & ~m) | ((int64_t)INT32_MIN & m);
+}
+
+static inline void iir_sat_int32_4ch(iir_v4i64 *x)
+{
+	iir_v4i64 m;
+
+	m = *x > INT32_MAX;
+	*x = (*x & ~m) | (INT32_MAX & m);
+	m = *x < INT32_MIN;
+	*x = (*x & ~m) | ((int64_t)INT32_MIN & m);
+}
+
+static void iir_section_df2t_2ch(struct iir_state_df2t *iir, int c, int d,
+				 const int32_t *x, int32_t *y, int frames)
+{
+	const iir_v2i64 a2 = { iir[0].coef[c], iir[1].coef[c] };
+	const iir_v2i64 a1 = { iir[0].coef[c + 1], iir[1].coef[c + 1] };
+	const iir_v2i64 b2 = { iir[0].coef[c + 2], iir[1].coef[c + 2] };
+	const iir_v2i64 b1 = { iir[0].coef[c + 3], iir[1].coef[c + 3] };
+	const iir_v2i64 b0 = { iir[0].coef[c + 4], iir[1].coef[c + 4] };
+	const iir_v2i64 shift = { 13 + iir[0].coef[c + 5],
+				  13 + iir[1].coef[c + 5] };
+	const iir_v2i64 gain = { iir[0].coef[c + 6], iir[1].coef[c + 6] };
+	iir_v2i64 d0 = { iir[0].delay[d], iir[1].delay[d] };
+	iir_v2i64 d1 = { iir[0].delay[d + 1], iir[1].delay[d + 1] };
+	iir_v2i64 acc;
+	iir_v2i64 tmp;
+	iir_v2i64 in;
+	int i;
+
+	for (i = 0; i < frames; i++) {
+		in = (iir_v2i64){ x[0], x[1] };
+		acc = b0 * in + d0;
+
+		/* Q3.61 to Q3.31 with rounding and truncation to 32 bits */
+		tmp = ((acc >> 29) + 1) >> 1;
+		tmp = (iir_v2i64)((iir_v2u64)tmp << 32) >> 32;
+
+		d0 = d1 + b1 * in + a1 * tmp;
+		d1 = b2 * in + a2 * tmp;
+		acc = gain * tmp;
+		acc = ((acc >> shift) + 1) >> 1;
+		iir_sat_int32_2ch(&acc);
+		y[0] = acc[0];
+		y[1] = acc[1];
+		x += 2;
+		y += 2;
+	}
+
+	iir[0].delay[d] = d0[0];
+	iir[1].delay[d] = d0[1];
+	iir[0].delay[d + 1] = d1[0];
+	iir[1].delay[d + 1] = d1[1];
+}
+
+static void iir_section_df2t_4ch(struct iir_state_df2t *iir, int c, int d,
+				 const int32_t *x, int32_t *y, int frames)
+{
+	iir_v4i64 a2;
+	iir_v4i64 a1;
+	iir_v4i64 b2;
+	iir_v4i64 b1;
+	iir_v4i64 b0;
+	iir_v4i64 shift;
+	iir_v4i64 gain;
+	iir_v4i64 d0;
+	iir_v4i64 d1;
+	iir_v4i64 acc;
+	iir_v4i64 tmp;
+	iir_v4i64 in;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		a2[i] = iir[i].coef[c];
+		a1[i] = iir[i].coef[c + 1];
+		b2[i] = iir[i].coef[c + 2];
+		b1[i] = iir[i].coef[c + 3];
+		b0[i] = iir[i].coef[c + 4];
+		shift[i] = 13 + iir[i].coef[c + 5];
+		gain[i] = iir[i].coef[c + 6];
+		d0[i] = iir[i].delay[d];
+		d1[i] = iir[i].delay[d + 1];
+	}
+
+	for (i = 0; i < frames; i++) {
+		in = (iir_v4i64){ x[0], x[1], x[2], x[3] };
+		acc = b0 * in + d0;
+
+		/* Q3.61 to Q3.31 with rounding and truncation to 32 bits */
+		tmp = ((acc >> 29) + 1) >> 1;
+		tmp = (iir_v4i64)((iir_v4u64)tmp << 32) >> 32;
+
+		d0 = d1 + b1 * in + a1 * tmp;
+		d1 = b2 * in + a2 * tmp;
+		acc = gain * tmp;
+		acc = ((acc >> shift) + 1) >> 1;
+		iir_sat_int32_4ch(&acc);
+		y[0] = acc[0];
+		y[1] = acc[1];
+		y[2] = acc[2];
+		y[3] = acc[3];
+		x += 4;
+		y += 4;
+	}
+
+	for (i = 0; i < 4; i++) {
+		iir[i].delay[d] = d0[i];
+		iir[i].delay[d + 1] = d1[i];
+	}
+}
+
+/* Series and parallel DF2T IIR for a block of frames. The lanes parameter
+ * is 1, 2 or 4 channels that are run in lockstep, iir points to state of
+ * the first of them. The input x is not modified. The work buffer w is
+ * used when the filter has sections in parallel.
+ */
+void iir_df2t_block(struct iir_state_df2t *iir, int lanes, const int32_t *x,
+		    int32_t *y, int32_t *w, int frames)
+{
+	const int32_t *src;
+	int32_t *dst;
+	int n = lanes * frames;
+	int c = 0; /* Index to coefficient a2 */
+	int d = 0; /* Index to delays */
+	int i;
+	int j;
+
+	/* Bypass is set with number of biquads set to zero. */
+	if (!iir->biquads) {
+		for (i = 0; i < n; i++)
+			y[i] = x[i];
+
+		return;
+	}
+
+	/* As in iir_df2t() the input of the next series of sections is the
+	 * output of the previous one. The first series writes to output and
+	 * the next ones to work buffer that is summed to output.
+	 */
+	src = x;
+	for (j = 0; j < iir->biquads; j += iir->biquads_in_series) {
+		dst = j ? w : y;
+		for (i = 0; i < iir->biquads_in_series; i++) {
+			switch (lanes) {
+			case 4:
+				iir_section_df2t_4ch(iir, c, d, src, dst,
+						     frames);
+				break;
+			case 2:
+				iir_section_df2t_2ch(iir, c, d, src, dst,
+						     frames);
+				break;
+			default:
+				iir_section_df2t(iir, c, d, src, dst, frames);
+				break;
+			}
+
+			src = dst;
+			c += SOF_EQ_IIR_NBIQUAD_DF2T;
+			d += IIR_DF2T_NUM_DELAYS;
+		}
+
+		if (j) {
+			for (i = 0; i < n; i++)
+				y[i] = sat_int32((int64_t)y[i] + w[i]);
+		}
+	}
+}
+
+/* Returns the number of channels starting from iir that can be run in
+ * lockstep. It is 4 or 2 if the filters have the same structure, else 1.
+ */
+int iir_df2t_lanes(struct iir_state_df2t *iir, int channels)
+{
+	int lanes;
+	int i;
+
+	for (lanes = IIR_LANES_MAX; lanes > 1; lanes >>= 1) {
+		if (lanes > channels)
+			continue;
+
+		for (i = 1; i < lanes; i++) {
+			if (iir[i].biquads != iir->biquads ||
+			    iir[i].biquads_in_series != iir->biquads_in_series)
+				break;
+		}
+
+		if (i == lanes)
+			return lanes;
+	}
+
+	return 1;
+}
+
 size_t iir_init_coef_df2t(struct iir_state_df2t *iir,
 			  struct sof_eq_iir_header_df2t *config)
 {
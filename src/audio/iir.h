@@ -37,6 +37,19 @@
 
 #define IIR_DF2T_NUM_DELAYS 2
 
+/* Max number of frames processed per call of iir_df2t_block() */
+#define IIR_BLOCK_SIZE 32
+
+/* Max number of channels processed in lockstep by iir_df2t_block(). The
+ * lockstep needs 64 bit integer SIMD to be faster than one channel at a
+ * time, without it the vector code is split to scalar operations.
+ */
+#if defined(__AVX2__)
+#define IIR_LANES_MAX 4
+#else
+#define IIR_LANES_MAX 1
+#endif
+
 struct iir_state_df2t {
 	unsigned int biquads; /* Number of IIR 2nd order sections total */
 	unsigned int biquads_in_series; /* Number of IIR 2nd order sections
@@ -48,6 +61,11 @@ struct iir_state_df2t {
 
 int32_t iir_df2t(struct iir_state_df2t *iir, int32_t x);
 
+void iir_df2t_block(struct iir_state_df2t *iir, int lanes, const int32_t *x,
+		    int32_t *y, int32_t *w, int frames);
+
+int iir_df2t_lanes(struct iir_state_df2t *iir, int channels);
+
 size_t iir_init_coef_df2t(struct iir_state_df2t *iir,
 			  struct sof_eq_iir_header_df2t *config);
 
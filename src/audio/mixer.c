@@ -59,30 +59,38 @@ static void mix_n_s16(struct comp_dev *dev, struct comp_buffer *sink,
 		      struct comp_buffer **sources, uint32_t num_sources,
 		      uint32_t frames)
 {
-	int16_t *src;
-	int16_t *dest;
+	int16_t *src[PLATFORM_MAX_STREAMS];
+	int16_t *dest = sink->w_ptr;
 	int32_t val;
-	int i;
+	uint32_t samples = frames * dev->params.channels;
+	uint32_t n;
+	uint32_t i;
 	int j;
-	int channel;
-	uint32_t frag = 0;
 
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			val = 0;
+	for (j = 0; j < num_sources; j++)
+		src[j] = sources[j]->r_ptr;
 
-			for (j = 0; j < num_sources; j++) {
-				src = buffer_read_frag_s16(sources[j], frag);
-				val += *src;
-			}
+	while (samples) {
+		/* process linear part of all buffers until one of them wraps */
+		n = MIN(samples, buffer_samples_without_wrap_s16(sink, dest));
+		for (j = 0; j < num_sources; j++)
+			n = MIN(n, buffer_samples_without_wrap_s16(sources[j],
+								   src[j]));
 
-			dest = buffer_write_frag_s16(sink, frag);
+		for (i = 0; i < n; i++) {
+			val = 0;
 
-			/* Saturate to 16 bits */
-			*dest = sat_int16(val);
+			for (j = 0; j < num_sources; j++)
+				val += src[j][i];
 
-			frag++;
+			/* Saturate to 16 bits */
+			dest[i] = sat_int16(val);
 		}
+
+		samples -= n;
+		for (j = 0; j < num_sources; j++)
+			src[j] = buffer_wrap(sources[j], src[j] + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -91,30 +99,38 @@ static void mix_n_s32(struct comp_dev *dev, struct comp_buffer *sink,
 		      struct comp_buffer **sources, uint32_t num_sources,
 		      uint32_t frames)
 {
-	int32_t *src;
-	int32_t *dest;
+	int32_t *src[PLATFORM_MAX_STREAMS];
+	int32_t *dest = sink->w_ptr;
 	int64_t val;
-	int i;
+	uint32_t samples = frames * dev->params.channels;
+	uint32_t n;
+	uint32_t i;
 	int j;
-	int channel;
-	uint32_t frag = 0;
 
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			val = 0;
+	for (j = 0; j < num_sources; j++)
+		src[j] = sources[j]->r_ptr;
 
-			for (j = 0; j < num_sources; j++) {
-				src = buffer_read_frag_s32(sources[j], frag);
-				val += *src;
-			}
+	while (samples) {
+		/* process linear part of all buffers until one of them wraps */
+		n = MIN(samples, buffer_samples_without_wrap_s32(sink, dest));
+		for (j = 0; j < num_sources; j++)
+			n = MIN(n, buffer_samples_without_wrap_s32(sources[j],
+								   src[j]));
 
-			dest = buffer_write_frag_s32(sink, frag);
+		for (i = 0; i < n; i++) {
+			val = 0;
 
-			/* Saturate to 32 bits */
-			*dest = sat_int32(val);
+			for (j = 0; j < num_sources; j++)
+				val += src[j][i];
 
-			frag++;
+			/* Saturate to 32 bits */
+			dest[i] = sat_int32(val);
 		}
+
+		samples -= n;
+		for (j = 0; j < num_sources; j++)
+			src[j] = buffer_wrap(sources[j], src[j] + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -439,6 +455,14 @@ static void mixer_cache(struct comp_dev *dev, int cmd)
 	}
 }
 
+/* Mixer is not flagged with COMP_DRV_KEEP_STATE, so xrun recovery runs
+ * mixer_prepare() as the full pipeline prepare did. Nothing of a running
+ * stream is lost: mixer keeps no stream position of its own, read and
+ * write positions are in its buffers that the recovery resets, and
+ * prepare only picks the mix function for the unchanged frame format.
+ * If other source streams are still running, prepare stops the recovery
+ * walk at the mixer so that the shared downstream path isn't touched.
+ */
 struct comp_driver comp_mixer = {
 	.type	= SOF_COMP_MIXER,
 	.ops	= {
@@ -49,6 +49,15 @@
 #include <sof/idc.h>
 #include <platform/idc.h>
 #include <sof/schedule.h>
+#include <sof/clk.h>
+#include <platform/clk.h>
+
+/* size of one intermediate tile of fused components */
+#define PPL_FUSE_TILE_BYTES \
+	(PPL_FUSE_FRAMES * PLATFORM_MAX_CHANNELS * sizeof(int32_t))
+
+/* pending copy order entry is a fused chain */
+#define PPL_PENDING_FUSED	0x8000
 
 /* generic pipeline data used by pipeline_comp_* functions */
 struct pipeline_data {
@@ -91,6 +100,10 @@ struct pipeline *pipeline_new(struct sof_ipc_pipe_new *pipe_desc,
 		return NULL;
 	}
 
+	/* topologies older than ABI 3.7 copy a single period per run */
+	if (!p->ipc_pipe.batch)
+		p->ipc_pipe.batch = 1;
+
 	/* get pipeline task type */
 	type = pipeline_is_timer_driven(p) ? SOF_SCHEDULE_LL :
 		SOF_SCHEDULE_EDF;
@@ -100,6 +113,20 @@ struct pipeline *pipeline_new(struct sof_ipc_pipe_new *pipe_desc,
 	return p;
 }
 
+/* forces copy order of pipeline tasks copying this component to be rebuilt */
+static void pipeline_comp_invalidate_copy_order(struct comp_dev *comp)
+{
+	struct pipeline *p = comp->pipeline;
+
+	if (!p)
+		return;
+
+	p->copy_order_valid = false;
+
+	if (p->sched_comp && p->sched_comp->pipeline)
+		p->sched_comp->pipeline->copy_order_valid = false;
+}
+
 int pipeline_connect(struct comp_dev *comp, struct comp_buffer *buffer,
 		     int dir)
 {
@@ -112,6 +139,11 @@ int pipeline_connect(struct comp_dev *comp, struct comp_buffer *buffer,
 	buffer_set_comp(buffer, comp, dir);
 	spin_unlock(&comp->lock);
 
+	/* update mode is selected again on pipeline complete */
+	buffer_set_spsc(buffer, false);
+
+	pipeline_comp_invalidate_copy_order(comp);
+
 	return 0;
 }
 
@@ -155,15 +187,157 @@ static int pipeline_for_each_comp(struct comp_dev *current,
 	return err;
 }
 
+/* checks if component updates its buffer from DMA callback context */
+static inline bool pipeline_is_dma_endpoint(struct comp_dev *comp)
+{
+	switch (comp->comp.type) {
+	case SOF_COMP_HOST:
+	case SOF_COMP_DAI:
+	case SOF_COMP_SG_HOST:
+	case SOF_COMP_SG_DAI:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Buffers can be updated lock free if their source and sink components are
+ * both copied from the same pipeline task on the same core and none of them
+ * updates the buffer from DMA interrupt context.
+ */
+static void pipeline_buffer_select_mode(struct comp_buffer *buffer)
+{
+	struct comp_dev *source = buffer->source;
+	struct comp_dev *sink = buffer->sink;
+	bool spsc = false;
+
+	if (source && sink && source->pipeline && sink->pipeline)
+		spsc = source->pipeline->ipc_pipe.core ==
+			sink->pipeline->ipc_pipe.core &&
+			pipeline_is_same_sched_comp(source->pipeline,
+						    sink->pipeline) &&
+			!pipeline_is_dma_endpoint(source) &&
+			!pipeline_is_dma_endpoint(sink);
+
+	buffer_set_spsc(buffer, spsc);
+}
+
+static void pipeline_comp_select_buffer_mode(struct comp_dev *current)
+{
+	struct list_item *clist;
+
+	list_for_item(clist, &current->bsource_list)
+		pipeline_buffer_select_mode(container_of(clist,
+							 struct comp_buffer,
+							 sink_list));
+
+	list_for_item(clist, &current->bsink_list)
+		pipeline_buffer_select_mode(container_of(clist,
+							 struct comp_buffer,
+							 source_list));
+}
+
+/* Pipelines copied by one task must agree on the number of periods per run,
+ * otherwise the buffer between them is drained faster than it is filled.
+ */
+static int pipeline_buffer_batch_check(struct comp_buffer *buffer)
+{
+	struct pipeline *source_p = buffer->source ?
+		buffer->source->pipeline : NULL;
+	struct pipeline *sink_p = buffer->sink ? buffer->sink->pipeline : NULL;
+
+	if (!source_p || !sink_p || source_p == sink_p ||
+	    source_p->sched_comp != sink_p->sched_comp ||
+	    source_p->ipc_pipe.batch == sink_p->ipc_pipe.batch)
+		return 0;
+
+	trace_pipe_error_with_ids(sink_p, "pipeline_buffer_batch_check() "
+				  "error: buffer %u joins batch %u and %u",
+				  buffer->ipc_buffer.comp.id,
+				  source_p->ipc_pipe.batch,
+				  sink_p->ipc_pipe.batch);
+	return -EINVAL;
+}
+
+static int pipeline_comp_batch_check(struct comp_dev *current)
+{
+	struct comp_buffer *buffer;
+	struct list_item *clist;
+	int ret;
+
+	list_for_item(clist, &current->bsource_list) {
+		buffer = container_of(clist, struct comp_buffer, sink_list);
+		ret = pipeline_buffer_batch_check(buffer);
+		if (ret < 0)
+			return ret;
+	}
+
+	list_for_item(clist, &current->bsink_list) {
+		buffer = container_of(clist, struct comp_buffer, source_list);
+		ret = pipeline_buffer_batch_check(buffer);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* checks if component has exactly one source and one sink buffer */
+static bool pipeline_comp_is_1_to_1(struct comp_dev *comp)
+{
+	struct list_item *sources = &comp->bsource_list;
+	struct list_item *sinks = &comp->bsink_list;
+
+	return !list_is_empty(sources) && sources->next == sources->prev &&
+		!list_is_empty(sinks) && sinks->next == sinks->prev;
+}
+
+/* Sink buffer of in place component can share memory with its source
+ * buffer. Aliased buffers are within one pipeline and updated lock free from
+ * its task, except for the first buffer of the chain, which can also be fed
+ * by DMA endpoint of the pipeline. Its free space is updated under lock.
+ * Buffers drained by DMA keep their own memory, as DMA is set up with their
+ * address before aliases are checked on prepare.
+ */
+static void pipeline_buffer_alias(struct comp_buffer *buffer)
+{
+	struct comp_dev *comp = buffer->source;
+	struct comp_buffer *source;
+	bool dma_fed;
+
+	if (!comp || !(comp->drv->flags & COMP_DRV_INPLACE) ||
+	    !pipeline_comp_is_1_to_1(comp) || buffer->alias)
+		return;
+
+	source = list_first_item(&comp->bsource_list, struct comp_buffer,
+				 sink_list);
+	dma_fed = source->source && !source->alias &&
+		source->source->pipeline == comp->pipeline &&
+		pipeline_is_dma_endpoint(source->source);
+
+	if ((source->spsc || dma_fed) && buffer->spsc &&
+	    source->ipc_buffer.comp.pipeline_id ==
+	    buffer->ipc_buffer.comp.pipeline_id &&
+	    source->ipc_buffer.size == buffer->ipc_buffer.size &&
+	    source->ipc_buffer.caps == buffer->ipc_buffer.caps &&
+	    !source->alias_next)
+		buffer_alias(buffer, source);
+}
+
 static int pipeline_comp_complete(struct comp_dev *current, void *data,
 				  int dir)
 {
 	struct pipeline_data *ppl_data = data;
+	struct list_item *clist;
+	int ret;
 
 	tracev_pipe_with_ids(ppl_data->p, "pipeline_comp_complete(), "
 			     "current->comp.id = %u, dir = %u",
 			     current->comp.id, dir);
 
+	/* graph has changed for connected pipelines too */
+	pipeline_comp_invalidate_copy_order(current);
+
 	if (!comp_is_single_pipeline(current, ppl_data->start)) {
 		tracev_pipe_with_ids(ppl_data->p, "pipeline_comp_complete(), "
 				     "current is from another pipeline");
@@ -172,18 +346,32 @@ static int pipeline_comp_complete(struct comp_dev *current, void *data,
 
 	/* complete component init */
 	current->pipeline = ppl_data->p;
-	current->frames = ppl_data->p->ipc_pipe.frames_per_sched;
+	current->frames = ppl_data->p->ipc_pipe.frames_per_sched *
+		ppl_data->p->ipc_pipe.batch;
 
-	pipeline_for_each_comp(current, &pipeline_comp_complete, data,
-			       NULL, dir);
+	ret = pipeline_comp_batch_check(current);
+	if (ret < 0)
+		return ret;
 
-	return 0;
+	/* buffers to components from other pipelines are checked again
+	 * when these pipelines get completed
+	 */
+	pipeline_comp_select_buffer_mode(current);
+
+	/* sources are lock free once both of their ends are completed */
+	list_for_item(clist, &current->bsource_list)
+		pipeline_buffer_alias(container_of(clist, struct comp_buffer,
+						   sink_list));
+
+	return pipeline_for_each_comp(current, &pipeline_comp_complete, data,
+				      NULL, dir);
 }
 
 int pipeline_complete(struct pipeline *p, struct comp_dev *source,
 		      struct comp_dev *sink)
 {
 	struct pipeline_data data;
+	int ret;
 
 	trace_pipe_with_ids(p, "pipeline_complete()");
 
@@ -200,11 +388,17 @@ int pipeline_complete(struct pipeline *p, struct comp_dev *source,
 	/* now walk downstream from source component and
 	 * complete component task and pipeline initialization
 	 */
-	pipeline_comp_complete(source, &data, PPL_DIR_DOWNSTREAM);
+	ret = pipeline_comp_complete(source, &data, PPL_DIR_DOWNSTREAM);
+	if (ret < 0) {
+		trace_pipe_error_with_ids(p, "pipeline_complete() error: "
+					  "ret = %d", ret);
+		return ret;
+	}
 
 	p->source_comp = source;
 	p->sink_comp = sink;
 	p->status = COMP_STATE_READY;
+	p->copy_order_valid = false;
 
 	/* show heap status */
 	heap_trace_all(0);
@@ -225,8 +419,10 @@ static int pipeline_comp_free(struct comp_dev *current, void *data, int dir)
 		return 0;
 	}
 
-	/* complete component free */
+	/* complete component free, arena memory goes with the pipeline */
+	pipeline_comp_invalidate_copy_order(current);
 	current->pipeline = NULL;
+	current->arena_released = true;
 
 	pipeline_for_each_comp(current, &pipeline_comp_free, data,
 			       NULL, dir);
@@ -239,6 +435,145 @@ static int pipeline_comp_free(struct comp_dev *current, void *data, int dir)
 	return 0;
 }
 
+/* Arena is used from component params, prepare and reset, which are
+ * serialized by IPC and the pipeline lock. Allocations are aligned to
+ * PPL_ARENA_ALIGN.
+ */
+void *pipeline_arena_alloc(struct pipeline *p, size_t bytes)
+{
+	struct pipeline_arena_block **prev;
+	struct pipeline_arena_block *block;
+	struct pipeline_arena_block *rest;
+	struct pipeline_arena_chunk *chunk;
+	uint32_t size = PPL_ARENA_HDR_SIZE + ALIGN(bytes, PPL_ARENA_ALIGN);
+	uint32_t hdr_size = ALIGN(sizeof(*chunk), PPL_ARENA_ALIGN);
+	uint32_t data_size = MAX(size, PPL_ARENA_CHUNK_SIZE);
+	void *ptr;
+
+	/* reuse first freed block that fits, split off what is left over */
+	for (prev = &p->arena.free; *prev; prev = &(*prev)->next) {
+		block = *prev;
+		if (block->size < size)
+			continue;
+
+		if (block->size - size > PPL_ARENA_HDR_SIZE) {
+			rest = (struct pipeline_arena_block *)
+				((uint8_t *)block + size);
+			rest->next = block->next;
+			rest->size = block->size - size;
+			block->size = size;
+			*prev = rest;
+		} else {
+			*prev = block->next;
+		}
+
+		goto out;
+	}
+
+	for (chunk = p->arena.chunks; chunk; chunk = chunk->next)
+		if (chunk->size - chunk->used >= size)
+			break;
+
+	if (!chunk) {
+		chunk = rballoc_align(RZONE_BUFFER, SOF_MEM_CAPS_RAM,
+				      hdr_size + data_size, PPL_ARENA_ALIGN);
+		if (!chunk) {
+			trace_pipe_error_with_ids(p, "pipeline_arena_alloc() "
+						  "error: no memory for %u "
+						  "bytes", bytes);
+			return NULL;
+		}
+
+		chunk->data = (uint8_t *)chunk + hdr_size;
+		chunk->size = data_size;
+		chunk->used = 0;
+		chunk->next = p->arena.chunks;
+		p->arena.chunks = chunk;
+	}
+
+	block = (struct pipeline_arena_block *)(chunk->data + chunk->used);
+	block->size = size;
+	chunk->used += size;
+
+out:
+	p->arena.live++;
+
+	ptr = (uint8_t *)block + PPL_ARENA_HDR_SIZE;
+	bzero(ptr, block->size - PPL_ARENA_HDR_SIZE);
+
+	return ptr;
+}
+
+bool pipeline_arena_free(struct pipeline *p, void *ptr)
+{
+	struct pipeline_arena_block *before = NULL;
+	struct pipeline_arena_block *after;
+	struct pipeline_arena_block *block;
+	struct pipeline_arena_chunk *chunk;
+	uint8_t *data = ptr;
+
+	for (chunk = p->arena.chunks; chunk; chunk = chunk->next)
+		if (data >= chunk->data && data < chunk->data + chunk->size)
+			break;
+
+	if (!chunk)
+		return false;
+
+	p->arena.live--;
+
+	/* all memory is reused once nothing is allocated */
+	if (!p->arena.live) {
+		for (chunk = p->arena.chunks; chunk; chunk = chunk->next)
+			chunk->used = 0;
+		p->arena.free = NULL;
+		return true;
+	}
+
+	block = (struct pipeline_arena_block *)(data - PPL_ARENA_HDR_SIZE);
+
+	/* last carved block goes back to the chunk */
+	if ((uint8_t *)block + block->size == chunk->data + chunk->used) {
+		chunk->used -= block->size;
+		return true;
+	}
+
+	/* keep free list in address order and merge with neighbours */
+	for (after = p->arena.free; after && after < block;
+	     after = after->next)
+		before = after;
+
+	block->next = after;
+	if (after && (uint8_t *)block + block->size == (uint8_t *)after) {
+		block->size += after->size;
+		block->next = after->next;
+	}
+
+	if (!before) {
+		p->arena.free = block;
+	} else if ((uint8_t *)before + before->size == (uint8_t *)block) {
+		before->size += block->size;
+		before->next = block->next;
+	} else {
+		before->next = block;
+	}
+
+	return true;
+}
+
+static void pipeline_arena_release(struct pipeline *p)
+{
+	struct pipeline_arena_chunk *chunk;
+
+	while (p->arena.chunks) {
+		chunk = p->arena.chunks;
+		p->arena.chunks = chunk->next;
+		rfree(chunk);
+	}
+
+	p->arena.free = NULL;
+	p->arena.live = 0;
+}
+
 /* pipelines must be inactive */
 int pipeline_free(struct pipeline *p)
 {
@@ -264,6 +599,8 @@ int pipeline_free(struct pipeline *p)
 	pipeline_comp_free(p->source_comp, &data, PPL_DIR_DOWNSTREAM);
 
 	/* now free the pipeline */
+	pipeline_arena_release(p);
+	rfree(p->fuse_tiles);
 	rfree(p);
 
 	/* show heap status */
@@ -349,7 +686,65 @@ static int pipeline_comp_prepare(struct comp_dev *current, void *data, int dir)
 				      &buffer_reset_pos, dir);
 }
 
+/* aliased buffer needs the same runtime size and frame size as its source */
+static int pipeline_buffer_alias_check(struct comp_buffer *buffer)
+{
+	struct comp_buffer *source = buffer->alias;
+
+	if (!source || (buffer->size == source->size &&
+			comp_frame_bytes(source->source) ==
+			comp_frame_bytes(buffer->sink)))
+		return 0;
+
+	trace_pipe("pipeline_buffer_alias_check(), buffer %u can't be "
+		   "processed in place", buffer->ipc_buffer.comp.id);
+
+	return buffer_unalias(buffer);
+}
+
+/* Checks buffers aliased on complete once sizes and formats are set,
+ * buffers which can't be processed in place get their memory back.
+ */
+static int pipeline_comp_alias_check(struct comp_dev *current, void *data,
+				     int dir)
+{
+	struct list_item *clist;
+	struct comp_buffer *buffer;
+	int err;
+
+	list_for_item(clist, comp_buffer_list(current, dir)) {
+		buffer = buffer_from_list(clist, struct comp_buffer, dir);
+		err = pipeline_buffer_alias_check(buffer);
+		if (err < 0)
+			return err;
+	}
+
+	return pipeline_for_each_comp(current, &pipeline_comp_alias_check,
+				      data, NULL, dir);
+}
+
+/* tiles of fused components are used by task of scheduling pipeline */
+static void pipeline_fuse_tiles_alloc(struct pipeline *p)
+{
+	if (p->sched_comp && p->sched_comp->pipeline)
+		p = p->sched_comp->pipeline;
+
+	if (!p->fuse_tiles)
+		p->fuse_tiles = rballoc(RZONE_BUFFER, SOF_MEM_CAPS_RAM,
+					2 * PPL_FUSE_TILE_BYTES);
+}
+
 /* prepare the pipeline for usage - preload host buffers here */
+static void pipeline_set_prepared(struct pipeline *p, int dir)
+{
+	/* pipeline preload needed only for playback streams and capture
+	 * streams scheduled with timer
+	 */
+	p->preload = dir == SOF_IPC_STREAM_PLAYBACK ||
+		pipeline_is_timer_driven(p);
+	p->status = COMP_STATE_PREPARE;
+}
+
 int pipeline_prepare(struct pipeline *p, struct comp_dev *dev)
 {
 	int ret = 0;
@@ -366,12 +761,20 @@ int pipeline_prepare(struct pipeline *p, struct comp_dev *dev)
 		goto out;
 	}
 
-	/* pipeline preload needed only for playback streams and capture
-	 * streams scheduled with timer
-	 */
-	p->preload = dev->params.direction == SOF_IPC_STREAM_PLAYBACK ||
-		pipeline_is_timer_driven(p);
-	p->status = COMP_STATE_PREPARE;
+	ret = pipeline_comp_alias_check(dev, NULL, dev->params.direction);
+	if (ret < 0) {
+		trace_pipe_error("pipeline_prepare() error: alias check "
+				 "ret = %d", ret);
+		goto out;
+	}
+
+	pipeline_set_prepared(p, dev->params.direction);
+	p->period_ticks = clock_ms_to_ticks(PLATFORM_WORKQ_CLOCK, 1) *
+		pipeline_task_period(p) / 1000;
+
+	/* copy order is rebuilt on first copy */
+	pipeline_comp_invalidate_copy_order(dev);
+	pipeline_fuse_tiles_alloc(p);
 
 out:
 	spin_unlock_irq(&p->lock, flags);
@@ -435,6 +838,8 @@ static void pipeline_comp_trigger_sched_comp(struct pipeline *p,
 	case COMP_TRIGGER_STOP:
 	case COMP_TRIGGER_XRUN:
 		pipeline_schedule_cancel(p);
+		if (p->status == COMP_STATE_ACTIVE)
+			clock_governor_stop();
 		p->status = COMP_STATE_PAUSED;
 		break;
 	case COMP_TRIGGER_RELEASE:
@@ -450,6 +855,8 @@ static void pipeline_comp_trigger_sched_comp(struct pipeline *p,
 			/* schedule initial pipeline fill when next idle */
 			pipeline_schedule_copy_idle(p);
 		}
+		if (p->status != COMP_STATE_ACTIVE)
+			clock_governor_start();
 		p->status = COMP_STATE_ACTIVE;
 		break;
 	case COMP_TRIGGER_SUSPEND:
@@ -649,6 +1056,18 @@ int pipeline_reset(struct pipeline *p, struct comp_dev *host)
 	return ret;
 }
 
+/* copies component and accounts its execution time */
+static int pipeline_comp_copy_timed(struct comp_dev *dev)
+{
+	uint64_t start = platform_timer_get(platform_timer);
+	int ret;
+
+	ret = comp_copy(dev);
+	comp_perf_update(dev, platform_timer_get(platform_timer) - start);
+
+	return ret;
+}
+
 static int pipeline_comp_copy(struct comp_dev *current, void *data, int dir)
 {
 	struct pipeline_data *ppl_data = data;
@@ -673,7 +1092,7 @@ static int pipeline_comp_copy(struct comp_dev *current, void *data, int dir)
 
 	/* copy to downstream immediately */
 	if (dir == PPL_DIR_DOWNSTREAM) {
-		err = comp_copy(current);
+		err = pipeline_comp_copy_timed(current);
 		if (err < 0 || err == PPL_STATUS_PATH_STOP)
 			return err;
 	}
@@ -684,11 +1103,340 @@ static int pipeline_comp_copy(struct comp_dev *current, void *data, int dir)
 		return err;
 
 	if (dir == PPL_DIR_UPSTREAM)
-		err = comp_copy(current);
+		err = pipeline_comp_copy_timed(current);
 
 	return err;
 }
 
+/* Records components in the order pipeline_comp_copy() visits them,
+ * together with the end of their subtree, so copy can be done without
+ * walking the graph. Component state is still checked on every copy.
+ */
+static int pipeline_comp_copy_order(struct comp_dev *current, void *data,
+				    int dir)
+{
+	struct pipeline_data *ppl_data = data;
+	struct pipeline *p = ppl_data->p;
+	struct pipeline_copy_entry *entry;
+	int err;
+
+	if (!comp_is_single_pipeline(current, ppl_data->start) &&
+	    !pipeline_is_same_sched_comp(current->pipeline, p))
+		return 0;
+
+	if (p->copy_order_count == PPL_COPY_ORDER_MAX)
+		return -ENOSPC;
+
+	entry = &p->copy_order[p->copy_order_count++];
+	entry->comp = current;
+
+	err = pipeline_for_each_comp(current, &pipeline_comp_copy_order,
+				     data, NULL, dir);
+	if (err < 0)
+		return err;
+
+	entry->skip = p->copy_order_count;
+
+	return 0;
+}
+
+/* checks if component has process() and exactly one source and sink */
+static bool pipeline_comp_is_fusable(struct comp_dev *comp)
+{
+	return comp->drv->ops.process && pipeline_comp_is_1_to_1(comp);
+}
+
+/* first buffer connected to component in walk direction */
+static inline struct comp_buffer *pipeline_comp_buffer(struct comp_dev *comp,
+						       int dir)
+{
+	return buffer_from_list(comp_buffer_list(comp, dir)->next,
+				struct comp_buffer, dir);
+}
+
+/* Intermediate buffers of fused chain are bypassed and their positions
+ * are not updated. Buffers with callbacks or marked by buffer code, as
+ * aliased buffers are, depend on every update and can't be bypassed.
+ */
+static bool pipeline_buffer_is_bypassable(struct comp_buffer *buffer)
+{
+	return !buffer->cb && !buffer->no_bypass;
+}
+
+/* Finds chains of fusable components connected directly to each other.
+ * Such components follow each other in copy order in both directions,
+ * so chain is stored as its length in the first entry.
+ */
+static void pipeline_copy_order_fuse(struct pipeline *p, int dir)
+{
+	struct pipeline_copy_entry *entry;
+	struct comp_buffer *buffer;
+	int i;
+	int j;
+
+	for (i = 0; i < p->copy_order_count; i = j) {
+		entry = &p->copy_order[i];
+		entry->fused = 0;
+		j = i + 1;
+
+		if (!pipeline_comp_is_fusable(entry->comp))
+			continue;
+
+		while (j < p->copy_order_count &&
+		       pipeline_comp_is_fusable(p->copy_order[j].comp)) {
+			buffer = pipeline_comp_buffer(p->copy_order[j - 1].comp,
+						      dir);
+			if (buffer_get_comp(buffer, dir) !=
+			    p->copy_order[j].comp ||
+			    !pipeline_buffer_is_bypassable(buffer) ||
+			    comp_frame_bytes(buffer->sink) >
+			    PPL_FUSE_TILE_BYTES / PPL_FUSE_FRAMES)
+				break;
+
+			p->copy_order[j++].fused = 0;
+		}
+
+		if (j - i > 1)
+			entry->fused = j - i;
+	}
+}
+
+/* component of fused chain in processing order, from source to sink */
+static inline struct comp_dev *
+pipeline_fused_comp(struct pipeline_copy_entry *head, int idx, int dir)
+{
+	if (dir == PPL_DIR_DOWNSTREAM)
+		return head[idx].comp;
+
+	return head[head->fused - 1 - idx].comp;
+}
+
+/* checks if fused chain can bypass its intermediate buffers */
+static bool pipeline_fused_ready(struct pipeline_copy_entry *head, int dir)
+{
+	int i;
+
+	for (i = 0; i < head->fused; i++) {
+		if (!comp_is_active(head[i].comp))
+			return false;
+
+		/* leftovers need to be drained with regular copy first */
+		if (i && pipeline_comp_buffer(head[i - 1].comp, dir)->avail)
+			return false;
+	}
+
+	return true;
+}
+
+/* Processes fused chain tile by tile, data between components is passed
+ * through small tiles instead of intermediate buffers to stay in cache.
+ * Only the chain source and sink buffers are updated.
+ */
+static int pipeline_fused_copy(struct pipeline *p,
+			       struct pipeline_copy_entry *head, int dir)
+{
+	struct comp_dev *first = pipeline_fused_comp(head, 0, dir);
+	struct comp_dev *last = pipeline_fused_comp(head, head->fused - 1,
+						    dir);
+	struct comp_buffer *source;
+	struct comp_buffer *sink;
+	struct comp_buffer *stage_source;
+	struct comp_buffer *stage_sink;
+	struct comp_buffer in;
+	struct comp_buffer out;
+	struct comp_buffer tile[2];
+	struct comp_dev *comp;
+	uint64_t start;
+	uint32_t source_frame_bytes;
+	uint32_t sink_frame_bytes;
+	uint32_t frames;
+	uint32_t done;
+	uint32_t n;
+	int ret;
+	int i;
+
+	source = list_first_item(&first->bsource_list, struct comp_buffer,
+				 sink_list);
+	sink = list_first_item(&last->bsink_list, struct comp_buffer,
+			       source_list);
+
+	frames = comp_avail_frames(source, sink);
+	if (!frames) {
+		/* let components report xrun */
+		for (i = 0; i < head->fused; i++) {
+			comp = pipeline_fused_comp(head, i, dir);
+			ret = pipeline_comp_copy_timed(comp);
+			if (ret < 0)
+				return ret;
+		}
+
+		return 0;
+	}
+
+	source_frame_bytes = comp_frame_bytes(source->source);
+	sink_frame_bytes = comp_frame_bytes(sink->sink);
+
+	/* views of chain source and sink advanced tile by tile */
+	in = *source;
+	out = *sink;
+
+	/* execution time of all tiles is summed up in last copy ticks */
+	for (i = 0; i < head->fused; i++)
+		pipeline_fused_comp(head, i, dir)->perf.last = 0;
+
+	bzero(tile, sizeof(tile));
+	for (i = 0; i < 2; i++) {
+		tile[i].addr = p->fuse_tiles + i * PPL_FUSE_TILE_BYTES;
+		tile[i].end_addr = tile[i].addr + PPL_FUSE_TILE_BYTES;
+		tile[i].size = PPL_FUSE_TILE_BYTES;
+	}
+
+	for (done = 0; done < frames; done += n) {
+		n = MIN(frames - done, PPL_FUSE_FRAMES);
+		stage_source = &in;
+
+		for (i = 0; i < head->fused; i++) {
+			if (i == head->fused - 1) {
+				stage_sink = &out;
+			} else {
+				stage_sink = &tile[i & 1];
+				stage_sink->r_ptr = stage_sink->addr;
+				stage_sink->w_ptr = stage_sink->addr;
+			}
+
+			comp = pipeline_fused_comp(head, i, dir);
+			start = platform_timer_get(platform_timer);
+			ret = comp_process(comp, stage_source, stage_sink, n);
+			comp->perf.last += platform_timer_get(platform_timer) -
+				start;
+			if (ret < 0)
+				return ret;
+
+			stage_source = stage_sink;
+		}
+
+		in.r_ptr = buffer_wrap(&in, in.r_ptr + n * source_frame_bytes);
+		out.w_ptr = buffer_wrap(&out,
+					out.w_ptr + n * sink_frame_bytes);
+	}
+
+	comp_update_buffer_produce(sink, frames * sink_frame_bytes);
+	comp_update_buffer_consume(source, frames * source_frame_bytes);
+
+	for (i = 0; i < head->fused; i++) {
+		comp = pipeline_fused_comp(head, i, dir);
+		comp_perf_update(comp, comp->perf.last);
+	}
+
+	return 0;
+}
+
+static int pipeline_copy_order_build(struct pipeline *p,
+				     struct comp_dev *start, int dir)
+{
+	struct pipeline_data data;
+	int ret;
+
+	data.start = start;
+	data.p = p;
+
+	p->copy_order_count = 0;
+	p->copy_order_start = start;
+
+	ret = pipeline_comp_copy_order(start, &data, dir);
+	if (ret < 0) {
+		trace_pipe_error_with_ids(p, "pipeline_copy_order_build() "
+					  "error: ret = %d", ret);
+		p->copy_order_count = 0;
+	} else if (p->fuse_tiles) {
+		pipeline_copy_order_fuse(p, dir);
+	}
+
+	p->copy_order_valid = true;
+
+	return ret;
+}
+
+/* copies upstream component or fused chain after its subtree */
+static int pipeline_copy_pending(struct pipeline *p, uint16_t pending,
+				 int dir)
+{
+	struct pipeline_copy_entry *entry =
+		&p->copy_order[pending & ~PPL_PENDING_FUSED];
+
+	if (pending & PPL_PENDING_FUSED)
+		return pipeline_fused_copy(p, entry, dir);
+
+	return pipeline_comp_copy_timed(entry->comp);
+}
+
+/* Copies components from precomputed copy order. Downstream components
+ * are copied before their subtree (pre-order) and upstream components
+ * after their subtree (post-order), same as pipeline_comp_copy().
+ */
+static int pipeline_copy_order_run(struct pipeline *p, int dir)
+{
+	struct pipeline_copy_entry *entry;
+	uint16_t pending[PPL_COPY_ORDER_MAX];
+	int depth = 0;
+	int i = 0;
+	int err;
+
+	while (i < p->copy_order_count) {
+		/* copy upstream components with completed subtree */
+		while (depth && p->copy_order[pending[depth - 1] &
+					      ~PPL_PENDING_FUSED].skip <= i) {
+			err = pipeline_copy_pending(p, pending[--depth], dir);
+			if (err < 0)
+				return err;
+		}
+
+		entry = &p->copy_order[i];
+
+		if (entry->fused && pipeline_fused_ready(entry, dir)) {
+			if (dir == PPL_DIR_DOWNSTREAM) {
+				err = pipeline_fused_copy(p, entry, dir);
+				if (err < 0)
+					return err;
+			} else {
+				pending[depth++] = i | PPL_PENDING_FUSED;
+			}
+
+			/* continue after the last component of chain */
+			i += entry->fused;
+			continue;
+		}
+
+		if (!comp_is_active(entry->comp)) {
+			i = entry->skip;
+			continue;
+		}
+
+		if (dir == PPL_DIR_DOWNSTREAM) {
+			err = pipeline_comp_copy_timed(entry->comp);
+			if (err < 0)
+				return err;
+
+			if (err == PPL_STATUS_PATH_STOP) {
+				i = entry->skip;
+				continue;
+			}
+		} else {
+			pending[depth++] = i;
+		}
+
+		i++;
+	}
+
+	while (depth) {
+		err = pipeline_copy_pending(p, pending[--depth], dir);
+		if (err < 0)
+			return err;
+	}
+
+	return 0;
+}
+
 /* Copy data across all pipeline components.
  * For capture pipelines it always starts from source component
  * and continues downstream. For playback pipelines there are two
@@ -709,7 +1457,7 @@ static int pipeline_copy(struct pipeline *p)
 
 		/* if not pipeline preload then copy sink comp first */
 		if (!p->preload) {
-			ret = comp_copy(start);
+			ret = pipeline_comp_copy_timed(start);
 			if (ret < 0) {
 				trace_pipe_error("pipeline_copy() error: "
 						 "ret = %d", ret);
@@ -726,10 +1474,19 @@ static int pipeline_copy(struct pipeline *p)
 		start = p->source_comp;
 	}
 
-	data.start = start;
-	data.p = p;
+	if (!p->copy_order_valid || p->copy_order_start != start)
+		pipeline_copy_order_build(p, start, dir);
+
+	if (p->copy_order_count) {
+		ret = pipeline_copy_order_run(p, dir);
+	} else {
+		/* copy order doesn't fit, walk the graph */
+		data.start = start;
+		data.p = p;
+
+		ret = pipeline_comp_copy(start, &data, dir);
+	}
 
-	ret = pipeline_comp_copy(start, &data, dir);
 	if (ret < 0)
 		trace_pipe_error("pipeline_copy() error: ret = %d, start"
 				 "->comp.id = %u, dir = %u", ret,
@@ -828,6 +1585,51 @@ void pipeline_xrun(struct pipeline *p, struct comp_dev *dev,
 	pipeline_comp_xrun(dev, &data, dev->params.direction);
 }
 
+/* Prepares components again after xrun. Configuration, buffer sizes and
+ * graph are unchanged, so components keeping their state over xrun are
+ * only moved to prepared state, the others are fully prepared. Buffers
+ * are emptied and silenced on the way.
+ */
+static int pipeline_comp_xrun_prepare(struct comp_dev *current, void *data,
+				      int dir)
+{
+	int err;
+
+	tracev_pipe("pipeline_comp_xrun_prepare(), current->comp.id = %u, "
+		    "dir = %u", current->comp.id, dir);
+
+	if (current->drv->flags & COMP_DRV_KEEP_STATE) {
+		err = comp_set_state(current, COMP_TRIGGER_PREPARE);
+		if (err == COMP_STATUS_STATE_ALREADY_SET)
+			err = PPL_STATUS_PATH_STOP;
+	} else {
+		err = comp_prepare(current);
+	}
+
+	if (err < 0 || err == PPL_STATUS_PATH_STOP)
+		return err;
+
+	return pipeline_for_each_comp(current, &pipeline_comp_xrun_prepare,
+				      data, &buffer_reset_pos, dir);
+}
+
+static int pipeline_xrun_prepare(struct pipeline *p)
+{
+	struct comp_dev *dev = p->source_comp;
+	uint32_t flags;
+	int ret;
+
+	spin_lock_irq(&p->lock, flags);
+
+	ret = pipeline_comp_xrun_prepare(dev, NULL, dev->params.direction);
+	if (ret >= 0)
+		pipeline_set_prepared(p, dev->params.direction);
+
+	spin_unlock_irq(&p->lock, flags);
+
+	return ret;
+}
+
 #if NO_XRUN_RECOVERY
 /* recover the pipeline from a XRUN condition */
 static int pipeline_xrun_recover(struct pipeline *p)
@@ -844,10 +1646,10 @@ static int pipeline_xrun_recover(struct pipeline *p)
 	trace_pipe_error_with_ids(p, "pipeline_xrun_recover()");
 
 	/* prepare the pipeline */
-	ret = pipeline_prepare(p, p->source_comp);
+	ret = pipeline_xrun_prepare(p);
 	if (ret < 0) {
 		trace_pipe_error_with_ids(p, "pipeline_xrun_recover() error: "
-					  "pipeline_prepare() failed, "
+					  "pipeline_xrun_prepare() failed, "
 					  "ret = %d", ret);
 		return ret;
 	}
@@ -872,7 +1674,7 @@ static int pipeline_xrun_recover(struct pipeline *p)
 void pipeline_schedule_copy(struct pipeline *p, uint64_t start)
 {
 	if (p->sched_comp->state == COMP_STATE_ACTIVE)
-		schedule_task(&p->pipe_task, start, p->ipc_pipe.period, 0);
+		schedule_task(&p->pipe_task, start, pipeline_task_period(p), 0);
 }
 
 /* notify pipeline that this component requires buffers emptied/filled
@@ -881,7 +1683,7 @@ void pipeline_schedule_copy(struct pipeline *p, uint64_t start)
  */
 void pipeline_schedule_copy_idle(struct pipeline *p)
 {
-	schedule_task(&p->pipe_task, 0, p->ipc_pipe.period,
+	schedule_task(&p->pipe_task, 0, pipeline_task_period(p),
 		      SOF_SCHEDULE_FLAG_IDLE);
 }
 
@@ -897,9 +1699,83 @@ void pipeline_schedule_cancel(struct pipeline *p)
 					  "failed, err = %d", err);
 }
 
+struct comp_buffer *pipeline_dai_buffer(struct pipeline *p)
+{
+	struct comp_dev *dai;
+	struct list_item *buffers;
+
+	if (!p->source_comp || !p->sink_comp)
+		return NULL;
+
+	if (p->source_comp->params.direction == SOF_IPC_STREAM_PLAYBACK) {
+		dai = p->sink_comp;
+		buffers = &dai->bsource_list;
+	} else {
+		dai = p->source_comp;
+		buffers = &dai->bsink_list;
+	}
+
+	if ((dai->comp.type != SOF_COMP_DAI &&
+	     dai->comp.type != SOF_COMP_SG_DAI) || list_is_empty(buffers))
+		return NULL;
+
+	return dai == p->sink_comp ?
+		list_first_item(buffers, struct comp_buffer, sink_list) :
+		list_first_item(buffers, struct comp_buffer, source_list);
+}
+
+/* data left for playback DAI or space left for capture DAI */
+static uint32_t pipeline_dai_headroom(struct pipeline *p)
+{
+	struct comp_buffer *buffer = pipeline_dai_buffer(p);
+
+	if (!buffer)
+		return UINT32_MAX;
+
+	return buffer->sink == p->sink_comp ? buffer->avail : buffer->free;
+}
+
+void pipeline_stats_reset(struct pipeline *p)
+{
+	bzero(&p->stats, sizeof(p->stats));
+}
+
+/* accounts pipeline task run started at start ticks */
+static void pipeline_stats_update(struct pipeline *p, uint64_t start,
+				  uint32_t headroom)
+{
+	struct pipeline_stats *stats = &p->stats;
+	uint32_t bin_ticks = p->period_ticks >> PPL_STATS_BIN_SHIFT;
+	uint32_t latency = 0;
+	uint32_t exec;
+
+	exec = platform_timer_get(platform_timer) - start;
+	if (start > p->pipe_task.start)
+		latency = start - p->pipe_task.start;
+
+	if (!stats->count || headroom < stats->headroom_min)
+		stats->headroom_min = headroom;
+	if (latency > stats->latency_max)
+		stats->latency_max = latency;
+	if (exec > stats->exec_max)
+		stats->exec_max = exec;
+	if (latency + exec > p->period_ticks)
+		stats->misses++;
+
+	if (bin_ticks) {
+		stats->latency_hist[MIN(latency / bin_ticks,
+					PPL_STATS_BINS - 1)]++;
+		stats->exec_hist[MIN(exec / bin_ticks, PPL_STATS_BINS - 1)]++;
+	}
+
+	stats->count++;
+}
+
 static uint64_t pipeline_task(void *arg)
 {
 	struct pipeline *p = arg;
+	uint64_t start = platform_timer_get(platform_timer);
+	uint32_t headroom;
 	int err;
 
 	tracev_pipe_with_ids(p, "pipeline_task()");
@@ -912,7 +1788,9 @@ static uint64_t pipeline_task(void *arg)
 			return 0;/* skip copy if still in xrun */
 	}
 
+	headroom = pipeline_dai_headroom(p);
 	err = pipeline_copy(p);
+	pipeline_stats_update(p, start, headroom);
 	if (err < 0) {
 		/* try to recover */
 		err = pipeline_xrun_recover(p);
@@ -923,5 +1801,5 @@ static uint64_t pipeline_task(void *arg)
 	}
 
 	tracev_pipe("pipeline_task() sched");
-	return p->ipc_pipe.period;
+	return pipeline_task_period(p);
 }
@@ -366,6 +366,24 @@ static int selector_copy(struct comp_dev *dev)
 	return 0;
 }
 
+/**
+ * \brief Processes frames without updating buffer positions.
+ * \param[in,out] dev Selector base component device.
+ * \param[in] source Source buffer.
+ * \param[in,out] sink Sink buffer.
+ * \param[in] frames Number of frames to process.
+ * \return Error code.
+ */
+static int selector_process(struct comp_dev *dev, struct comp_buffer *source,
+			    struct comp_buffer *sink, uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+
+	cd->sel_func(dev, sink, source, frames);
+
+	return 0;
+}
+
 /**
  * \brief Prepares selector component for processing.
  * \param[in,out] dev Selector base component device.
@@ -506,6 +524,7 @@ static void selector_cache(struct comp_dev *dev, int cmd)
 /** \brief Selector component definition. */
 struct comp_driver comp_selector = {
 	.type	= SOF_COMP_SELECTOR,
+	.flags	= COMP_DRV_INPLACE | COMP_DRV_KEEP_STATE,
 	.ops	= {
 		.new		= selector_new,
 		.free		= selector_free,
@@ -513,6 +532,7 @@ struct comp_driver comp_selector = {
 		.cmd		= selector_cmd,
 		.trigger	= selector_trigger,
 		.copy		= selector_copy,
+		.process	= selector_process,
 		.prepare	= selector_prepare,
 		.reset		= selector_reset,
 		.cache		= selector_cache,
@@ -47,16 +47,25 @@ static void sel_s16le_1ch(struct comp_dev *dev, struct comp_buffer *sink,
 			  struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int16_t *src;
-	int16_t *dest;
-	uint32_t i;
-	uint32_t j = 0;
 	uint32_t nch = cd->config.in_channels_count;
+	int16_t *src = buffer_read_frag_s16(source, cd->config.sel_channel);
+	int16_t *dest = sink->w_ptr;
+	uint32_t n;
+	uint32_t i;
+
+	while (frames) {
+		/* selected samples in source until wrap, rounded up */
+		n = buffer_samples_without_wrap_s16(source, src);
+		n = (n + nch - 1) / nch;
+		n = MIN(n, buffer_samples_without_wrap_s16(sink, dest));
+		n = MIN(n, frames);
+
+		for (i = 0; i < n; i++)
+			dest[i] = src[i * nch];
 
-	for (i = cd->config.sel_channel; i < frames * nch; i += nch) {
-		src = buffer_read_frag_s16(source, i);
-		dest = buffer_write_frag_s16(sink, j++);
-		*dest = *src;
+		frames -= n;
+		src = buffer_wrap(source, src + n * nch);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -71,16 +80,25 @@ static void sel_s32le_1ch(struct comp_dev *dev, struct comp_buffer *sink,
 			  struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int32_t *dest;
-	uint32_t i;
-	uint32_t j = 0;
 	uint32_t nch = cd->config.in_channels_count;
+	int32_t *src = buffer_read_frag_s32(source, cd->config.sel_channel);
+	int32_t *dest = sink->w_ptr;
+	uint32_t n;
+	uint32_t i;
+
+	while (frames) {
+		/* selected samples in source until wrap, rounded up */
+		n = buffer_samples_without_wrap_s32(source, src);
+		n = (n + nch - 1) / nch;
+		n = MIN(n, buffer_samples_without_wrap_s32(sink, dest));
+		n = MIN(n, frames);
 
-	for (i = cd->config.sel_channel; i < frames * nch; i += nch) {
-		src = buffer_read_frag_s32(source, i);
-		dest = buffer_write_frag_s32(sink, j++);
-		*dest = *src;
+		for (i = 0; i < n; i++)
+			dest[i] = src[i * nch];
+
+		frames -= n;
+		src = buffer_wrap(source, src + n * nch);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -95,19 +113,24 @@ static void sel_s16le_nch(struct comp_dev *dev, struct comp_buffer *sink,
 			  struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int16_t *src;
-	int16_t *dest;
+	int16_t *src = source->r_ptr;
+	int16_t *dest = sink->w_ptr;
+	uint32_t samples = frames * cd->config.in_channels_count;
+	uint32_t n;
 	uint32_t i;
-	uint32_t j = 0;
-	uint32_t channel;
-
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < cd->config.in_channels_count; channel++) {
-			src = buffer_read_frag_s16(source, j);
-			dest = buffer_write_frag_s16(sink, j);
-			*dest = *src;
-			j++;
-		}
+
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s16(source, src),
+			buffer_samples_without_wrap_s16(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++)
+			dest[i] = src[i];
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -122,19 +145,24 @@ static void sel_s32le_nch(struct comp_dev *dev, struct comp_buffer *sink,
 			  struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int32_t *dest;
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	uint32_t samples = frames * cd->config.in_channels_count;
+	uint32_t n;
 	uint32_t i;
-	uint32_t j = 0;
-	uint32_t channel;
-
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < cd->config.in_channels_count; channel++) {
-			src = buffer_read_frag_s32(source, j);
-			dest = buffer_write_frag_s32(sink, j);
-			*dest = *src;
-			j++;
-		}
+
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s32(source, src),
+			buffer_samples_without_wrap_s32(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++)
+			dest[i] = src[i];
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
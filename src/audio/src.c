@@ -573,8 +573,7 @@ static void src_free(struct comp_dev *dev)
 	trace_src("src_free()");
 
 	/* Free dynamically reserved buffers for SRC algorithm */
-	if (cd->delay_lines)
-		rfree(cd->delay_lines);
+	comp_arena_free(dev, cd->delay_lines);
 
 	rfree(cd);
 	rfree(dev);
@@ -638,12 +637,10 @@ static int src_params(struct comp_dev *dev)
 		return -EINVAL;
 	}
 
-	/* free any existing delay lines. TODO reuse if same size */
-	if (cd->delay_lines)
-		rfree(cd->delay_lines);
+	/* free any existing delay lines, arena reuses them if same size */
+	comp_arena_free(dev, cd->delay_lines);
 
-	cd->delay_lines = rballoc(RZONE_BUFFER, SOF_MEM_CAPS_RAM,
-				  delay_lines_size);
+	cd->delay_lines = comp_arena_alloc(dev, delay_lines_size);
 	if (!cd->delay_lines) {
 		trace_src_error("src_params() error: "
 				"failed to alloc cd->delay_lines, "
@@ -651,8 +648,6 @@ static int src_params(struct comp_dev *dev)
 		return -EINVAL;
 	}
 
-	/* Clear all delay lines here */
-	memset(cd->delay_lines, 0, delay_lines_size);
 	buffer_start = cd->delay_lines + cd->param.sbuf_length;
 
 	/* Initialize SRC for actual sample rate */
@@ -927,6 +922,10 @@ static int src_reset(struct comp_dev *dev)
 	cd->src_func = src_fallback;
 	src_polyphase_reset(&cd->src);
 
+	/* delay lines are allocated again by next params */
+	comp_arena_free(dev, cd->delay_lines);
+	cd->delay_lines = NULL;
+
 	comp_set_state(dev, COMP_TRIGGER_RESET);
 	return 0;
 }
@@ -493,6 +493,24 @@ static int volume_copy(struct comp_dev *dev)
 	return 0;
 }
 
+/**
+ * \brief Processes frames without updating buffer positions.
+ * \param[in,out] dev Volume base component device.
+ * \param[in] source Source buffer.
+ * \param[in,out] sink Sink buffer.
+ * \param[in] frames Number of frames to process.
+ * \return Error code.
+ */
+static int volume_process(struct comp_dev *dev, struct comp_buffer *source,
+			  struct comp_buffer *sink, uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+
+	cd->scale_vol(dev, sink, source, frames);
+
+	return 0;
+}
+
 /**
  * \brief Prepares volume component for processing.
  * \param[in,out] dev Volume base component device.
@@ -637,6 +655,7 @@ static void volume_cache(struct comp_dev *dev, int cmd)
 /** \brief Volume component definition. */
 struct comp_driver comp_volume = {
 	.type	= SOF_COMP_VOLUME,
+	.flags	= COMP_DRV_INPLACE | COMP_DRV_KEEP_STATE,
 	.ops	= {
 		.new		= volume_new,
 		.free		= volume_free,
@@ -644,6 +663,7 @@ struct comp_driver comp_volume = {
 		.cmd		= volume_cmd,
 		.trigger	= volume_trigger,
 		.copy		= volume_copy,
+		.process	= volume_process,
 		.prepare	= volume_prepare,
 		.reset		= volume_reset,
 		.cache		= volume_cache,
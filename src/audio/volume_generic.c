@@ -124,24 +124,32 @@ static void vol_s16_to_s32(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int16_t *src;
-	int32_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int16_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.15 --> Q1.31 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s16(source, buff_frag);
-			dest = buffer_write_frag_s32(sink, buff_frag);
-			*dest = q_multsr_sat_32x32
-				(*src << 8, cd->volume[channel],
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s16(source, src),
+			buffer_samples_without_wrap_s32(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = q_multsr_sat_32x32
+				(src[i] << 8, cd->volume[channel],
 				 Q_SHIFT_BITS_64(23, 16, 31));
-
-
-			buff_frag++;
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -159,22 +167,31 @@ static void vol_s32_to_s16(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int16_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t *src = source->r_ptr;
+	int16_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.31 --> Q1.15 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s32(source, buff_frag);
-			dest = buffer_write_frag_s16(sink, buff_frag);
-
-			*dest = vol_mult_s32_to_s16(*src, cd->volume[channel]);
-
-			buff_frag++;
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s32(source, src),
+			buffer_samples_without_wrap_s16(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = vol_mult_s32_to_s16(src[i],
+						      cd->volume[channel]);
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -192,24 +209,32 @@ static void vol_s32_to_s32(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int32_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.31 --> Q1.31 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s32(source, buff_frag);
-			dest = buffer_write_frag_s32(sink, buff_frag);
-
-			*dest = q_multsr_sat_32x32
-				(*src, cd->volume[channel],
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s32(source, src),
+			buffer_samples_without_wrap_s32(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = q_multsr_sat_32x32
+				(src[i], cd->volume[channel],
 				 Q_SHIFT_BITS_64(31, 16, 31));
-
-			buff_frag++;
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -227,24 +252,32 @@ static void vol_s16_to_s16(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int16_t *src;
-	int16_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int16_t *src = source->r_ptr;
+	int16_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.15 --> Q1.15 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s16(source, buff_frag);
-			dest = buffer_write_frag_s16(sink, buff_frag);
-
-			*dest = q_multsr_sat_32x32_16
-				(*src, cd->volume[channel],
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s16(source, src),
+			buffer_samples_without_wrap_s16(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = q_multsr_sat_32x32_16
+				(src[i], cd->volume[channel],
 				 Q_SHIFT_BITS_32(15, 16, 15));
-
-			buff_frag++;
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -262,22 +295,31 @@ static void vol_s16_to_s24(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int16_t *src;
-	int32_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int16_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.15 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s16(source, buff_frag);
-			dest = buffer_write_frag_s32(sink, buff_frag);
-
-			*dest = vol_mult_s16_to_s24(*src, cd->volume[channel]);
-
-			buff_frag++;
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s16(source, src),
+			buffer_samples_without_wrap_s32(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = vol_mult_s16_to_s24(src[i],
+						      cd->volume[channel]);
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -295,22 +337,31 @@ static void vol_s24_to_s16(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int16_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t *src = source->r_ptr;
+	int16_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.23 --> Q1.15 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s32(source, buff_frag);
-			dest = buffer_write_frag_s16(sink, buff_frag);
-
-			*dest = vol_mult_s24_to_s16(*src, cd->volume[channel]);
-
-			buff_frag++;
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s32(source, src),
+			buffer_samples_without_wrap_s16(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = vol_mult_s24_to_s16(src[i],
+						      cd->volume[channel]);
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -328,22 +379,31 @@ static void vol_s32_to_s24(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int32_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.31 --> Q1.23 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s32(source, buff_frag);
-			dest = buffer_write_frag_s32(sink, buff_frag);
-
-			*dest = vol_mult_s32_to_s24(*src, cd->volume[channel]);
-
-			buff_frag++;
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s32(source, src),
+			buffer_samples_without_wrap_s32(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = vol_mult_s32_to_s24(src[i],
+						      cd->volume[channel]);
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -361,24 +421,32 @@ static void vol_s24_to_s32(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int32_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.23 --> Q1.31 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s32(source, buff_frag);
-			dest = buffer_write_frag_s32(sink, buff_frag);
-
-			*dest = q_multsr_sat_32x32
-				(sign_extend_s24(*src), cd->volume[channel],
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s32(source, src),
+			buffer_samples_without_wrap_s32(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = q_multsr_sat_32x32
+				(sign_extend_s24(src[i]), cd->volume[channel],
 				 Q_SHIFT_BITS_64(23, 16, 31));
-
-			buff_frag++;
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
@@ -396,22 +464,31 @@ static void vol_s24_to_s24(struct comp_dev *dev, struct comp_buffer *sink,
 			   struct comp_buffer *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int32_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	uint32_t nch = dev->params.channels;
+	uint32_t samples = frames * nch;
+	uint32_t channel = 0;
+	uint32_t n;
+	uint32_t i;
 
 	/* Samples are Q1.23 --> Q1.23 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < dev->params.channels; channel++) {
-			src = buffer_read_frag_s32(source, buff_frag);
-			dest = buffer_write_frag_s32(sink, buff_frag);
-
-			*dest = vol_mult_s24_to_s24(*src, cd->volume[channel]);
-
-			buff_frag++;
+	while (samples) {
+		/* process linear part until either of the buffers wraps */
+		n = MIN(buffer_samples_without_wrap_s32(source, src),
+			buffer_samples_without_wrap_s32(sink, dest));
+		n = MIN(n, samples);
+
+		for (i = 0; i < n; i++) {
+			dest[i] = vol_mult_s24_to_s24(src[i],
+						      cd->volume[channel]);
+			if (++channel == nch)
+				channel = 0;
 		}
+
+		samples -= n;
+		src = buffer_wrap(source, src + n);
+		dest = buffer_wrap(sink, dest + n);
 	}
 }
 
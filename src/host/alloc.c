@@ -35,29 +35,134 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
 #include <sof/alloc.h>
 #include "host/common_test.h"
 
 /* testbench mem alloc definition */
 
+/* allocations are prefixed with their zone and size for heap statistics */
+struct host_block {
+	void *base;	/* start of allocated memory */
+	uint32_t zone;
+	uint32_t bytes;
+};
+
+/* minimum alignment of allocations, also the size of their prefix */
+#define HOST_BLOCK_ALIGN	16
+
+/* one heap per zone type */
+static struct mm_info host_heap[RZONE_TYPES];
+static struct mm_fail host_fail[RZONE_TYPES];
+
+/* statistics are updated from all scheduler worker threads */
+static pthread_mutex_t host_heap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *host_alloc(int zone, uint32_t caps, size_t bytes,
+			uint32_t alignment)
+{
+	int type = __builtin_ctz(zone & RZONE_TYPE_MASK);
+	struct mm_info *info = &host_heap[type];
+	struct host_block *block;
+	size_t prefix = HOST_BLOCK_ALIGN;
+	void *base;
+
+	if (alignment > prefix)
+		prefix = alignment;
+
+	if (posix_memalign(&base, prefix, prefix + bytes)) {
+		pthread_mutex_lock(&host_heap_lock);
+		host_fail[type].count++;
+		host_fail[type].caps = caps;
+		host_fail[type].bytes = bytes;
+		pthread_mutex_unlock(&host_heap_lock);
+		return NULL;
+	}
+
+	block = (struct host_block *)((char *)base + prefix) - 1;
+	block->base = base;
+	block->zone = type;
+	block->bytes = bytes;
+
+	pthread_mutex_lock(&host_heap_lock);
+	info->used += bytes;
+	if (info->used > info->peak)
+		info->peak = info->used;
+	pthread_mutex_unlock(&host_heap_lock);
+
+	return block + 1;
+}
+
 void *rmalloc(int zone, uint32_t caps, size_t bytes)
 {
-	return malloc(bytes);
+	return host_alloc(zone, caps, bytes, 0);
 }
 
 void *rzalloc(int zone, uint32_t caps, size_t bytes)
 {
-	return calloc(bytes, 1);
+	void *ptr = host_alloc(zone, caps, bytes, 0);
+
+	if (ptr)
+		memset(ptr, 0, bytes);
+
+	return ptr;
+}
+
+void *rzalloc_align(int zone, uint32_t caps, size_t bytes, uint32_t alignment)
+{
+	void *ptr = host_alloc(zone, caps, bytes, alignment);
+
+	if (ptr)
+		memset(ptr, 0, bytes);
+
+	return ptr;
 }
 
 void rfree(void *ptr)
 {
-	free(ptr);
+	struct host_block *block;
+
+	if (!ptr)
+		return;
+
+	block = (struct host_block *)ptr - 1;
+	pthread_mutex_lock(&host_heap_lock);
+	host_heap[block->zone].used -= block->bytes;
+	pthread_mutex_unlock(&host_heap_lock);
+	free(block->base);
 }
 
 void *rballoc(int zone, uint32_t caps, size_t bytes)
 {
-	return malloc(bytes);
+	return host_alloc(zone, caps, bytes, 0);
+}
+
+void *rballoc_align(int zone, uint32_t caps, size_t bytes, uint32_t alignment)
+{
+	return host_alloc(zone, caps, bytes, alignment);
+}
+
+void *rrealloc(void *ptr, int zone, uint32_t caps, size_t bytes)
+{
+	struct host_block *block;
+	void *new_ptr;
+
+	if (!ptr)
+		return host_alloc(zone, caps, bytes, 0);
+
+	block = (struct host_block *)ptr - 1;
+	if (block->bytes >= bytes)
+		return ptr;
+
+	new_ptr = host_alloc(zone, caps, bytes, 0);
+	if (new_ptr) {
+		memcpy(new_ptr, ptr, block->bytes);
+		rfree(ptr);
+	}
+
+	return new_ptr;
 }
 
 void heap_trace(struct mm_heap *heap, int size)
@@ -69,3 +174,34 @@ void heap_trace_all(int force)
 {
 	heap_trace(NULL, 0);
 }
+
+/* host heap is not limited, there's nothing to reclaim for */
+void heap_set_buffer_reclaim(int (*reclaim)(void))
+{
+}
+
+int heap_stats(int zone, int index, struct mm_heap_stats *stats)
+{
+	int type = __builtin_ctz(zone & RZONE_TYPE_MASK);
+
+	if (!(zone & RZONE_TYPE_MASK) || index != 0)
+		return -EINVAL;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->heaps = 1;
+	stats->used = host_heap[type].used;
+	stats->peak = host_heap[type].peak;
+	stats->fail = host_fail[type];
+
+	return 0;
+}
+
+void heap_stats_reset(void)
+{
+	int i;
+
+	for (i = 0; i < RZONE_TYPES; i++)
+		host_heap[i].peak = host_heap[i].used;
+
+	memset(host_fail, 0, sizeof(host_fail));
+}
@@ -58,6 +58,9 @@ int tb_pipeline_setup(struct sof *sof)
 	/* init components */
 	sys_comp_init();
 
+	/* init buffer reuse pool */
+	sys_buffer_init();
+
 	/* init IPC */
 	if (ipc_init(sof) < 0) {
 		fprintf(stderr, "error: IPC init\n");
@@ -33,6 +33,9 @@
 #include <stdint.h>
 #include <sof/edf_schedule.h>
 #include <sof/wait.h>
+#include <platform/timer.h>
+#include <platform/platform.h>
+#include "host/schedule.h"
 
  /* scheduler testbench definition */
 
@@ -64,10 +67,26 @@ static void schedule_edf_task_complete(struct task *task)
 static void schedule_edf_task(struct task *task, uint64_t start,
 			      uint64_t deadline, uint32_t flags)
 {
-	(void)deadline;
+	uint64_t current = platform_timer_get(platform_timer);
+
+	/* queue task on its core worker, start is relative to last start */
+	if (host_schedule_threaded()) {
+		if (start)
+			start = task->start + host_schedule_us_to_ticks(start);
+		else
+			start = current;
+
+		deadline = start + host_schedule_us_to_ticks(deadline);
+		host_schedule_queue(task, start, deadline);
+		return;
+	}
+
 	list_item_prepend(&task->list, &sch->list);
 	task->state = SOF_TASK_STATE_QUEUED;
 
+	/* task is dispatched immediately */
+	task->start = current;
+
 	if (task->func)
 		task->func(task->data);
 
@@ -108,6 +127,11 @@ static void schedule_edf(void)
 
 static int schedule_edf_task_cancel(struct task *task)
 {
+	if (host_schedule_threaded()) {
+		host_schedule_cancel(task);
+		return 0;
+	}
+
 	if (task->state == SOF_TASK_STATE_QUEUED) {
 		/* delete task */
 		task->state = SOF_TASK_STATE_CANCEL;
@@ -451,7 +451,7 @@ static struct comp_dev *file_new(struct sof_ipc_comp *comp)
 	/* allocate  memory for file comp data */
 	cd = rzalloc(RZONE_RUNTIME, SOF_MEM_CAPS_RAM, sizeof(*cd));
 	if (!cd) {
-		free(dev);
+		rfree(dev);
 		return NULL;
 	}
 
@@ -475,8 +475,8 @@ static struct comp_dev *file_new(struct sof_ipc_comp *comp)
 		cd->fs.rfh = fopen(cd->fs.fn, "r");
 		if (!cd->fs.rfh) {
 			fprintf(stderr, "error: opening file %s\n", cd->fs.fn);
-			free(cd);
-			free(dev);
+			rfree(cd);
+			rfree(dev);
 			return NULL;
 		}
 		break;
@@ -484,8 +484,8 @@ static struct comp_dev *file_new(struct sof_ipc_comp *comp)
 		cd->fs.wfh = fopen(cd->fs.fn, "w");
 		if (!cd->fs.wfh) {
 			fprintf(stderr, "error: opening file %s\n", cd->fs.fn);
-			free(cd);
-			free(dev);
+			rfree(cd);
+			rfree(dev);
 			return NULL;
 		}
 		break;
@@ -512,8 +512,8 @@ static void file_free(struct comp_dev *dev)
 		fclose(cd->fs.wfh);
 
 	free(cd->fs.fn);
-	free(cd);
-	free(dev);
+	rfree(cd);
+	rfree(dev);
 
 	debug_print("free file component\n");
 }
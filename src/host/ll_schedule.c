@@ -32,18 +32,68 @@
 #include <sof/task.h>
 #include <stdint.h>
 #include <sof/wait.h>
+#include <platform/timer.h>
+#include <platform/platform.h>
+#include "host/schedule.h"
+
+/*
+ * LL tasks run only on worker threads, where they are rescheduled after the
+ * period returned by the task function. Without workers they are not run.
+ */
+
+static void schedule_ll_task(struct task *task, uint64_t start,
+			     uint64_t deadline, uint32_t flags)
+{
+	(void)deadline;
+	(void)flags;
+
+	if (!host_schedule_threaded())
+		return;
+
+	host_schedule_queue(task, platform_timer_get(platform_timer) +
+			    host_schedule_us_to_ticks(start), 0);
+}
+
+static void reschedule_ll_task(struct task *task, uint64_t start)
+{
+	if (!host_schedule_threaded())
+		return;
+
+	host_schedule_requeue(task, platform_timer_get(platform_timer) +
+			      host_schedule_us_to_ticks(start));
+}
+
+static int schedule_ll_task_init(struct task *task, uint32_t xflags)
+{
+	(void)xflags;
+
+	return 0;
+}
+
+static int schedule_ll_task_cancel(struct task *task)
+{
+	if (host_schedule_threaded())
+		host_schedule_cancel(task);
+
+	return 0;
+}
+
+static void schedule_ll_task_free(struct task *task)
+{
+	task->state = SOF_TASK_STATE_FREE;
+	task->func = NULL;
+	task->data = NULL;
+}
 
-/* TODO: Make host ll ops implementation */
 struct scheduler_ops schedule_ll_ops = {
-	.schedule_task = NULL,
-	.schedule_task_init = NULL,
-	.schedule_task_running = NULL,
-	.schedule_task_complete = NULL,
-	.reschedule_task = NULL,
-	.schedule_task_cancel = NULL,
-	.schedule_task_free = NULL,
-	.scheduler_init = NULL,
-	.scheduler_free = NULL,
-	.scheduler_run = NULL
+	.schedule_task		= schedule_ll_task,
+	.schedule_task_init	= schedule_ll_task_init,
+	.schedule_task_running	= NULL,
+	.schedule_task_complete	= NULL,
+	.reschedule_task	= reschedule_ll_task,
+	.schedule_task_cancel	= schedule_ll_task_cancel,
+	.schedule_task_free	= schedule_ll_task_free,
+	.scheduler_init		= NULL,
+	.scheduler_free		= NULL,
+	.scheduler_run		= NULL
 };
-
@@ -32,11 +32,45 @@
  */
 
 #include <sof/audio/component.h>
+#include <sof/edf_schedule.h>
 #include <sof/task.h>
 #include <stdint.h>
+#include <pthread.h>
+#include <time.h>
 #include <sof/wait.h>
+#include <sof/clk.h>
+#include <platform/clk.h>
+#include <platform/platform.h>
+#include <platform/timer.h>
 #include "host/edf_schedule.h"
 #include "host/ll_schedule.h"
+#include "host/schedule.h"
+
+/* core emulated by the calling thread, main thread is core 0 */
+__thread int host_cpu_id;
+
+/* worker thread emulating one core */
+struct host_core {
+	pthread_t thread;
+	pthread_cond_t cond;		/* signalled when queue changes */
+	struct list_item tasks;		/* tasks queued on this core */
+	int id;
+	struct host_core_stats stats;	/* simulation statistics */
+};
+
+/* all queues share one lock, tasks are run without holding it */
+static struct host_schedule_data {
+	pthread_mutex_t lock;
+	pthread_cond_t done;		/* signalled after every task run */
+	struct host_core core[HOST_MAX_CORES];
+	int cores;			/* number of worker threads */
+	bool stop;
+	bool sim;			/* cores are simulated, no threads */
+	uint32_t sim_mhz;		/* simulated core clock */
+} host_sch = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.done = PTHREAD_COND_INITIALIZER,
+};
 
 static const struct scheduler_ops *schedulers[SOF_SCHEDULE_COUNT] = {
 	&schedule_edf_ops,              /* SOF_SCHEDULE_EDF */
@@ -126,3 +160,416 @@ void schedule(void)
 			schedulers[i]->scheduler_run();
 	}
 }
+
+uint64_t host_schedule_us_to_ticks(uint64_t us)
+{
+	return clock_ms_to_ticks(PLATFORM_WORKQ_CLOCK, 1) * us / 1000;
+}
+
+static inline struct host_core *host_task_core(struct task *task)
+{
+	return &host_sch.core[task->core % host_sch.cores];
+}
+
+static inline uint64_t host_task_deadline(struct task *task)
+{
+	struct edf_task_pdata *edf_pdata;
+
+	if (task->type != SOF_SCHEDULE_EDF)
+		return 0;
+
+	edf_pdata = edf_sch_get_pdata(task);
+	return edf_pdata->deadline;
+}
+
+/* LL tasks go first like timer IRQ work, then priority and deadline */
+static bool host_task_before(struct task *a, struct task *b)
+{
+	if (a->type != b->type)
+		return a->type == SOF_SCHEDULE_LL;
+
+	if (a->priority != b->priority)
+		return a->priority < b->priority;
+
+	return host_task_deadline(a) < host_task_deadline(b);
+}
+
+/* get next due task of core, wake is set to the earliest future start */
+static struct task *host_core_next(struct host_core *core, uint64_t current,
+				   uint64_t *wake)
+{
+	struct list_item *tlist;
+	struct task *task;
+	struct task *next = NULL;
+
+	*wake = UINT64_MAX;
+
+	list_for_item(tlist, &core->tasks) {
+		task = container_of(tlist, struct task, list);
+
+		if (task->start > current) {
+			if (task->start < *wake)
+				*wake = task->start;
+			continue;
+		}
+
+		if (!next || host_task_before(task, next))
+			next = task;
+	}
+
+	return next;
+}
+
+static void host_core_wait(struct host_core *core, uint64_t wake)
+{
+	struct timespec ts;
+
+	if (wake == UINT64_MAX) {
+		pthread_cond_wait(&core->cond, &host_sch.lock);
+		return;
+	}
+
+	/* host timer ticks are nanoseconds of the monotonic clock */
+	ts.tv_sec = wake / 1000000000;
+	ts.tv_nsec = wake % 1000000000;
+	pthread_cond_timedwait(&core->cond, &host_sch.lock, &ts);
+}
+
+/* run task on core, called and returns with scheduler lock held */
+static void host_core_run_task(struct host_core *core, struct task *task)
+{
+	uint64_t next_us;
+
+	list_item_del(&task->list);
+	task->state = SOF_TASK_STATE_RUNNING;
+
+	pthread_mutex_unlock(&host_sch.lock);
+	next_us = task->func ? task->func(task->data) : 0;
+	pthread_mutex_lock(&host_sch.lock);
+
+	/* task was cancelled or queued again while running */
+	if (task->state != SOF_TASK_STATE_RUNNING)
+		return;
+
+	/* LL tasks run again after the period they return */
+	if (task->type == SOF_SCHEDULE_LL && next_us) {
+		task->start += host_schedule_us_to_ticks(next_us);
+		task->state = SOF_TASK_STATE_QUEUED;
+		list_item_append(&task->list, &core->tasks);
+	} else {
+		task->state = SOF_TASK_STATE_COMPLETED;
+	}
+}
+
+static void *host_core_run(void *arg)
+{
+	struct host_core *core = arg;
+	struct task *task;
+	uint64_t wake;
+
+	host_cpu_id = core->id;
+
+	pthread_mutex_lock(&host_sch.lock);
+
+	while (!host_sch.stop) {
+		task = host_core_next(core, platform_timer_get(platform_timer),
+				      &wake);
+		if (!task) {
+			host_core_wait(core, wake);
+			continue;
+		}
+
+		host_core_run_task(core, task);
+		pthread_cond_broadcast(&host_sch.done);
+	}
+
+	pthread_mutex_unlock(&host_sch.lock);
+
+	return NULL;
+}
+
+int host_schedule_start(int cores)
+{
+	pthread_condattr_t attr;
+	struct host_core *core;
+	int ret = 0;
+	int i;
+
+	if (cores <= 0 || cores > HOST_MAX_CORES)
+		return -EINVAL;
+
+	/* timed waits use the same clock as the host timer */
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+	host_sch.stop = false;
+
+	for (i = 0; i < cores; i++) {
+		core = &host_sch.core[i];
+		core->id = i;
+		list_init(&core->tasks);
+		pthread_cond_init(&core->cond, &attr);
+	}
+
+	/* tasks are only queued once all cores are up */
+	pthread_mutex_lock(&host_sch.lock);
+
+	for (i = 0; i < cores; i++) {
+		ret = -pthread_create(&host_sch.core[i].thread, NULL,
+				      host_core_run, &host_sch.core[i]);
+		if (ret < 0)
+			break;
+	}
+
+	host_sch.cores = i;
+	host_sch.stop = ret < 0;
+
+	pthread_mutex_unlock(&host_sch.lock);
+	pthread_condattr_destroy(&attr);
+
+	if (ret < 0)
+		host_schedule_stop();
+
+	return ret;
+}
+
+void host_schedule_stop(void)
+{
+	int cores = host_sch.cores;
+	int i;
+
+	/* simulated cores have no threads */
+	if (host_sch.sim) {
+		host_sch.sim = false;
+		host_sch.cores = 0;
+		return;
+	}
+
+	pthread_mutex_lock(&host_sch.lock);
+	host_sch.stop = true;
+	for (i = 0; i < cores; i++)
+		pthread_cond_signal(&host_sch.core[i].cond);
+	pthread_mutex_unlock(&host_sch.lock);
+
+	for (i = 0; i < cores; i++) {
+		pthread_join(host_sch.core[i].thread, NULL);
+		pthread_cond_destroy(&host_sch.core[i].cond);
+	}
+
+	host_sch.cores = 0;
+}
+
+bool host_schedule_threaded(void)
+{
+	return host_sch.cores > 0;
+}
+
+int host_schedule_queue(struct task *task, uint64_t start, uint64_t deadline)
+{
+	struct edf_task_pdata *edf_pdata;
+	struct host_core *core;
+	int ret = 0;
+
+	pthread_mutex_lock(&host_sch.lock);
+
+	if (task->state == SOF_TASK_STATE_QUEUED) {
+		ret = -EALREADY;
+		goto out;
+	}
+
+	task->start = start;
+	if (task->type == SOF_SCHEDULE_EDF) {
+		edf_pdata = edf_sch_get_pdata(task);
+		edf_pdata->deadline = deadline;
+	}
+
+	core = host_task_core(task);
+	task->state = SOF_TASK_STATE_QUEUED;
+	list_item_append(&task->list, &core->tasks);
+	pthread_cond_signal(&core->cond);
+
+out:
+	pthread_mutex_unlock(&host_sch.lock);
+
+	return ret;
+}
+
+void host_schedule_requeue(struct task *task, uint64_t start)
+{
+	struct host_core *core = host_task_core(task);
+
+	pthread_mutex_lock(&host_sch.lock);
+
+	if (task->state != SOF_TASK_STATE_QUEUED) {
+		task->state = SOF_TASK_STATE_QUEUED;
+		list_item_append(&task->list, &core->tasks);
+	}
+
+	task->start = start;
+	pthread_cond_signal(&core->cond);
+
+	pthread_mutex_unlock(&host_sch.lock);
+}
+
+void host_schedule_cancel(struct task *task)
+{
+	pthread_mutex_lock(&host_sch.lock);
+
+	if (task->state == SOF_TASK_STATE_QUEUED)
+		list_item_del(&task->list);
+
+	if (task->state == SOF_TASK_STATE_QUEUED ||
+	    task->state == SOF_TASK_STATE_RUNNING)
+		task->state = SOF_TASK_STATE_CANCEL;
+
+	pthread_cond_broadcast(&host_sch.done);
+
+	pthread_mutex_unlock(&host_sch.lock);
+}
+
+/* get next task of simulated core and the virtual time it can start at */
+static struct task *host_sim_next(struct host_core *core, uint64_t *start)
+{
+	struct task *task;
+	uint64_t current = host_timer_sim_get(core->id);
+	uint64_t wake;
+
+	task = host_core_next(core, current, &wake);
+	if (task) {
+		*start = current;
+		return task;
+	}
+
+	/* idle core jumps to its next task start */
+	if (wake == UINT64_MAX)
+		return NULL;
+
+	*start = wake;
+	return host_core_next(core, wake, &wake);
+}
+
+/* task ran past its deadline or, for LL tasks, into its next period */
+static bool host_sim_missed(struct task *task, uint64_t end)
+{
+	if (task->type == SOF_SCHEDULE_EDF)
+		return end > host_task_deadline(task);
+
+	return task->state == SOF_TASK_STATE_QUEUED && end > task->start;
+}
+
+/*
+ * Runs simulated cores in virtual time until done() returns true or no task
+ * is left. The task that can start earliest on any core always runs next,
+ * so the result doesn't depend on host timing.
+ */
+static void host_sim_run(bool (*done)(void *data), void *data)
+{
+	struct host_core *core;
+	struct host_core *next_core;
+	struct task *task;
+	struct task *next_task;
+	uint64_t next_start;
+	uint64_t start;
+	uint64_t end;
+	int cpu_id = host_cpu_id;
+	int i;
+
+	while (!done(data)) {
+		next_task = NULL;
+		next_start = UINT64_MAX;
+		next_core = NULL;
+
+		for (i = 0; i < host_sch.cores; i++) {
+			core = &host_sch.core[i];
+			task = host_sim_next(core, &start);
+			if (task && start < next_start) {
+				next_task = task;
+				next_start = start;
+				next_core = core;
+			}
+		}
+
+		/* nothing left to run */
+		if (!next_task)
+			break;
+
+		/* run task, cycles charged by it advance the core clock */
+		host_cpu_id = next_core->id;
+		host_timer_sim_set(next_core->id, next_start);
+		host_core_run_task(next_core, next_task);
+		end = host_timer_sim_get(next_core->id);
+
+		next_core->stats.busy += end - next_start;
+		next_core->stats.runs++;
+		if (host_sim_missed(next_task, end))
+			next_core->stats.misses++;
+	}
+
+	host_cpu_id = cpu_id;
+}
+
+int host_schedule_sim_start(int cores, uint32_t mhz)
+{
+	int i;
+
+	if (cores <= 0 || cores > HOST_MAX_CORES || !mhz)
+		return -EINVAL;
+
+	for (i = 0; i < cores; i++) {
+		host_sch.core[i].id = i;
+		list_init(&host_sch.core[i].tasks);
+		bzero(&host_sch.core[i].stats, sizeof(host_sch.core[i].stats));
+	}
+
+	host_timer_sim_enable();
+
+	host_sch.sim = true;
+	host_sch.sim_mhz = mhz;
+	host_sch.cores = cores;
+
+	return 0;
+}
+
+void host_schedule_sim_charge(uint64_t cycles)
+{
+	int core = cpu_get_id();
+
+	if (!host_sch.sim)
+		return;
+
+	host_timer_sim_set(core, host_timer_sim_get(core) +
+			   cycles * 1000 / host_sch.sim_mhz);
+}
+
+int host_schedule_sim_stats(int core, struct host_core_stats *stats)
+{
+	int i;
+
+	if (!host_sch.sim || core >= host_sch.cores)
+		return -EINVAL;
+
+	*stats = host_sch.core[core].stats;
+
+	/* all cores are compared over the same virtual time */
+	stats->elapsed = 0;
+	for (i = 0; i < host_sch.cores; i++)
+		stats->elapsed = MAX(stats->elapsed, host_timer_sim_get(i));
+
+	return 0;
+}
+
+void host_schedule_wait(bool (*done)(void *data), void *data)
+{
+	pthread_mutex_lock(&host_sch.lock);
+
+	if (host_sch.sim) {
+		host_sim_run(done, data);
+		pthread_mutex_unlock(&host_sch.lock);
+		return;
+	}
+
+	while (!done(data))
+		pthread_cond_wait(&host_sch.done, &host_sch.lock);
+
+	pthread_mutex_unlock(&host_sch.lock);
+}
@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sof/audio/component.h>
+#include <sof/audio/buffer.h>
+#include <sof/ipc.h>
+#include "host/schedule.h"
+#include "host/simulation.h"
+
+/*
+ * Testbench simulation of DSP execution time. Component copy and process
+ * ops are wrapped to charge a cycle cost per frame to the virtual clock of
+ * the core they run on, and buffer fill levels are sampled after copies.
+ */
+
+/* maximum number of component drivers with wrapped ops */
+#define TB_SIM_DRIVERS	8
+
+/* cycle cost per frame of a component type */
+struct tb_sim_cost {
+	const char *name;	/* component name, as for -a option */
+	uint32_t type;		/* SOF_COMP_ type */
+	uint32_t cycles;
+};
+
+/* wrapped component driver */
+struct tb_sim_drv {
+	struct comp_driver *drv;
+	int (*copy)(struct comp_dev *dev);
+	int (*process)(struct comp_dev *dev, struct comp_buffer *source,
+		       struct comp_buffer *sink, uint32_t frames);
+	uint32_t cycles;
+};
+
+/* fill level limits of a buffer */
+struct tb_sim_buffer {
+	struct comp_buffer *buffer;
+	uint32_t min_avail;
+	uint32_t max_avail;
+};
+
+static struct tb_sim_cost tb_sim_costs[] = {
+	{"file", SOF_COMP_FILEREAD, 0},
+	{"file", SOF_COMP_FILEWRITE, 0},
+	{"vol", SOF_COMP_VOLUME, 0},
+	{"src", SOF_COMP_SRC, 0},
+};
+
+static struct tb_sim_drv tb_sim_drvs[TB_SIM_DRIVERS];
+static int tb_sim_num_drvs;
+
+static struct tb_sim_buffer *tb_sim_buffers;
+static int tb_sim_num_buffers;
+
+int tb_sim_parse_costs(char *costs)
+{
+	char *cost_token = NULL;
+	char *comp_token = NULL;
+	char *token = strtok_r(costs, ",", &cost_token);
+	char *name;
+	char *cycles;
+	int found;
+	int i;
+
+	while (token) {
+		name = strtok_r(token, "=", &comp_token);
+		cycles = strtok_r(NULL, "=", &comp_token);
+		if (!cycles) {
+			fprintf(stderr, "error: no cycles for %s\n", name);
+			return -EINVAL;
+		}
+
+		found = 0;
+		for (i = 0; i < ARRAY_SIZE(tb_sim_costs); i++) {
+			if (!strcmp(tb_sim_costs[i].name, name)) {
+				tb_sim_costs[i].cycles = atoi(cycles);
+				found = 1;
+			}
+		}
+
+		if (!found) {
+			fprintf(stderr, "error: unsupported comp type %s\n",
+				name);
+			return -EINVAL;
+		}
+
+		token = strtok_r(NULL, ",", &cost_token);
+	}
+
+	return 0;
+}
+
+static struct tb_sim_drv *tb_sim_drv_get(struct comp_driver *drv)
+{
+	int i;
+
+	for (i = 0; i < tb_sim_num_drvs; i++) {
+		if (tb_sim_drvs[i].drv == drv)
+			return &tb_sim_drvs[i];
+	}
+
+	return NULL;
+}
+
+static void tb_sim_buffer_update(struct comp_buffer *buffer)
+{
+	int i;
+
+	for (i = 0; i < tb_sim_num_buffers; i++) {
+		if (tb_sim_buffers[i].buffer != buffer)
+			continue;
+
+		if (buffer->avail < tb_sim_buffers[i].min_avail)
+			tb_sim_buffers[i].min_avail = buffer->avail;
+		if (buffer->avail > tb_sim_buffers[i].max_avail)
+			tb_sim_buffers[i].max_avail = buffer->avail;
+		return;
+	}
+}
+
+static int tb_sim_copy(struct comp_dev *dev)
+{
+	struct tb_sim_drv *sim_drv = tb_sim_drv_get(dev->drv);
+	struct comp_buffer *source = NULL;
+	struct comp_buffer *sink = NULL;
+	uint32_t frame_bytes = comp_frame_bytes(dev);
+	uint32_t bytes = 0;
+	uint32_t r_idx = 0;
+	uint32_t w_idx = 0;
+	int ret;
+
+	if (!list_is_empty(&dev->bsource_list)) {
+		source = list_first_item(&dev->bsource_list,
+					 struct comp_buffer, sink_list);
+		r_idx = atomic_read(&source->r_idx);
+	}
+
+	if (!list_is_empty(&dev->bsink_list)) {
+		sink = list_first_item(&dev->bsink_list,
+				       struct comp_buffer, source_list);
+		w_idx = atomic_read(&sink->w_idx);
+	}
+
+	ret = sim_drv->copy(dev);
+
+	/* frames consumed from source, or produced by a source component,
+	 * buffers count bytes in both SPSC and locked mode
+	 */
+	if (source)
+		bytes = atomic_read(&source->r_idx) - r_idx;
+	else if (sink)
+		bytes = atomic_read(&sink->w_idx) - w_idx;
+
+	if (frame_bytes)
+		host_schedule_sim_charge((uint64_t)sim_drv->cycles *
+					 (bytes / frame_bytes));
+
+	if (source)
+		tb_sim_buffer_update(source);
+	if (sink)
+		tb_sim_buffer_update(sink);
+
+	return ret;
+}
+
+static int tb_sim_process(struct comp_dev *dev, struct comp_buffer *source,
+			  struct comp_buffer *sink, uint32_t frames)
+{
+	struct tb_sim_drv *sim_drv = tb_sim_drv_get(dev->drv);
+	int ret;
+
+	ret = sim_drv->process(dev, source, sink, frames);
+	host_schedule_sim_charge((uint64_t)sim_drv->cycles * frames);
+
+	tb_sim_buffer_update(source);
+	tb_sim_buffer_update(sink);
+
+	return ret;
+}
+
+static int tb_sim_wrap_drv(struct comp_driver *drv)
+{
+	struct tb_sim_drv *sim_drv;
+	int i;
+
+	if (tb_sim_drv_get(drv))
+		return 0;
+
+	if (tb_sim_num_drvs == TB_SIM_DRIVERS)
+		return -ENOMEM;
+
+	sim_drv = &tb_sim_drvs[tb_sim_num_drvs++];
+	sim_drv->drv = drv;
+	sim_drv->copy = drv->ops.copy;
+	sim_drv->process = drv->ops.process;
+
+	for (i = 0; i < ARRAY_SIZE(tb_sim_costs); i++) {
+		if (tb_sim_costs[i].type == drv->type)
+			sim_drv->cycles = tb_sim_costs[i].cycles;
+	}
+
+	if (drv->ops.copy)
+		drv->ops.copy = tb_sim_copy;
+	if (drv->ops.process)
+		drv->ops.process = tb_sim_process;
+
+	return 0;
+}
+
+int tb_sim_setup(struct ipc *ipc)
+{
+	struct list_item *clist;
+	struct ipc_comp_dev *icd;
+	int buffers = 0;
+
+	list_for_item(clist, &ipc->shared_ctx->comp_list) {
+		icd = container_of(clist, struct ipc_comp_dev, list);
+		if (icd->type == COMP_TYPE_BUFFER)
+			buffers++;
+	}
+
+	tb_sim_buffers = calloc(buffers, sizeof(*tb_sim_buffers));
+	if (buffers && !tb_sim_buffers)
+		return -ENOMEM;
+
+	list_for_item(clist, &ipc->shared_ctx->comp_list) {
+		icd = container_of(clist, struct ipc_comp_dev, list);
+		switch (icd->type) {
+		case COMP_TYPE_COMPONENT:
+			if (tb_sim_wrap_drv(icd->cd->drv) < 0) {
+				fprintf(stderr, "error: too many drivers\n");
+				return -ENOMEM;
+			}
+			break;
+		case COMP_TYPE_BUFFER:
+			tb_sim_buffers[tb_sim_num_buffers].buffer = icd->cb;
+			tb_sim_buffers[tb_sim_num_buffers].min_avail =
+				UINT32_MAX;
+			tb_sim_num_buffers++;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return 0;
+}
+
+void tb_sim_report(uint32_t mhz)
+{
+	struct host_core_stats stats;
+	struct tb_sim_buffer *sim_buf;
+	int core;
+	int i;
+
+	for (core = 0; !host_schedule_sim_stats(core, &stats); core++) {
+		if (!core)
+			printf("Simulated cores at %u MHz, %.2f ms:\n", mhz,
+			       stats.elapsed / 1e6);
+
+		printf("  core %d: load %.2f %%, task runs %u, "
+		       "deadline misses %u\n", core,
+		       stats.elapsed ? 100.0 * stats.busy / stats.elapsed : 0,
+		       stats.runs, stats.misses);
+	}
+
+	printf("Buffer fill levels (bytes):\n");
+
+	for (i = 0; i < tb_sim_num_buffers; i++) {
+		sim_buf = &tb_sim_buffers[i];
+		if (sim_buf->min_avail > sim_buf->max_avail)
+			continue;
+
+		printf("  buffer %3u: size %u, min %u, max %u\n",
+		       sim_buf->buffer->ipc_buffer.comp.id,
+		       sim_buf->buffer->size, sim_buf->min_avail,
+		       sim_buf->max_avail);
+	}
+
+	free(tb_sim_buffers);
+	tb_sim_buffers = NULL;
+	tb_sim_num_buffers = 0;
+}
@@ -37,6 +37,8 @@
 #include "host/topology.h"
 #include "host/trace.h"
 #include "host/file.h"
+#include "host/schedule.h"
+#include "host/simulation.h"
 
 #define TESTBENCH_NCH 2 /* Stereo */
 
@@ -110,6 +112,10 @@ static void print_usage(char *executable)
 	printf("%s -i in.txt -o out.txt -t test.tplg ", executable);
 	printf("-r 48000 -R 96000 ");
 	printf("-b S16_LE -a vol=libsof_volume.so\n");
+	printf("-C <cores> runs tasks on one thread per emulated core\n");
+	printf("-s <MHz> simulates cores at DSP clock in virtual time\n");
+	printf("-c <comp1=cycles,comp2=cycles> sets simulated cycles ");
+	printf("per frame\n");
 }
 
 /* free components */
@@ -142,11 +148,84 @@ static void free_comps(void)
 	}
 }
 
+/* print usage of heap, block map peaks and runs are in blocks */
+static void print_heap(const char *zone, int index,
+		       struct mm_heap_stats *stats)
+{
+	struct mm_map_stats *map;
+	int i;
+
+	printf("  %s %d: used %u, free %u, peak %u, failures %u", zone,
+	       index, stats->used, stats->free, stats->peak,
+	       stats->fail.count);
+	if (stats->fail.count)
+		printf(" (last %u bytes caps 0x%x)", stats->fail.bytes,
+		       stats->fail.caps);
+	printf("\n");
+
+	for (i = 0; i < stats->maps; i++) {
+		map = &stats->map[i];
+		printf("    %u x %u bytes: free %u, peak %u, largest free %u\n",
+		       map->count, map->block_size, map->free, map->peak,
+		       map->largest_free);
+	}
+}
+
+/* print usage of all heaps */
+static void print_heap_stats(void)
+{
+	static const char * const zone_name[RZONE_TYPES] = {
+		"system", "runtime", "buffer", "system runtime",
+	};
+	struct mm_heap_stats stats;
+	int zone;
+	int index;
+
+	printf("Heap usage (bytes):\n");
+
+	for (zone = 0; zone < RZONE_TYPES; zone++) {
+		for (index = 0; !heap_stats(BIT(zone), index, &stats);
+		     index++)
+			print_heap(zone_name[zone], index, &stats);
+	}
+}
+
+/* print copy execution time of components, host ticks are nanoseconds */
+static void print_comp_perf(void)
+{
+	struct list_item *clist;
+	struct ipc_comp_dev *icd;
+	struct comp_perf *perf;
+	uint64_t period;
+
+	printf("Component copy time (us), load in %% of pipeline period:\n");
+
+	list_for_item(clist, &sof.ipc->shared_ctx->comp_list) {
+		icd = container_of(clist, struct ipc_comp_dev, list);
+		if (icd->type != COMP_TYPE_COMPONENT || !icd->cd->perf.count)
+			continue;
+
+		perf = &icd->cd->perf;
+		period = icd->cd->pipeline ?
+			pipeline_task_period(icd->cd->pipeline) : 0;
+
+		printf("  comp %3u: copies %u, min %.2f, avg %.2f, max %.2f",
+		       icd->cd->comp.id, perf->count, perf->min / 1e3,
+		       (double)perf->total / perf->count / 1e3,
+		       perf->max / 1e3);
+		if (period)
+			printf(", load %.2f %%",
+			       (double)perf->total / perf->count / period /
+			       10);
+		printf("\n");
+	}
+}
+
 static void parse_input_args(int argc, char **argv, struct testbench_prm *tp)
 {
 	int option = 0;
 
-	while ((option = getopt(argc, argv, "hdi:o:t:b:a:r:R:")) != -1) {
+	while ((option = getopt(argc, argv, "hdi:o:t:b:a:r:R:C:s:c:")) != -1) {
 		switch (option) {
 		/* input sample file */
 		case 'i':
@@ -183,6 +262,22 @@ static void parse_input_args(int argc, char **argv, struct testbench_prm *tp)
 			tp->fs_out = atoi(optarg);
 			break;
 
+		/* emulated cores */
+		case 'C':
+			tp->cores = atoi(optarg);
+			break;
+
+		/* simulated DSP clock */
+		case 's':
+			tp->sim_mhz = atoi(optarg);
+			break;
+
+		/* simulated cycle costs */
+		case 'c':
+			if (tb_sim_parse_costs(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+
 		/* enable debug prints */
 		case 'd':
 			debug = 1;
@@ -197,6 +292,57 @@ static void parse_input_args(int argc, char **argv, struct testbench_prm *tp)
 	}
 }
 
+/* pipeline task has run to completion or was cancelled */
+static bool tb_task_idle(void *data)
+{
+	struct task *task = data;
+
+	return task->state != SOF_TASK_STATE_QUEUED &&
+		task->state != SOF_TASK_STATE_RUNNING;
+}
+
+/* pipeline run on worker threads */
+struct tb_run {
+	struct pipeline *p;
+	struct file_comp_data *frcd;
+};
+
+/* timer driven pipeline has reached EOF or stopped */
+static bool tb_pipeline_done(void *data)
+{
+	struct tb_run *run = data;
+
+	return run->frcd->fs.reached_eof || tb_task_idle(&run->p->pipe_task);
+}
+
+/* run pipeline on worker threads until EOF from fileread */
+static void tb_pipeline_run_threaded(struct pipeline *p,
+				     struct file_comp_data *frcd,
+				     struct testbench_prm *tp)
+{
+	struct tb_run run = { .p = p, .frcd = frcd };
+	uint64_t start = 0;
+
+	/* LL pipeline task runs again every period by itself */
+	if (pipeline_is_timer_driven(p)) {
+		pipeline_schedule_copy(p, 0);
+		host_schedule_wait(tb_pipeline_done, &run);
+		pipeline_schedule_cancel(p);
+		host_schedule_wait(tb_task_idle, &p->pipe_task);
+		return;
+	}
+
+	/* EDF pipeline task is queued again after each run, like from DMA */
+	while (frcd->fs.reached_eof == 0) {
+		pipeline_schedule_copy(p, start);
+		host_schedule_wait(tb_task_idle, &p->pipe_task);
+
+		/* simulated DMA interrupts arrive once per period */
+		if (tp->sim_mhz)
+			start = pipeline_task_period(p);
+	}
+}
+
 int main(int argc, char **argv)
 {
 	struct testbench_prm tp;
@@ -214,6 +360,8 @@ int main(int argc, char **argv)
 	/* initialize input and output sample rates */
 	tp.fs_in = 0;
 	tp.fs_out = 0;
+	tp.cores = 0;
+	tp.sim_mhz = 0;
 
 	/* command line arguments*/
 	parse_input_args(argc, argv, &tp);
@@ -230,6 +378,24 @@ int main(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
+	/* simulated cores run in virtual time on this thread */
+	if (tp.sim_mhz) {
+		if (!tp.cores)
+			tp.cores = 1;
+
+		if (host_schedule_sim_start(tp.cores, tp.sim_mhz) < 0) {
+			fprintf(stderr, "error: can't simulate %d cores\n",
+				tp.cores);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* start worker threads */
+	if (tp.cores && !tp.sim_mhz && host_schedule_start(tp.cores) < 0) {
+		fprintf(stderr, "error: can't start %d cores\n", tp.cores);
+		exit(EXIT_FAILURE);
+	}
+
 	/* parse topology file and create pipeline */
 	if (parse_topology(&sof, lib_table, &tp, &fr_id, &fw_id, &sched_id,
 			   pipeline) < 0) {
@@ -237,6 +403,12 @@ int main(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
+	/* charge cycle costs of component copies */
+	if (tp.sim_mhz && tb_sim_setup(sof.ipc) < 0) {
+		fprintf(stderr, "error: simulation setup\n");
+		exit(EXIT_FAILURE);
+	}
+
 	/* Get pointers to fileread and filewrite */
 	pcm_dev = ipc_get_comp(sof.ipc, fw_id);
 	fwcd = comp_get_drvdata(pcm_dev->cd);
@@ -255,6 +427,10 @@ int main(int argc, char **argv)
 	if (!tp.fs_out)
 		tp.fs_out = ipc_pipe->period * ipc_pipe->frames_per_sched;
 
+	/* pipeline IPC is handled on the pipeline core, as after IDC */
+	if (tp.cores)
+		host_cpu_id = ipc_pipe->core;
+
 	/* set pipeline params and trigger start */
 	if (tb_pipeline_start(sof.ipc, TESTBENCH_NCH, ipc_pipe, &tp) < 0) {
 		fprintf(stderr, "error: pipeline params\n");
@@ -265,8 +441,12 @@ int main(int argc, char **argv)
 	tb_enable_trace(false); /* reduce trace output */
 	tic = clock();
 
-	while (frcd->fs.reached_eof == 0)
-		pipeline_schedule_copy(p, 0);
+	if (tp.cores) {
+		tb_pipeline_run_threaded(p, frcd, &tp);
+	} else {
+		while (frcd->fs.reached_eof == 0)
+			pipeline_schedule_copy(p, 0);
+	}
 
 	if (!frcd->fs.reached_eof)
 		printf("warning: possible pipeline xrun\n");
@@ -280,14 +460,13 @@ int main(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
+	host_cpu_id = 0;
+
 	n_in = frcd->fs.n;
 	n_out = fwcd->fs.n;
 	t_exec = (double)(toc - tic) / CLOCKS_PER_SEC;
 	c_realtime = (double)n_out / TESTBENCH_NCH / tp.fs_out / t_exec;
 
-	/* free all components/buffers in pipeline */
-	free_comps();
-
 	/* print test summary */
 	printf("==========================================================\n");
 	printf("		           Test Summary\n");
@@ -302,6 +481,20 @@ int main(int argc, char **argv)
 	printf("Output sample count: %d\n", n_out);
 	printf("Total execution time: %.2f us, %.2f x realtime\n",
 	       1e3 * t_exec, c_realtime);
+	printf("Pipeline task runs: %u, deadline misses: %u, "
+	       "max execution time: %.2f us\n", p->stats.count,
+	       p->stats.misses, p->stats.exec_max / 1e3);
+	print_comp_perf();
+	if (tp.sim_mhz)
+		tb_sim_report(tp.sim_mhz);
+	print_heap_stats();
+
+	/* stop worker threads */
+	if (tp.cores)
+		host_schedule_stop();
+
+	/* free all components/buffers in pipeline */
+	free_comps();
 
 	/* free all other data */
 	free(tp.bits_in);
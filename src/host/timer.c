@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <time.h>
+#include <sof/clk.h>
+#include <platform/timer.h>
+#include <platform/platform.h>
+#include <sof/cpu.h>
+#include <string.h>
+#include "host/schedule.h"
+
+/* host has no platform timer, ticks are nanoseconds of monotonic clock */
+struct timer *platform_timer;
+
+/* virtual clock of each emulated core in simulation mode */
+static uint64_t sim_ticks[HOST_MAX_CORES];
+static bool sim_enabled;
+
+void host_timer_sim_enable(void)
+{
+	bzero(sim_ticks, sizeof(sim_ticks));
+	sim_enabled = true;
+}
+
+uint64_t host_timer_sim_get(int core)
+{
+	return sim_ticks[core];
+}
+
+void host_timer_sim_set(int core, uint64_t ticks)
+{
+	sim_ticks[core] = ticks;
+}
+
+uint64_t platform_timer_get(struct timer *timer)
+{
+	struct timespec ts;
+
+	if (sim_enabled)
+		return sim_ticks[cpu_get_id()];
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t clock_ms_to_ticks(int clock, uint64_t ms)
+{
+	return ms * 1000000;
+}
@@ -60,6 +60,8 @@ struct testbench_prm {
 	 */
 	uint32_t fs_in;
 	uint32_t fs_out;
+	int cores; /* emulated cores with worker threads, 0 runs inline */
+	uint32_t sim_mhz; /* simulated DSP clock, 0 runs in host time */
 };
 
 struct shared_lib_table {
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _INCLUDE_HOST_SCHEDULE_H_
+#define _INCLUDE_HOST_SCHEDULE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sof/schedule.h>
+
+/* maximum number of cores emulated by worker threads */
+#define HOST_MAX_CORES	8
+
+/* start one worker thread per emulated core */
+int host_schedule_start(int cores);
+
+/* stop and join worker threads */
+void host_schedule_stop(void);
+
+/* tasks run on worker threads rather than inline */
+bool host_schedule_threaded(void);
+
+/* queue task to run on its core from start, -EALREADY if already queued */
+int host_schedule_queue(struct task *task, uint64_t start, uint64_t deadline);
+
+/* move queued task to new start or queue it */
+void host_schedule_requeue(struct task *task, uint64_t start);
+
+/* remove task from its core queue, a running task is not run again */
+void host_schedule_cancel(struct task *task);
+
+/* block until done() returns true, checked after every task run */
+void host_schedule_wait(bool (*done)(void *data), void *data);
+
+/* convert microseconds to host timer ticks */
+uint64_t host_schedule_us_to_ticks(uint64_t us);
+
+/* simulated core statistics, times in host timer ticks */
+struct host_core_stats {
+	uint64_t busy;		/* time spent running tasks */
+	uint64_t elapsed;	/* virtual time since simulation start */
+	uint32_t runs;		/* number of task runs */
+	uint32_t misses;	/* runs that ended past deadline or period */
+};
+
+/*
+ * Simulation mode, tasks of all cores run on the calling thread in virtual
+ * time that only advances by the cycles charged to each core.
+ */
+int host_schedule_sim_start(int cores, uint32_t mhz);
+
+/* advance virtual time of current core by cycles at simulated clock */
+void host_schedule_sim_charge(uint64_t cycles);
+
+int host_schedule_sim_stats(int core, struct host_core_stats *stats);
+
+/* virtual clock of host timer, one per emulated core */
+void host_timer_sim_enable(void);
+uint64_t host_timer_sim_get(int core);
+void host_timer_sim_set(int core, uint64_t ticks);
+
+#endif /* _INCLUDE_HOST_SCHEDULE_H_ */
@@ -50,6 +50,7 @@
 #define SOF_TKN_SCHED_CORE                      203
 #define SOF_TKN_SCHED_FRAMES                    204
 #define SOF_TKN_SCHED_TIME_DOMAIN               205
+#define SOF_TKN_SCHED_BATCH                     206
 
 /* volume */
 #define SOF_TKN_VOLUME_RAMP_STEP_TYPE           250
@@ -137,6 +138,9 @@ static const struct sof_topology_token sched_tokens[] = {
 	{SOF_TKN_SCHED_TIME_DOMAIN, SND_SOC_TPLG_TUPLE_TYPE_WORD,
 		get_token_uint32_t,
 		offsetof(struct sof_ipc_pipe_new, time_domain), 0},
+	{SOF_TKN_SCHED_BATCH, SND_SOC_TPLG_TUPLE_TYPE_WORD,
+		get_token_uint32_t,
+		offsetof(struct sof_ipc_pipe_new, batch), 0},
 };
 
 /* volume */
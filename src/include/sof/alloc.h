@@ -70,6 +70,7 @@ struct sof;
 #define RZONE_FLAG_UNCACHED	BIT(4)
 
 #define RZONE_TYPE_MASK	0xf
+#define RZONE_TYPES	4
 #define RZONE_FLAG_MASK	0xf0
 
 struct dma_copy;
@@ -78,6 +79,7 @@ struct dma_sg_config;
 struct mm_info {
 	uint32_t used;
 	uint32_t free;
+	uint32_t peak;		/* high watermark of used */
 };
 
 struct block_hdr {
@@ -90,13 +92,19 @@ struct block_map {
 	uint16_t count;		/* number of blocks in map */
 	uint16_t free_count;	/* number of free blocks */
 	uint16_t first_free;	/* index of first free block */
+	uint16_t peak_count;	/* high watermark of used blocks */
 	struct block_hdr *block;	/* base block header */
+	uint32_t *free_mask;	/* bit set for every free block */
 	uint32_t base;		/* base address of space */
 } __attribute__ ((__aligned__(PLATFORM_DCACHE_ALIGN)));
 
+/* number of 32 bit words in free block mask */
+#define BLOCK_MASK_WORDS(cnt)	(((cnt) + 31) / 32)
+
 #define BLOCK_DEF(sz, cnt, hdr) \
 	{.block_size = sz, .count = cnt, .free_count = cnt, .block = hdr, \
-	 .first_free = 0}
+	 .first_free = 0, \
+	 .free_mask = (uint32_t [BLOCK_MASK_WORDS(cnt)]) { 0 } }
 
 struct mm_heap {
 	uint32_t blocks;
@@ -107,6 +115,13 @@ struct mm_heap {
 	struct mm_info info;
 } __attribute__ ((__aligned__(PLATFORM_DCACHE_ALIGN)));
 
+/* failed allocation record */
+struct mm_fail {
+	uint32_t count;		/* number of failed allocations */
+	uint32_t caps;		/* caps of last failed allocation */
+	uint32_t bytes;		/* size of last failed allocation */
+};
+
 /* heap block memory map */
 struct mm {
 	/* system heap - used during init cannot be freed */
@@ -118,9 +133,20 @@ struct mm {
 	/* general component buffer heap */
 	struct mm_heap buffer[PLATFORM_HEAP_BUFFER];
 
+	/* freeable heaps sorted by address for rfree() lookup */
+	struct mm_heap *heap_index[PLATFORM_HEAP_SYSTEM_RUNTIME +
+				   PLATFORM_HEAP_RUNTIME +
+				   PLATFORM_HEAP_BUFFER];
+
+	/* failed allocations by zone type */
+	struct mm_fail fail[RZONE_TYPES];
+
 	struct mm_info total;
 	uint32_t heap_trace_updated;	/* updates that can be presented */
 	spinlock_t lock;	/* all allocs and frees are atomic */
+
+	/* gives back buffer memory held by its users, e.g. pooled buffers */
+	int (*buffer_reclaim)(void);
 } __attribute__ ((__aligned__(PLATFORM_DCACHE_ALIGN)));
 
 /* heap allocation and free */
@@ -181,6 +207,21 @@ void alloc_trace_buffer_heap(int zone, uint32_t caps, size_t bytes);
 
 #endif
 
+/*
+ * Allocations aligned to alignment bytes, e.g. for vector access of DSP
+ * state. Alignment is a power of 2. Memory is freed with rfree().
+ */
+void *rzalloc_align(int zone, uint32_t caps, size_t bytes, uint32_t alignment);
+void *rballoc_align(int zone, uint32_t caps, size_t bytes, uint32_t alignment);
+
+/*
+ * Resizes allocation at ptr to bytes keeping its contents. Allocation grows
+ * in place when the blocks following it are free, otherwise it is moved to
+ * new memory from zone. Returns NULL and keeps ptr on failure, allocates new
+ * memory if ptr is NULL.
+ */
+void *rrealloc(void *ptr, int zone, uint32_t caps, size_t bytes);
+
 /* system heap allocation for specific core */
 void *rzalloc_core_sys(int core, size_t bytes);
 
@@ -206,4 +247,44 @@ void free_heap(int zone);
 void heap_trace_all(int force);
 void heap_trace(struct mm_heap *heap, int size);
 
+/* max block maps reported by heap_stats() */
+#define HEAP_STATS_MAPS		8
+
+/* block map statistics, counts are in blocks */
+struct mm_map_stats {
+	uint32_t block_size;
+	uint32_t count;
+	uint32_t free;
+	uint32_t peak;		/* high watermark of used blocks */
+	uint32_t largest_free;	/* longest run of free blocks */
+};
+
+/* heap statistics, sizes are in bytes */
+struct mm_heap_stats {
+	uint32_t heaps;		/* number of heaps in zone */
+	uint32_t base;
+	uint32_t size;
+	uint32_t caps;
+	uint32_t used;
+	uint32_t free;
+	uint32_t peak;		/* high watermark of used */
+	struct mm_fail fail;	/* failed allocations from zone */
+	uint32_t maps;		/* number of valid map entries */
+	struct mm_map_stats map[HEAP_STATS_MAPS];
+};
+
+/*
+ * Sets callback giving back buffer heap memory kept by its users for
+ * reuse. It's called without heap lock held when a buffer allocation fails
+ * and returns the number of freed allocations, the allocation is retried
+ * once if any were freed.
+ */
+void heap_set_buffer_reclaim(int (*reclaim)(void));
+
+/* statistics of heap index of zone type */
+int heap_stats(int zone, int index, struct mm_heap_stats *stats);
+
+/* restart high watermarks at current usage and clear failures */
+void heap_stats_reset(void);
+
 #endif
@@ -50,6 +50,16 @@ static inline void atomic_set(atomic_t *a, int32_t value)
 	arch_atomic_set(a, value);
 }
 
+static inline int32_t atomic_read_acquire(const atomic_t *a)
+{
+	return arch_atomic_read_acquire(a);
+}
+
+static inline void atomic_set_release(atomic_t *a, int32_t value)
+{
+	arch_atomic_set_release(a, value);
+}
+
 static inline int32_t atomic_add(atomic_t *a, int32_t value)
 {
 	return arch_atomic_add(a, value);
@@ -33,6 +33,8 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include <sof/atomic.h>
 #include <sof/lock.h>
 #include <sof/list.h>
 #include <sof/stream.h>
@@ -48,6 +50,9 @@
 #define trace_buffer_error(__e, ...)	trace_error(TRACE_CLASS_BUFFER, __e, ##__VA_ARGS__)
 #define tracev_buffer(__e, ...)	tracev_event(TRACE_CLASS_BUFFER, __e, ##__VA_ARGS__)
 
+/* max number of freed buffers kept for reuse */
+#define BUFFER_POOL_DEPTH	16
+
 /* buffer callback types */
 #define BUFF_CB_TYPE_PRODUCE	BIT(0)
 #define BUFF_CB_TYPE_CONSUME	BIT(1)
@@ -65,6 +70,22 @@ struct comp_buffer {
 	void *addr;		/* buffer base address */
 	void *end_addr;		/* buffer end address */
 
+	/* lock free single producer single consumer mode, the byte counters
+	 * are kept in locked mode too, e.g. for accounting copied data
+	 */
+	bool spsc;		/* both ends are copied by the same task */
+	atomic_t w_idx;		/* total bytes produced, wraps at 2^32 */
+	atomic_t r_idx;		/* total bytes consumed, wraps at 2^32 */
+
+	/* in place processing, memory is owned by first buffer of chain */
+	struct comp_buffer *alias;	/* upstream buffer sharing memory */
+	struct comp_buffer *alias_next;	/* downstream buffer sharing memory */
+
+	/* Free space of aliased buffers is tracked on every produce and
+	 * consume, so copies must not bypass them (e.g. fused chains).
+	 */
+	bool no_bypass;
+
 	/* IPC configuration */
 	struct sof_ipc_buffer ipc_buffer;
 
@@ -136,12 +157,31 @@ typedef void (*cache_buff_op)(struct comp_buffer *);
 struct comp_buffer *buffer_new(struct sof_ipc_buffer *desc);
 void buffer_free(struct comp_buffer *buffer);
 
+/* buffer reuse pool */
+void sys_buffer_init(void);
+
+/* give pooled buffers back to the heap, returns number of freed buffers */
+int buffer_pool_trim(void);
+
 /* called by a component after producing data into this buffer */
 void comp_update_buffer_produce(struct comp_buffer *buffer, uint32_t bytes);
 
 /* called by a component after consuming data from this buffer */
 void comp_update_buffer_consume(struct comp_buffer *buffer, uint32_t bytes);
 
+/* select lock free (SPSC) or locked buffer pointer update mode */
+void buffer_set_spsc(struct comp_buffer *buffer, bool spsc);
+
+/* Share memory of upstream buffer for in place processing. Free space of
+ * the first buffer in the chain is updated under its lock, as DMA may fill
+ * it from another context. In place components produce into their sink
+ * before consuming the source, so the shared free space is never too big.
+ */
+int buffer_alias(struct comp_buffer *buffer, struct comp_buffer *source);
+
+/* give buffer its own memory back */
+int buffer_unalias(struct comp_buffer *buffer);
+
 static inline void buffer_zero(struct comp_buffer *buffer)
 {
 	tracev_buffer("buffer_zero()");
@@ -213,6 +253,10 @@ static inline void buffer_reset_pos(struct comp_buffer *buffer)
 	/* there are no avail samples at reset */
 	buffer->avail = 0;
 
+	/* restart SPSC counters */
+	atomic_init(&buffer->w_idx, 0);
+	atomic_init(&buffer->r_idx, 0);
+
 	/* clear buffer contents */
 	buffer_zero(buffer);
 }
@@ -243,4 +287,61 @@ static inline void *buffer_get_frag(struct comp_buffer *buffer, void *ptr,
 	return current;
 }
 
+/* contiguous region of buffer memory between buffer wraps */
+struct buffer_span {
+	void *ptr;		/* span start address */
+	uint32_t bytes;		/* span size in bytes */
+};
+
+/* get the number of bytes that can be accessed from ptr before wrap */
+static inline uint32_t buffer_bytes_without_wrap(struct comp_buffer *buffer,
+						 void *ptr)
+{
+	return buffer->end_addr - ptr;
+}
+
+#define buffer_samples_without_wrap_s16(buffer, ptr) \
+	(buffer_bytes_without_wrap(buffer, ptr) / sizeof(int16_t))
+
+#define buffer_samples_without_wrap_s32(buffer, ptr) \
+	(buffer_bytes_without_wrap(buffer, ptr) / sizeof(int32_t))
+
+/* wrap pointer which has been advanced beyond the buffer end */
+static inline void *buffer_wrap(struct comp_buffer *buffer, void *ptr)
+{
+	if (ptr >= buffer->end_addr)
+		ptr = buffer->addr + (ptr - buffer->end_addr);
+
+	return ptr;
+}
+
+/* split bytes starting at ptr into at most two contiguous spans, the second
+ * one starting at the buffer base address, returns number of spans used
+ */
+static inline int buffer_get_spans(struct comp_buffer *buffer, void *ptr,
+				   uint32_t bytes, struct buffer_span *spans)
+{
+	uint32_t head = buffer_bytes_without_wrap(buffer, ptr);
+
+	spans[0].ptr = ptr;
+
+	if (bytes <= head) {
+		spans[0].bytes = bytes;
+		spans[1].ptr = NULL;
+		spans[1].bytes = 0;
+		return 1;
+	}
+
+	spans[0].bytes = head;
+	spans[1].ptr = buffer->addr;
+	spans[1].bytes = bytes - head;
+	return 2;
+}
+
+#define buffer_read_spans(buffer, bytes, spans) \
+	buffer_get_spans(buffer, buffer->r_ptr, bytes, spans)
+
+#define buffer_write_spans(buffer, bytes, spans) \
+	buffer_get_spans(buffer, buffer->w_ptr, bytes, spans)
+
 #endif
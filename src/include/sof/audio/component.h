@@ -156,6 +156,13 @@
 #define COMP_ATTR_COPY_BLOCKING	0	/**< Comp blocking copy attribute */
 /** @}*/
 
+/** \name Component driver flags
+ *  @{
+ */
+#define COMP_DRV_INPLACE	BIT(0)	/**< sink may share source memory */
+#define COMP_DRV_KEEP_STATE	BIT(1)	/**< not prepared again after xrun */
+/** @}*/
+
 /** \name Trace macros
  *  @{
  */
@@ -205,6 +212,14 @@ struct comp_ops {
 	/** copy and process stream data from source to sink buffers */
 	int (*copy)(struct comp_dev *dev);
 
+	/**
+	 * optional - process frames from source r_ptr to sink w_ptr
+	 * without updating buffer positions, used to fuse 1-in/1-out
+	 * components in pipeline copy
+	 */
+	int (*process)(struct comp_dev *dev, struct comp_buffer *source,
+		       struct comp_buffer *sink, uint32_t frames);
+
 	/** host buffer config */
 	int (*host_buffer)(struct comp_dev *dev,
 			   struct dma_sg_elem_array *elem_array,
@@ -230,12 +245,22 @@ struct comp_ops {
 struct comp_driver {
 	uint32_t type;		/**< SOF_COMP_ for driver */
 	uint32_t module_id;	/**< module id */
+	uint32_t flags;		/**< COMP_DRV_ flags */
 
 	struct comp_ops ops;	/**< component operations */
 
 	struct list_item list;	/**< list of component drivers */
 };
 
+/** \brief Copy execution time of component in platform timer ticks. */
+struct comp_perf {
+	uint64_t total;		/**< ticks spent in all measured copies */
+	uint32_t count;		/**< number of measured copies */
+	uint32_t min;		/**< minimum ticks of single copy */
+	uint32_t max;		/**< maximum ticks of single copy */
+	uint32_t last;		/**< ticks of last copy */
+};
+
 /**
  * Audio component base device "class"
  * - used by other component types.
@@ -250,6 +275,8 @@ struct comp_dev {
 	uint32_t frames;	   /**< number of frames we copy to sink */
 	uint32_t frame_bytes;	   /**< frames size copied to sink in bytes */
 	struct pipeline *pipeline; /**< pipeline we belong to */
+	bool arena_released;	   /**< arena memory freed with pipeline */
+	struct comp_perf perf;	   /**< copy execution time statistics */
 
 	/** common runtime configuration for downstream/upstream */
 	struct sof_ipc_stream_params params;
@@ -382,6 +409,24 @@ int comp_set_state(struct comp_dev *dev, int cmd);
 void comp_set_period_bytes(struct comp_dev *dev, uint32_t frames,
 			   enum sof_ipc_frame *format, uint32_t *period_bytes);
 
+/**
+ * Allocates zeroed runtime memory from arena of component pipeline.
+ * Memory is aligned to PPL_ARENA_ALIGN. Component must be in a pipeline.
+ * @param dev Component device.
+ * @param bytes Size in bytes.
+ * @return Pointer to memory or NULL.
+ */
+void *comp_arena_alloc(struct comp_dev *dev, size_t bytes);
+
+/**
+ * Frees memory allocated with comp_arena_alloc(). Does nothing once
+ * pipeline_free() has given the arena memory back to the heap, so
+ * component must free its arena memory before allocating it again.
+ * @param dev Component device.
+ * @param ptr Pointer to memory, may be NULL.
+ */
+void comp_arena_free(struct comp_dev *dev, void *ptr);
+
 /**
  * Component parameter init.
  * @param dev Component device.
@@ -474,6 +519,49 @@ static inline int comp_copy(struct comp_dev *dev)
 	return dev->drv->ops.copy(dev);
 }
 
+/**
+ * Process frames between given buffers without updating their positions.
+ * @param dev Component device.
+ * @param source Source buffer.
+ * @param sink Sink buffer.
+ * @param frames Number of frames to process.
+ * @return 0 if succeeded, error code otherwise.
+ */
+static inline int comp_process(struct comp_dev *dev,
+			       struct comp_buffer *source,
+			       struct comp_buffer *sink, uint32_t frames)
+{
+	return dev->drv->ops.process(dev, source, sink, frames);
+}
+
+/**
+ * Accounts execution time of one component copy.
+ * @param dev Component device.
+ * @param ticks Platform timer ticks spent in copy.
+ */
+static inline void comp_perf_update(struct comp_dev *dev, uint32_t ticks)
+{
+	struct comp_perf *perf = &dev->perf;
+
+	if (!perf->count || ticks < perf->min)
+		perf->min = ticks;
+	if (ticks > perf->max)
+		perf->max = ticks;
+
+	perf->last = ticks;
+	perf->total += ticks;
+	perf->count++;
+}
+
+/**
+ * Clears copy execution time statistics of component.
+ * @param dev Component device.
+ */
+static inline void comp_perf_reset(struct comp_dev *dev)
+{
+	bzero(&dev->perf, sizeof(dev->perf));
+}
+
 /**
  * Component reset and free runtime resources.
  * @param dev Component device.
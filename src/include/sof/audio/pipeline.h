@@ -40,6 +40,7 @@
 #include <sof/audio/component.h>
 #include <sof/trace.h>
 #include <sof/schedule.h>
+#include <uapi/ipc/debug.h>
 #include <uapi/ipc/topology.h>
 
 /*
@@ -88,9 +89,72 @@ struct ipc;
 #define PPL_DIR_DOWNSTREAM	0
 #define PPL_DIR_UPSTREAM	1
 
+/* max number of entries in precomputed pipeline copy order */
+#define PPL_COPY_ORDER_MAX	32
+
+/* number of frames processed at once by fused components */
+#define PPL_FUSE_FRAMES		16
+
+/* component visited by pipeline copy, in the order of graph walk */
+struct pipeline_copy_entry {
+	struct comp_dev *comp;
+	uint16_t skip;		/* index of first entry after comp subtree */
+	uint16_t fused;		/* length of fused chain starting here or 0 */
+};
+
+/* pipeline task statistics histograms, bin width is 1/8 of period */
+#define PPL_STATS_BINS		SOF_IPC_DEBUG_HIST_BINS
+#define PPL_STATS_BIN_SHIFT	3
+
+/* pipeline task scheduling statistics, times in platform timer ticks */
+struct pipeline_stats {
+	uint32_t count;		/* measured task runs */
+	uint32_t misses;	/* runs finished after one period from start */
+	uint32_t latency_max;	/* max delay of run after scheduled start */
+	uint32_t exec_max;	/* max execution time of run */
+	uint32_t headroom_min;	/* lowest DAI buffer headroom in bytes */
+	uint32_t latency_hist[PPL_STATS_BINS];
+	uint32_t exec_hist[PPL_STATS_BINS];
+};
+
 /*
  * Audio pipeline.
  */
+/* minimum size of pipeline arena chunk data in bytes */
+#define PPL_ARENA_CHUNK_SIZE	2048
+
+/* alignment of pipeline arena allocations for vector access */
+#define PPL_ARENA_ALIGN		16
+
+/* pipeline arena chunk, allocations are carved from data in order */
+struct pipeline_arena_chunk {
+	struct pipeline_arena_chunk *next;
+	uint8_t *data;		/* aligned data following chunk header */
+	uint32_t size;		/* data size in bytes */
+	uint32_t used;		/* carved data bytes */
+};
+
+/* header in front of each arena allocation */
+struct pipeline_arena_block {
+	struct pipeline_arena_block *next;	/* next free block */
+	uint32_t size;		/* block size in bytes including header */
+};
+
+#define PPL_ARENA_HDR_SIZE \
+	ALIGN(sizeof(struct pipeline_arena_block), PPL_ARENA_ALIGN)
+
+/* Runtime memory of pipeline components, e.g. delay lines. Freed blocks
+ * are kept in address order, merged with free neighbours and reused by
+ * later allocations. All memory is reused once all allocations are freed.
+ * pipeline_free() gives it back to the heap in one go, including
+ * allocations components haven't freed.
+ */
+struct pipeline_arena {
+	struct pipeline_arena_chunk *chunks;
+	struct pipeline_arena_block *free;	/* free blocks by address */
+	uint32_t live;		/* number of allocations not freed yet */
+};
+
 struct pipeline {
 	spinlock_t lock; /* pipeline lock */
 	struct sof_ipc_pipe_new ipc_pipe;
@@ -105,6 +169,20 @@ struct pipeline {
 	struct comp_dev *sched_comp;	/* component that drives scheduling in this pipe */
 	struct comp_dev *source_comp;	/* source component for this pipe */
 	struct comp_dev *sink_comp;	/* sink component for this pipe */
+	uint32_t period_ticks;		/* task period in timer ticks */
+
+	/* precomputed copy order, rebuilt after graph changes */
+	struct pipeline_copy_entry copy_order[PPL_COPY_ORDER_MAX];
+	struct comp_dev *copy_order_start;	/* walk start of copy order */
+	uint16_t copy_order_count;	/* number of valid entries */
+	bool copy_order_valid;		/* false if needs to be rebuilt */
+	void *fuse_tiles;		/* intermediate data of fused chains */
+
+	/* scheduling statistics */
+	struct pipeline_stats stats;
+
+	/* component runtime memory */
+	struct pipeline_arena arena;
 
 	/* position update */
 	uint32_t posn_offset;		/* position update array offset*/
@@ -132,11 +210,29 @@ static inline bool pipeline_is_timer_driven(struct pipeline *p)
 	return p->ipc_pipe.time_domain == SOF_TIME_DOMAIN_TIMER;
 }
 
+/* pipeline task run interval in us, covers all periods of a batch */
+static inline uint64_t pipeline_task_period(struct pipeline *p)
+{
+	return (uint64_t)p->ipc_pipe.period * p->ipc_pipe.batch;
+}
+
+/* DAI side buffer of pipeline or NULL */
+struct comp_buffer *pipeline_dai_buffer(struct pipeline *p);
+
+/* clear scheduling statistics */
+void pipeline_stats_reset(struct pipeline *p);
+
 /* pipeline creation and destruction */
 struct pipeline *pipeline_new(struct sof_ipc_pipe_new *pipe_desc,
 	struct comp_dev *cd);
 int pipeline_free(struct pipeline *p);
 
+/* pipeline arena allocation, memory is zeroed */
+void *pipeline_arena_alloc(struct pipeline *p, size_t bytes);
+
+/* returns false if ptr is not arena memory */
+bool pipeline_arena_free(struct pipeline *p, void *ptr);
+
 /* pipeline buffer creation and destruction */
 struct comp_buffer *buffer_new(struct sof_ipc_buffer *desc);
 void buffer_free(struct comp_buffer *buffer);
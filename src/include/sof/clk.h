@@ -32,6 +32,7 @@
 #define __INCLUDE_CLOCK__
 
 #include <stdint.h>
+#include <config.h>
 
 #define CLOCK_NOTIFY_PRE	0
 #define CLOCK_NOTIFY_POST	1
@@ -59,4 +60,17 @@ uint64_t clock_ms_to_ticks(int clock, uint64_t ms);
 
 void clock_init(void);
 
+#if CONFIG_CLK_GOVERNOR
+/* set up scaling clock of current core with its load */
+int clock_governor_init(void);
+
+/* pipeline on current core became active or stopped */
+void clock_governor_start(void);
+void clock_governor_stop(void);
+#else
+static inline int clock_governor_init(void) { return 0; }
+static inline void clock_governor_start(void) { }
+static inline void clock_governor_stop(void) { }
+#endif
+
 #endif
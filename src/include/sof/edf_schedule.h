@@ -61,8 +61,19 @@ struct sof;
 
 #define edf_sch_get_pdata(task) task->private
 
+/* ready queue heaps, both hold every queued task */
+#define EDF_HEAP_READY		0	/* ordered by priority, then deadline */
+#define EDF_HEAP_DEADLINE	1	/* ordered by deadline */
+#define EDF_HEAP_COUNT		2
+
+/* task is not in ready queue */
+#define EDF_HEAP_NONE		-1
+
 struct edf_task_pdata {
 	uint64_t deadline;
+	int32_t heap_index[EDF_HEAP_COUNT];	/* position in each heap */
+	uint64_t sched_start;	/* start before task was run, for timeline */
+	uint64_t run_start;	/* time task started running, for timeline */
 };
 
 extern struct scheduler_ops schedule_edf_ops;
@@ -58,8 +58,12 @@ struct work_queue;
 
 #define ll_sch_get_pdata(task) task->private
 
+/* task is not in ll queue heap */
+#define LL_HEAP_NONE	-1
+
 struct ll_task_pdata {
 	uint32_t flags;
+	int32_t heap_index;	/* index in ll queue heap or LL_HEAP_NONE */
 };
 
 extern struct timesource_data platform_generic_queue[];
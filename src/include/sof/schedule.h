@@ -108,12 +108,42 @@ struct task {
 	void *private;
 };
 
+/* number of task runs kept in each core timeline ring */
+#define SCHEDULE_TIMELINE_SIZE	64
+
+/* one task run, times are platform timer ticks */
+struct schedule_timeline_event {
+	uint32_t task;		/* task id */
+	uint16_t type;		/* SOF_SCHEDULE_ type */
+	uint16_t priority;
+	uint64_t sched_start;	/* time task was due to start */
+	uint64_t start;		/* time task started running */
+	uint64_t end;		/* time task completed */
+};
+
+/* ring of task runs, written and drained on its own core */
+struct schedule_timeline {
+	struct schedule_timeline_event events[SCHEDULE_TIMELINE_SIZE];
+	uint32_t w_idx;		/* free running write index */
+	uint32_t r_idx;		/* free running read index */
+	uint32_t dropped;	/* runs lost while ring was full */
+};
+
+/* time a core spent running tasks, for load based clock scaling */
+struct schedule_load {
+	uint64_t busy;		/* busy time in platform timer ticks */
+	uint64_t start;		/* start of outermost running task */
+	uint32_t depth;		/* running tasks, nested by preemption */
+};
+
 struct edf_schedule_data;
 struct ll_schedule_data;
 
 struct schedule_data {
 	struct ll_schedule_data *ll_sch_data;
 	struct edf_schedule_data *edf_sch_data;
+	struct schedule_timeline *timeline;
+	struct schedule_load load;
 };
 
 struct schedule_data **arch_schedule_get_data(void);
@@ -141,4 +171,37 @@ int schedule_task_cancel(struct task *task);
 
 void schedule_task_free(struct task *task);
 
+#if CONFIG_TRACE_SCHEDULE
+/* add task run to timeline of current core, called with irqs disabled */
+void schedule_timeline_record(struct task *task, uint64_t sched_start,
+			      uint64_t start, uint64_t end);
+
+/* send timeline of current core to trace, called from idle */
+void schedule_timeline_flush(void);
+
+static inline uint64_t schedule_timeline_time(void)
+{
+	return platform_timer_get(platform_timer);
+}
+#else
+static inline void schedule_timeline_record(struct task *task,
+					    uint64_t sched_start,
+					    uint64_t start, uint64_t end) { }
+static inline void schedule_timeline_flush(void) { }
+static inline uint64_t schedule_timeline_time(void) { return 0; }
+#endif
+
+#if CONFIG_CLK_GOVERNOR
+/* task starts or ends running on current core */
+void schedule_load_enter(void);
+void schedule_load_exit(void);
+
+/* busy time of current core so far, including running tasks */
+uint64_t schedule_load_busy(void);
+#else
+static inline void schedule_load_enter(void) { }
+static inline void schedule_load_exit(void) { }
+static inline uint64_t schedule_load_busy(void) { return 0; }
+#endif
+
 #endif /* __INCLUDE_SOF_SCHEDULER_H__ */
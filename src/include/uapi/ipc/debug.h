@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file include/uapi/ipc/debug.h
+ * \brief IPC definitions for runtime statistics
+ */
+
+#ifndef __INCLUDE_UAPI_IPC_DEBUG_H__
+#define __INCLUDE_UAPI_IPC_DEBUG_H__
+
+#include <uapi/ipc/header.h>
+
+/** Clear statistics after they are read */
+#define SOF_IPC_DEBUG_FLAG_RESET	(1 << 0)
+
+/* Statistics request - SOF_IPC_DEBUG_ */
+struct sof_ipc_dbg_req {
+	struct sof_ipc_cmd_hdr hdr;
+	uint32_t id;		/**< component or pipeline id */
+	uint32_t flags;		/**< SOF_IPC_DEBUG_FLAG_ */
+} __attribute__((packed));
+
+/*
+ * Component copy() execution time in platform timer ticks, MCPS of the
+ * component is avg / ticks_per_ms * DSP clock in kHz / period_us.
+ * SOF_IPC_DEBUG_COMP_PERF - ABI3.8
+ */
+struct sof_ipc_dbg_comp_perf {
+	struct sof_ipc_reply rhdr;
+	uint32_t comp_id;
+	uint32_t count;		/**< number of measured copies */
+	uint32_t min;		/**< minimum ticks per copy */
+	uint32_t max;		/**< maximum ticks per copy */
+	uint32_t avg;		/**< average ticks per copy */
+	uint32_t ticks_per_ms;	/**< platform timer ticks per ms */
+	uint32_t period_us;	/**< copy period of component pipeline */
+} __attribute__((packed));
+
+/**
+ * Histogram bin k counts values from k / 8 to (k + 1) / 8 of pipeline
+ * period, the last bin counts all longer values.
+ */
+#define SOF_IPC_DEBUG_HIST_BINS		10
+
+/*
+ * Pipeline task scheduling statistics in platform timer ticks. Latency is
+ * the delay of task start after its scheduled start, deadline is missed
+ * when latency and execution time exceed the period. Headroom is the
+ * lowest data (playback) or free space (capture) seen in the DAI buffer
+ * before the pipeline copy.
+ * SOF_IPC_DEBUG_PIPE_STATS - ABI3.9
+ */
+struct sof_ipc_dbg_pipe_stats {
+	struct sof_ipc_reply rhdr;
+	uint32_t comp_id;
+	uint32_t count;		/**< number of measured runs */
+	uint32_t misses;	/**< number of missed deadlines */
+	uint32_t latency_max;	/**< maximum start latency */
+	uint32_t exec_max;	/**< maximum execution time */
+	uint32_t headroom_min;	/**< lowest DAI buffer headroom in bytes */
+	uint32_t buffer_size;	/**< DAI buffer size, 0 if no DAI */
+	uint32_t ticks_per_ms;	/**< platform timer ticks per ms */
+	uint32_t period_us;	/**< pipeline task period */
+	uint32_t latency_hist[SOF_IPC_DEBUG_HIST_BINS];
+	uint32_t exec_hist[SOF_IPC_DEBUG_HIST_BINS];
+} __attribute__((packed));
+
+/* heap zones, match bit index of firmware heap zone type */
+#define SOF_IPC_DEBUG_HEAP_SYS		0
+#define SOF_IPC_DEBUG_HEAP_RUNTIME	1
+#define SOF_IPC_DEBUG_HEAP_BUFFER	2
+#define SOF_IPC_DEBUG_HEAP_SYS_RUNTIME	3
+
+/* Heap statistics request - SOF_IPC_DEBUG_HEAP_STATS */
+struct sof_ipc_dbg_heap_req {
+	struct sof_ipc_cmd_hdr hdr;
+	uint32_t zone;		/**< SOF_IPC_DEBUG_HEAP_ */
+	uint32_t index;		/**< heap index in zone */
+	uint32_t flags;		/**< SOF_IPC_DEBUG_FLAG_ */
+} __attribute__((packed));
+
+/** Max block maps reported per heap */
+#define SOF_IPC_DEBUG_HEAP_MAPS		8
+
+/* Block map usage in blocks */
+struct sof_ipc_dbg_heap_map {
+	uint32_t block_size;	/**< block size in bytes */
+	uint32_t count;		/**< number of blocks */
+	uint32_t free;		/**< number of free blocks */
+	uint32_t peak;		/**< high watermark of used blocks */
+	uint32_t largest_free;	/**< longest run of free blocks */
+} __attribute__((packed));
+
+/*
+ * Heap usage in bytes. Failures count all failed allocations from heap
+ * zone, fail_caps and fail_bytes describe the last one. Small runtime
+ * blocks cached per core are accounted as used.
+ * SOF_IPC_DEBUG_HEAP_STATS - ABI3.10
+ */
+struct sof_ipc_dbg_heap_stats {
+	struct sof_ipc_reply rhdr;
+	uint32_t zone;
+	uint32_t index;
+	uint32_t heaps;		/**< number of heaps in zone */
+	uint32_t base;		/**< heap base address */
+	uint32_t size;
+	uint32_t caps;		/**< SOF_MEM_CAPS_ */
+	uint32_t used;
+	uint32_t free;
+	uint32_t peak;		/**< high watermark of used */
+	uint32_t fails;		/**< number of failed allocations */
+	uint32_t fail_caps;	/**< caps of last failed allocation */
+	uint32_t fail_bytes;	/**< size of last failed allocation */
+	uint32_t num_maps;	/**< number of valid map entries */
+	struct sof_ipc_dbg_heap_map map[SOF_IPC_DEBUG_HEAP_MAPS];
+} __attribute__((packed));
+
+#endif
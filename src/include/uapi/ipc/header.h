@@ -93,6 +93,7 @@
 #define SOF_IPC_GLB_DAI_MSG			SOF_GLB_TYPE(0x8U)
 #define SOF_IPC_GLB_TRACE_MSG			SOF_GLB_TYPE(0x9U)
 #define SOF_IPC_GLB_GDB_DEBUG                   SOF_GLB_TYPE(0xAU)
+#define SOF_IPC_GLB_DEBUG			SOF_GLB_TYPE(0xBU)
 
 /** @} */
 
@@ -172,6 +173,16 @@
 
 /** @} */
 
+/** \name DSP Command: Runtime statistics
+ *  @{
+ */
+
+#define SOF_IPC_DEBUG_COMP_PERF			SOF_CMD_TYPE(0x001)
+#define SOF_IPC_DEBUG_PIPE_STATS		SOF_CMD_TYPE(0x002)
+#define SOF_IPC_DEBUG_HEAP_STATS		SOF_CMD_TYPE(0x003)
+
+/** @} */
+
 /** \name IPC Message Definitions
  * @{
  */
@@ -69,6 +69,7 @@
 #define SOF_TKN_SCHED_CORE			203
 #define SOF_TKN_SCHED_FRAMES			204
 #define SOF_TKN_SCHED_TIMER			205
+#define SOF_TKN_SCHED_BATCH			206
 
 /* volume */
 #define SOF_TKN_VOLUME_RAMP_STEP_TYPE		250
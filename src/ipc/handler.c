@@ -36,6 +36,7 @@
 
 #include <stdbool.h>
 #include <sof/debug.h>
+#include <sof/clk.h>
 #include <sof/timer.h>
 #include <sof/interrupt.h>
 #include <sof/ipc.h>
@@ -53,6 +54,7 @@
 #include <platform/shim.h>
 #include <platform/dma.h>
 #include <platform/timer.h>
+#include <platform/clk.h>
 #include <platform/idc.h>
 #include <sof/audio/component.h>
 #include <sof/audio/pipeline.h>
@@ -63,6 +65,7 @@
 #include <uapi/ipc/topology.h>
 #include <uapi/ipc/pm.h>
 #include <uapi/ipc/control.h>
+#include <uapi/ipc/debug.h>
 #include <sof/dma-trace.h>
 #include <sof/cpu.h>
 #include <sof/idc.h>
@@ -840,6 +843,175 @@ static int ipc_glb_gdb_debug(uint32_t header)
 
 }
 
+/*
+ * Runtime statistics IPC Operations.
+ */
+
+static int ipc_debug_comp_perf(uint32_t header)
+{
+	struct sof_ipc_dbg_req req;
+	struct sof_ipc_dbg_comp_perf reply;
+	struct ipc_comp_dev *icd;
+	struct comp_perf *perf;
+
+	/* copy message with ABI safe method */
+	IPC_COPY_CMD(req, _ipc->comp_data);
+
+	trace_ipc("ipc: comp %d -> perf", req.id);
+
+	icd = ipc_get_comp(_ipc, req.id);
+	if (!icd || icd->type != COMP_TYPE_COMPONENT) {
+		trace_ipc_error("ipc: comp %d not found", req.id);
+		return -ENODEV;
+	}
+
+	perf = &icd->cd->perf;
+
+	bzero(&reply, sizeof(reply));
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.comp_id = req.id;
+	reply.count = perf->count;
+	reply.min = perf->min;
+	reply.max = perf->max;
+	reply.avg = perf->count ? perf->total / perf->count : 0;
+	reply.ticks_per_ms = clock_ms_to_ticks(PLATFORM_WORKQ_CLOCK, 1);
+	if (icd->cd->pipeline)
+		reply.period_us = pipeline_task_period(icd->cd->pipeline);
+
+	if (req.flags & SOF_IPC_DEBUG_FLAG_RESET)
+		comp_perf_reset(icd->cd);
+
+	mailbox_hostbox_write(0, &reply, sizeof(reply));
+	return 1;
+}
+
+static int ipc_debug_pipe_stats(uint32_t header)
+{
+	struct sof_ipc_dbg_req req;
+	struct sof_ipc_dbg_pipe_stats reply;
+	struct ipc_comp_dev *ipc_pipe;
+	struct pipeline_stats *stats;
+	struct comp_buffer *buffer;
+	struct pipeline *p;
+
+	/* copy message with ABI safe method */
+	IPC_COPY_CMD(req, _ipc->comp_data);
+
+	trace_ipc("ipc: pipe %d -> stats", req.id);
+
+	ipc_pipe = ipc_get_comp(_ipc, req.id);
+	if (!ipc_pipe || ipc_pipe->type != COMP_TYPE_PIPELINE) {
+		trace_ipc_error("ipc: pipe %d not found", req.id);
+		return -ENODEV;
+	}
+
+	p = ipc_pipe->pipeline;
+	stats = &p->stats;
+	buffer = pipeline_dai_buffer(p);
+
+	bzero(&reply, sizeof(reply));
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.comp_id = req.id;
+	reply.count = stats->count;
+	reply.misses = stats->misses;
+	reply.latency_max = stats->latency_max;
+	reply.exec_max = stats->exec_max;
+	reply.ticks_per_ms = clock_ms_to_ticks(PLATFORM_WORKQ_CLOCK, 1);
+	reply.period_us = pipeline_task_period(p);
+	if (buffer) {
+		reply.headroom_min = stats->headroom_min;
+		reply.buffer_size = buffer->size;
+	}
+
+	assert(!memcpy_s(reply.latency_hist, sizeof(reply.latency_hist),
+			 stats->latency_hist, sizeof(stats->latency_hist)));
+	assert(!memcpy_s(reply.exec_hist, sizeof(reply.exec_hist),
+			 stats->exec_hist, sizeof(stats->exec_hist)));
+
+	if (req.flags & SOF_IPC_DEBUG_FLAG_RESET)
+		pipeline_stats_reset(p);
+
+	mailbox_hostbox_write(0, &reply, sizeof(reply));
+	return 1;
+}
+
+static int ipc_debug_heap_stats(uint32_t header)
+{
+	struct sof_ipc_dbg_heap_req req;
+	struct sof_ipc_dbg_heap_stats reply;
+	struct mm_heap_stats stats;
+	int ret;
+	int i;
+
+	/* copy message with ABI safe method */
+	IPC_COPY_CMD(req, _ipc->comp_data);
+
+	trace_ipc("ipc: heap zone %d index %d -> stats", req.zone,
+		  req.index);
+
+	if (req.zone >= RZONE_TYPES) {
+		trace_ipc_error("ipc: heap zone %d not found", req.zone);
+		return -EINVAL;
+	}
+
+	ret = heap_stats(BIT(req.zone), req.index, &stats);
+	if (ret < 0) {
+		trace_ipc_error("ipc: heap zone %d index %d not found",
+				req.zone, req.index);
+		return ret;
+	}
+
+	bzero(&reply, sizeof(reply));
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.zone = req.zone;
+	reply.index = req.index;
+	reply.heaps = stats.heaps;
+	reply.base = stats.base;
+	reply.size = stats.size;
+	reply.caps = stats.caps;
+	reply.used = stats.used;
+	reply.free = stats.free;
+	reply.peak = stats.peak;
+	reply.fails = stats.fail.count;
+	reply.fail_caps = stats.fail.caps;
+	reply.fail_bytes = stats.fail.bytes;
+	reply.num_maps = MIN(stats.maps, SOF_IPC_DEBUG_HEAP_MAPS);
+
+	for (i = 0; i < reply.num_maps; i++) {
+		reply.map[i].block_size = stats.map[i].block_size;
+		reply.map[i].count = stats.map[i].count;
+		reply.map[i].free = stats.map[i].free;
+		reply.map[i].peak = stats.map[i].peak;
+		reply.map[i].largest_free = stats.map[i].largest_free;
+	}
+
+	if (req.flags & SOF_IPC_DEBUG_FLAG_RESET)
+		heap_stats_reset();
+
+	mailbox_hostbox_write(0, &reply, sizeof(reply));
+	return 1;
+}
+
+static int ipc_glb_stats_message(uint32_t header)
+{
+	uint32_t cmd = iCS(header);
+
+	switch (cmd) {
+	case SOF_IPC_DEBUG_COMP_PERF:
+		return ipc_debug_comp_perf(header);
+	case SOF_IPC_DEBUG_PIPE_STATS:
+		return ipc_debug_pipe_stats(header);
+	case SOF_IPC_DEBUG_HEAP_STATS:
+		return ipc_debug_heap_stats(header);
+	default:
+		trace_ipc_error("ipc: unknown stats cmd 0x%x", cmd);
+		return -EINVAL;
+	}
+}
+
 /*
  * Topology IPC Operations.
  */
@@ -1002,8 +1174,7 @@ static int ipc_glb_tplg_pipe_new(uint32_t header)
 
 	trace_ipc("ipc: pipe %d -> new", ipc_pipeline.pipeline_id);
 
-	ret = ipc_pipeline_new(_ipc,
-			       (struct sof_ipc_pipe_new *)_ipc->comp_data);
+	ret = ipc_pipeline_new(_ipc, &ipc_pipeline);
 	if (ret < 0) {
 		trace_ipc_error("ipc: pipe %d creation failed %d",
 				ipc_pipeline.pipeline_id, ret);
@@ -1130,6 +1301,8 @@ int ipc_cmd(void)
 		return ipc_glb_debug_message(hdr->cmd);
 	case SOF_IPC_GLB_GDB_DEBUG:
 		return ipc_glb_gdb_debug(hdr->cmd);
+	case SOF_IPC_GLB_DEBUG:
+		return ipc_glb_stats_message(hdr->cmd);
 	default:
 		trace_ipc_error("ipc: unknown command type %u", type);
 		return -EINVAL;
@@ -36,8 +36,10 @@
 #include <sof/trace.h>
 #include <sof/lock.h>
 #include <sof/cpu.h>
+#include <sof/math/numbers.h>
 #include <platform/memory.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 /* debug to set memory value on every allocation */
 #define DEBUG_BLOCK_FREE 0
@@ -96,9 +98,110 @@ static inline void flush_block_map(struct block_map *map)
 {
 	dcache_writeback_invalidate_region(map->block,
 					   sizeof(*map->block) * map->count);
+	dcache_writeback_invalidate_region(map->free_mask, sizeof(uint32_t) *
+					   BLOCK_MASK_WORDS(map->count));
 	dcache_writeback_invalidate_region(map, sizeof(*map));
 }
 
+/* mark blocks as free in the free block mask */
+static void block_mask_set(struct block_map *map, int block, int count)
+{
+	int i;
+
+	for (i = block; i < block + count; i++)
+		map->free_mask[i >> 5] |= 1U << (i & 31);
+}
+
+/* mark blocks as used in the free block mask */
+static void block_mask_clear(struct block_map *map, int block, int count)
+{
+	int i;
+
+	for (i = block; i < block + count; i++)
+		map->free_mask[i >> 5] &= ~(1U << (i & 31));
+}
+
+/* Finds first block at or after start whose free bit equals free, returns
+ * map->count if there is none. Mask bits past the last block are never
+ * set, so they read as used.
+ */
+static int block_mask_find(struct block_map *map, int start, bool free)
+{
+	int words = BLOCK_MASK_WORDS(map->count);
+	int word = start >> 5;
+	uint32_t mask;
+	int block;
+
+	if (start >= map->count)
+		return map->count;
+
+	mask = free ? map->free_mask[word] : ~map->free_mask[word];
+	mask &= ~0U << (start & 31);
+
+	while (!mask) {
+		if (++word == words)
+			return map->count;
+
+		mask = free ? map->free_mask[word] : ~map->free_mask[word];
+	}
+
+	block = (word << 5) + __builtin_ctz(mask);
+
+	return block < map->count ? block : map->count;
+}
+
+/* Finds first run of count free blocks starting at address aligned to
+ * alignment, returns -1 if there is none. Alignment is 0 or power of 2.
+ */
+static int block_mask_find_run(struct block_map *map, int count,
+			       uint32_t alignment)
+{
+	int start = block_mask_find(map, map->first_free, true);
+	int end;
+
+	while (start + count <= map->count) {
+		end = block_mask_find(map, start, false);
+
+		/* skip to first aligned block of free run */
+		while (alignment && start + count <= end &&
+		       (map->base + start * map->block_size) & (alignment - 1))
+			start++;
+
+		if (end - start >= count)
+			return start;
+
+		start = block_mask_find(map, end, true);
+	}
+
+	return -1;
+}
+
+/* length of longest run of free blocks */
+static int block_mask_largest_run(struct block_map *map)
+{
+	int start = block_mask_find(map, map->first_free, true);
+	int largest = 0;
+	int end;
+
+	while (start < map->count) {
+		end = block_mask_find(map, start, false);
+		if (end - start > largest)
+			largest = end - start;
+
+		start = block_mask_find(map, end, true);
+	}
+
+	return largest;
+}
+
+/* all blocks are free at init */
+static void init_block_map(struct block_map *map)
+{
+	bzero(map->free_mask, sizeof(uint32_t) * BLOCK_MASK_WORDS(map->count));
+	block_mask_set(map, 0, map->count);
+	flush_block_map(map);
+}
+
 /* total size of block */
 static inline uint32_t block_get_size(struct block_map *map)
 {
@@ -151,7 +254,7 @@ static void init_heap_map(struct mm_heap *heap, int count)
 		/* init the map[0] */
 		current_map = &heap[i].map[0];
 		current_map->base = heap[i].heap;
-		flush_block_map(current_map);
+		init_block_map(current_map);
 
 		/* map[j]'s base is calculated based on map[j-1] */
 		for (j = 1; j < heap[i].blocks; j++) {
@@ -160,29 +263,54 @@ static void init_heap_map(struct mm_heap *heap, int count)
 				current_map->block_size *
 				current_map->count;
 			current_map = &heap[i].map[j];
-			flush_block_map(current_map);
+			init_block_map(current_map);
 		}
 
 		dcache_writeback_invalidate_region(&heap[i], sizeof(heap[i]));
 	}
 }
 
+/* update high watermarks of heap and map after allocation */
+static inline void heap_update_peak(struct mm_heap *heap,
+				    struct block_map *map)
+{
+	if (heap->info.used > heap->info.peak)
+		heap->info.peak = heap->info.used;
+
+	if (map->count - map->free_count > map->peak_count)
+		map->peak_count = map->count - map->free_count;
+}
+
+/* record failed allocation, memmap lock held */
+static void alloc_fail(int zone, uint32_t caps, size_t bytes)
+{
+	struct mm_fail *fail =
+		&memmap.fail[__builtin_ctz(zone & RZONE_TYPE_MASK)];
+
+	fail->count++;
+	fail->caps = caps;
+	fail->bytes = bytes;
+}
+
 /* allocate from system memory pool */
-static void *rmalloc_sys(int zone, int caps, int core, size_t bytes)
+static void *rmalloc_sys(int zone, int caps, int core, size_t bytes,
+			 uint32_t align)
 {
 	void *ptr;
 	struct mm_heap *cpu_heap;
 	size_t alignment = 0;
+	uint32_t offset;
 
 	/* use the heap dedicated for the selected core */
 	cpu_heap = memmap.system + core;
 	if ((cpu_heap->caps & caps) != caps)
 		panic(SOF_IPC_PANIC_MEM);
 
-	/* align address to dcache line size */
-	if (cpu_heap->info.used % PLATFORM_DCACHE_ALIGN)
-		alignment = PLATFORM_DCACHE_ALIGN -
-			(cpu_heap->info.used % PLATFORM_DCACHE_ALIGN);
+	/* align address to dcache line size at least */
+	align = MAX(align, PLATFORM_DCACHE_ALIGN);
+	offset = (cpu_heap->heap + cpu_heap->info.used) & (align - 1);
+	if (offset)
+		alignment = align - offset;
 
 	/* always succeeds or panics */
 	if (alignment + bytes > cpu_heap->info.free) {
@@ -198,6 +326,7 @@ static void *rmalloc_sys(int zone, int caps, int core, size_t bytes)
 
 	cpu_heap->info.used += bytes;
 	cpu_heap->info.free -= alignment + bytes;
+	cpu_heap->info.peak = cpu_heap->info.used;
 
 	/* other core should have the latest value */
 	if (core != cpu_get_id())
@@ -217,7 +346,6 @@ static void *alloc_block(struct mm_heap *heap, int level,
 	struct block_map *map = &heap->map[level];
 	struct block_hdr *hdr = &map->block[map->first_free];
 	void *ptr;
-	int i;
 
 	map->free_count--;
 	ptr = (void *)(map->base + map->first_free * map->block_size);
@@ -225,65 +353,59 @@ static void *alloc_block(struct mm_heap *heap, int level,
 	hdr->used = 1;
 	heap->info.used += map->block_size;
 	heap->info.free -= map->block_size;
+	block_mask_clear(map, map->first_free, 1);
+	heap_update_peak(heap, map);
 
 	/* find next free */
-	for (i = map->first_free; i < map->count; ++i) {
-
-		hdr = &map->block[i];
-
-		if (hdr->used == 0) {
-			map->first_free = i;
-			break;
-		}
-	}
+	map->first_free = block_mask_find(map, map->first_free + 1, true);
 
 	return ptr;
 }
 
 /* allocates continuous blocks */
 static void *alloc_cont_blocks(struct mm_heap *heap, int level,
-	uint32_t caps, size_t bytes)
+	uint32_t caps, size_t bytes, uint32_t alignment)
 {
 	struct block_map *map = &heap->map[level];
 	struct block_hdr *hdr;
 	void *ptr;
-	unsigned int start;
-	unsigned int current;
-	unsigned int count = bytes / map->block_size;
-	unsigned int remaining = 0;
+	int start;
+	int current;
+	int count = bytes / map->block_size;
 
 	if (bytes % map->block_size)
 		count++;
 
-	/* check if we have enough consecutive blocks for requested
-	 * allocation size.
-	 */
-	for (current = map->first_free; current < map->count; current++) {
-		hdr = &map->block[current];
-
-		if (!hdr->used)
-			remaining++;
+	/* find enough consecutive free blocks for requested allocation size */
+	if (count > map->free_count) {
+		trace_mem_error("error: %d blocks needed for allocation "
+				"but only %d blocks are free",
+				count, map->free_count);
+		return NULL;
 	}
 
-	if (count > map->count || remaining < count) {
-		trace_mem_error("error: %d blocks needed for allocation "
-				"but only %d blocks are remaining",
-				count, remaining);
+	start = block_mask_find_run(map, count, alignment);
+	if (start < 0) {
+		trace_mem_error("error: no %d consecutive free blocks for "
+				"allocation", count);
 		return NULL;
 	}
 
 	/* we found enough space, let's allocate it */
-	start = map->first_free;
 	map->free_count -= count;
 	ptr = (void *)(map->base + start * map->block_size);
 	hdr = &map->block[start];
 	hdr->size = count;
 	heap->info.used += count * map->block_size;
 	heap->info.free -= count * map->block_size;
-	map->first_free = map->first_free + count;
+	block_mask_clear(map, start, count);
+	heap_update_peak(heap, map);
+
+	if (start == map->first_free)
+		map->first_free = block_mask_find(map, start + count, true);
 
 	/* update each block */
-	for (current = start; current < count; current++) {
+	for (current = start; current < start + count; current++) {
 		hdr = &map->block[current];
 		hdr->used = 1;
 	}
@@ -291,34 +413,60 @@ static void *alloc_cont_blocks(struct mm_heap *heap, int level,
 	return ptr;
 }
 
+/* binary search of heap index for mm_heap that ptr belongs to */
 static struct mm_heap *get_heap_from_ptr(void *ptr)
 {
-	struct mm_heap *heap;
-	int i;
-
-	/* find mm_heap that ptr belongs to */
-	heap = memmap.system_runtime + cpu_get_id();
-	if ((uint32_t)ptr >= heap->heap &&
-	    (uint32_t)ptr < heap->heap + heap->size)
-		return heap;
+	struct mm_heap *heap = NULL;
+	int low = 0;
+	int high = ARRAY_SIZE(memmap.heap_index) - 1;
+	int mid;
+
+	while (low <= high) {
+		mid = (low + high) / 2;
+		if ((uint32_t)ptr >= memmap.heap_index[mid]->heap) {
+			heap = memmap.heap_index[mid];
+			low = mid + 1;
+		} else {
+			high = mid - 1;
+		}
+	}
 
-	for (i = 0; i < PLATFORM_HEAP_RUNTIME; i++) {
-		heap = &memmap.runtime[i];
+	if (!heap || (uint32_t)ptr >= heap->heap + heap->size)
+		return NULL;
 
-		if ((uint32_t)ptr >= heap->heap &&
-		    (uint32_t)ptr < heap->heap + heap->size)
-			return heap;
-	}
+	/* system runtime heap can only be freed by its own core */
+	if (heap >= memmap.system_runtime &&
+	    heap < memmap.system_runtime + PLATFORM_HEAP_SYSTEM_RUNTIME &&
+	    heap != memmap.system_runtime + cpu_get_id())
+		return NULL;
 
-	for (i = 0; i < PLATFORM_HEAP_BUFFER; i++) {
-		heap = &memmap.buffer[i];
+	return heap;
+}
 
-		if ((uint32_t)ptr >= heap->heap &&
-		    (uint32_t)ptr < heap->heap + heap->size)
-			return heap;
+/* binary search of heap maps for block map that ptr belongs to, maps are
+ * laid out in heap memory in ascending address order
+ */
+static struct block_map *get_map_from_ptr(struct mm_heap *heap, void *ptr)
+{
+	struct block_map *map = NULL;
+	int low = 0;
+	int high = heap->blocks - 1;
+	int mid;
+
+	while (low <= high) {
+		mid = (low + high) / 2;
+		if ((uint32_t)ptr >= heap->map[mid].base) {
+			map = &heap->map[mid];
+			low = mid + 1;
+		} else {
+			high = mid - 1;
+		}
 	}
 
-	return NULL;
+	if (!map || (uint32_t)ptr >= map->base + map->block_size * map->count)
+		return NULL;
+
+	return map;
 }
 
 static struct mm_heap *get_heap_from_caps(struct mm_heap *heap, int count,
@@ -338,7 +486,7 @@ static struct mm_heap *get_heap_from_caps(struct mm_heap *heap, int count,
 }
 
 static void *get_ptr_from_heap(struct mm_heap *heap, int zone, uint32_t caps,
-			       size_t bytes)
+			       size_t bytes, uint32_t alignment)
 {
 	struct block_map *map;
 	int i;
@@ -356,9 +504,14 @@ static void *get_ptr_from_heap(struct mm_heap *heap, int zone, uint32_t caps,
 			continue;
 
 		/* free block space exists */
-		ptr = alloc_block(heap, i, caps);
+		if (alignment)
+			ptr = alloc_cont_blocks(heap, i, caps, map->block_size,
+						alignment);
+		else
+			ptr = alloc_block(heap, i, caps);
 
-		break;
+		if (ptr)
+			break;
 	}
 
 	if (ptr && (zone & RZONE_FLAG_MASK) == RZONE_FLAG_UNCACHED)
@@ -386,16 +539,8 @@ static void free_block(void *ptr)
 	}
 
 	/* find block that ptr belongs to */
-	for (i = 0; i < heap->blocks; i++) {
-		block_map = &heap->map[i];
-
-		/* is ptr in this block */
-		if ((uint32_t)ptr < (block_map->base +
-		    (block_map->block_size * block_map->count)))
-			break;
-	}
-
-	if (i == heap->blocks) {
+	block_map = get_map_from_ptr(heap, ptr);
+	if (!block_map) {
 		/* not found */
 		trace_error(TRACE_CLASS_MEM,
 			    "free_block() error: invalid ptr = %p cpu = %d",
@@ -423,6 +568,8 @@ static void free_block(void *ptr)
 		heap->info.free += block_map->block_size;
 	}
 
+	block_mask_set(block_map, block, used_blocks - block);
+
 	/* set first free block */
 	if (block < block_map->first_free)
 		block_map->first_free = block;
@@ -511,7 +658,8 @@ void alloc_trace_buffer_heap(int zone, uint32_t caps, size_t bytes)
 #endif
 
 /* allocate single block for system runtime */
-static void *rmalloc_sys_runtime(int zone, int caps, int core, size_t bytes)
+static void *rmalloc_sys_runtime(int zone, int caps, int core, size_t bytes,
+				 uint32_t alignment)
 {
 	struct mm_heap *cpu_heap;
 	void *ptr;
@@ -521,7 +669,7 @@ static void *rmalloc_sys_runtime(int zone, int caps, int core, size_t bytes)
 	if ((cpu_heap->caps & caps) != caps)
 		panic(SOF_IPC_PANIC_MEM);
 
-	ptr = get_ptr_from_heap(cpu_heap, zone, caps, bytes);
+	ptr = get_ptr_from_heap(cpu_heap, zone, caps, bytes, alignment);
 
 	/* other core should have the latest value */
 	if (core != cpu_get_id())
@@ -532,7 +680,8 @@ static void *rmalloc_sys_runtime(int zone, int caps, int core, size_t bytes)
 }
 
 /* allocate single block for runtime */
-static void *rmalloc_runtime(int zone, uint32_t caps, size_t bytes)
+static void *rmalloc_runtime(int zone, uint32_t caps, size_t bytes,
+			     uint32_t alignment)
 {
 	struct mm_heap *heap;
 
@@ -552,11 +701,198 @@ static void *rmalloc_runtime(int zone, uint32_t caps, size_t bytes)
 		}
 	}
 
-	return get_ptr_from_heap(heap, zone, caps, bytes);
+	return get_ptr_from_heap(heap, zone, caps, bytes, alignment);
 }
 
-/* allocates memory - not for direct use, clients use rmalloc() */
-void *_malloc(int zone, uint32_t caps, size_t bytes)
+/* Per core caches of free blocks from the small block maps of the first
+ * runtime heap. Blocks in a magazine are accounted as used by the heap.
+ * Magazines are cached and only ever touched by their own core with local
+ * interrupts disabled, so same core alloc/free pairs take no lock and do
+ * no cache maintenance. Another core can't write back the owner's dirty
+ * lines, so a failed allocation drains the magazines of its own core and
+ * only requests a drain from the other cores. Each core gives its blocks
+ * back on its next magazine call. Requests are accessed uncached.
+ */
+#define MAGAZINE_MAPS		4	/* number of cached block maps */
+#define MAGAZINE_BLOCK_SIZE	256	/* largest cached block size */
+#define MAGAZINE_DEPTH		4	/* max blocks per magazine */
+#define MAGAZINE_REFILL		2	/* blocks taken from heap on refill */
+
+struct magazine {
+	uint32_t count;
+	void *block[MAGAZINE_DEPTH];
+};
+
+struct core_magazines {
+	struct magazine mag[MAGAZINE_MAPS];
+} __attribute__ ((__aligned__(PLATFORM_DCACHE_ALIGN)));
+
+/* drain requests follow the line aligned magazines in a line of their own */
+static struct {
+	struct core_magazines core[PLATFORM_CORE_COUNT];
+	uint32_t drain_req[PLATFORM_CORE_COUNT];
+} magazines;
+
+/* uncached drain request flag of core */
+static inline uint32_t *magazines_req(int core)
+{
+	return cache_to_uncache(&magazines.drain_req[core]);
+}
+
+/* map index of magazine for heap and block size, -1 if not cached */
+static int magazine_map(struct mm_heap *heap, size_t bytes)
+{
+	int i;
+
+	for (i = 0; i < heap->blocks && i < MAGAZINE_MAPS; i++) {
+		if (heap->map[i].block_size > MAGAZINE_BLOCK_SIZE)
+			return -1;
+
+		if (heap->map[i].block_size >= bytes)
+			return i;
+	}
+
+	return -1;
+}
+
+/* give magazine blocks of this core back to heap, memmap lock held */
+static void magazines_return(void)
+{
+	struct core_magazines *core = &magazines.core[cpu_get_id()];
+	struct magazine *mag;
+	int i;
+
+	for (i = 0; i < MAGAZINE_MAPS; i++) {
+		mag = &core->mag[i];
+		while (mag->count)
+			free_block(mag->block[--mag->count]);
+	}
+
+	*magazines_req(cpu_get_id()) = 0;
+}
+
+/* serve drain request of another core before using magazines */
+static void magazines_check_drain(void)
+{
+	uint32_t flags;
+
+	if (!*magazines_req(cpu_get_id()))
+		return;
+
+	spin_lock_irq(&memmap.lock, flags);
+	magazines_return();
+	spin_unlock_irq(&memmap.lock, flags);
+	memmap.heap_trace_updated = 1;
+}
+
+/* allocate single block from magazine of this core */
+static void *rmalloc_magazine(int zone, uint32_t caps, size_t bytes)
+{
+	struct mm_heap *heap = memmap.runtime;
+	struct core_magazines *core = &magazines.core[cpu_get_id()];
+	struct magazine *mag;
+	void *ptr = NULL;
+	uint32_t flags;
+	int level;
+
+	if ((heap->caps & caps) != caps)
+		return NULL;
+
+	level = magazine_map(heap, bytes);
+	if (level < 0)
+		return NULL;
+
+	magazines_check_drain();
+
+	mag = &core->mag[level];
+
+	flags = interrupt_global_disable();
+	if (mag->count)
+		ptr = mag->block[--mag->count];
+	interrupt_global_enable(flags);
+
+	if (ptr)
+		goto out;
+
+	/* refill in bulk from shared heap */
+	spin_lock_irq(&memmap.lock, flags);
+
+	while (mag->count < MAGAZINE_REFILL && heap->map[level].free_count)
+		mag->block[mag->count++] = alloc_block(heap, level, caps);
+
+	if (mag->count)
+		ptr = mag->block[--mag->count];
+
+	spin_unlock_irq(&memmap.lock, flags);
+	memmap.heap_trace_updated = 1;
+
+out:
+	if (ptr && (zone & RZONE_FLAG_MASK) == RZONE_FLAG_UNCACHED)
+		ptr = cache_to_uncache(ptr);
+
+	return ptr;
+}
+
+/* keep freed block in magazine of this core, returns false if it can't */
+static bool rfree_magazine(void *ptr)
+{
+	struct mm_heap *heap = get_heap_from_ptr(ptr);
+	struct block_map *map;
+	struct magazine *mag;
+	uint32_t flags;
+	bool cached = false;
+	int level;
+	int block;
+
+	if (heap != memmap.runtime)
+		return false;
+
+	map = get_map_from_ptr(heap, ptr);
+	if (!map || map->block_size > MAGAZINE_BLOCK_SIZE)
+		return false;
+
+	level = map - heap->map;
+	if (level >= MAGAZINE_MAPS)
+		return false;
+
+	/* only single aligned blocks, anything else is checked by free */
+	block = ((uint32_t)ptr - map->base) / map->block_size;
+	if (map->base + block * map->block_size != (uint32_t)ptr ||
+	    map->block[block].size != 1)
+		return false;
+
+	magazines_check_drain();
+
+	mag = &magazines.core[cpu_get_id()].mag[level];
+
+	flags = interrupt_global_disable();
+
+	if (mag->count < MAGAZINE_DEPTH) {
+		mag->block[mag->count++] = ptr;
+		cached = true;
+	}
+
+	interrupt_global_enable(flags);
+
+	return cached;
+}
+
+/* drain magazines of this core and request it from others, memmap lock held */
+static void magazines_drain(void)
+{
+	int i;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++) {
+		if (i == cpu_get_id())
+			magazines_return();
+		else
+			*magazines_req(i) = 1;
+	}
+}
+
+/* allocates memory from zone aligned to alignment, 0 for block alignment */
+static void *rmalloc_zone(int zone, uint32_t caps, size_t bytes,
+			  uint32_t alignment)
 {
 	uint32_t flags;
 	void *ptr = NULL;
@@ -565,13 +901,19 @@ void *_malloc(int zone, uint32_t caps, size_t bytes)
 
 	switch (zone & RZONE_TYPE_MASK) {
 	case RZONE_SYS:
-		ptr = rmalloc_sys(zone, caps, cpu_get_id(), bytes);
+		ptr = rmalloc_sys(zone, caps, cpu_get_id(), bytes, alignment);
 		break;
 	case RZONE_SYS_RUNTIME:
-		ptr = rmalloc_sys_runtime(zone, caps, cpu_get_id(), bytes);
+		ptr = rmalloc_sys_runtime(zone, caps, cpu_get_id(), bytes,
+					  alignment);
 		break;
 	case RZONE_RUNTIME:
-		ptr = rmalloc_runtime(zone, caps, bytes);
+		ptr = rmalloc_runtime(zone, caps, bytes, alignment);
+		if (!ptr) {
+			/* blocks may be held by magazines of this core */
+			magazines_drain();
+			ptr = rmalloc_runtime(zone, caps, bytes, alignment);
+		}
 		break;
 	default:
 		trace_mem_error("rmalloc() error: invalid zone");
@@ -579,6 +921,9 @@ void *_malloc(int zone, uint32_t caps, size_t bytes)
 		break;
 	}
 
+	if (!ptr)
+		alloc_fail(zone, caps, bytes);
+
 #if DEBUG_BLOCK_FREE
 	if (ptr)
 		bzero(ptr, bytes);
@@ -589,6 +934,24 @@ void *_malloc(int zone, uint32_t caps, size_t bytes)
 	return ptr;
 }
 
+/* allocates memory - not for direct use, clients use rmalloc() */
+void *_malloc(int zone, uint32_t caps, size_t bytes)
+{
+	void *ptr;
+
+	if ((zone & RZONE_TYPE_MASK) == RZONE_RUNTIME) {
+		ptr = rmalloc_magazine(zone, caps, bytes);
+		if (ptr) {
+#if DEBUG_BLOCK_FREE
+			bzero(ptr, bytes);
+#endif
+			return ptr;
+		}
+	}
+
+	return rmalloc_zone(zone, caps, bytes, 0);
+}
+
 /* allocates and clears memory - not for direct use, clients use rzalloc() */
 void *_zalloc(int zone, uint32_t caps, size_t bytes)
 {
@@ -602,6 +965,23 @@ void *_zalloc(int zone, uint32_t caps, size_t bytes)
 	return ptr;
 }
 
+void *rzalloc_align(int zone, uint32_t caps, size_t bytes, uint32_t alignment)
+{
+	void *ptr;
+
+	if (alignment & (alignment - 1)) {
+		trace_mem_error("rzalloc_align() error: invalid alignment %u",
+				alignment);
+		return NULL;
+	}
+
+	ptr = rmalloc_zone(zone, caps, bytes, alignment);
+	if (ptr)
+		bzero(ptr, bytes);
+
+	return ptr;
+}
+
 void *rzalloc_core_sys(int core, size_t bytes)
 {
 	uint32_t flags;
@@ -609,7 +989,7 @@ void *rzalloc_core_sys(int core, size_t bytes)
 
 	spin_lock_irq(&memmap.lock, flags);
 
-	ptr = rmalloc_sys(RZONE_SYS, 0, core, bytes);
+	ptr = rmalloc_sys(RZONE_SYS, 0, core, bytes, 0);
 	if (ptr)
 		bzero(ptr, bytes);
 
@@ -620,7 +1000,7 @@ void *rzalloc_core_sys(int core, size_t bytes)
 
 /* allocates continuous buffers - not for direct use, clients use rballoc() */
 static void *alloc_heap_buffer(struct mm_heap *heap, int zone, uint32_t caps,
-			       size_t bytes)
+			       size_t bytes, uint32_t alignment)
 {
 	struct block_map *map;
 	int i;
@@ -633,8 +1013,14 @@ static void *alloc_heap_buffer(struct mm_heap *heap, int zone, uint32_t caps,
 		/* Check if blocks are big enough and at least one is free */
 		if (map->block_size >= bytes && map->free_count) {
 			/* found: grab a block */
-			ptr = alloc_block(heap, i, caps);
-			break;
+			if (alignment)
+				ptr = alloc_cont_blocks(heap, i, caps, bytes,
+							alignment);
+			else
+				ptr = alloc_block(heap, i, caps);
+
+			if (ptr)
+				break;
 		}
 	}
 
@@ -649,7 +1035,8 @@ static void *alloc_heap_buffer(struct mm_heap *heap, int zone, uint32_t caps,
 
 			/* allocate if block size is smaller than request */
 			if (heap->size >= bytes && map->block_size < bytes) {
-				ptr = alloc_cont_blocks(heap, i, caps, bytes);
+				ptr = alloc_cont_blocks(heap, i, caps, bytes,
+							alignment);
 				if (ptr)
 					break;
 			}
@@ -667,15 +1054,13 @@ static void *alloc_heap_buffer(struct mm_heap *heap, int zone, uint32_t caps,
 	return ptr;
 }
 
-/* allocates continuous buffers - not for direct use, clients use rballoc() */
-void *_balloc(int zone, uint32_t caps, size_t bytes)
+/* allocates continuous buffers from any heap with caps, memmap lock held */
+static void *alloc_heaps_buffer(int zone, uint32_t caps, size_t bytes,
+				uint32_t alignment)
 {
 	struct mm_heap *heap;
 	unsigned int i, n;
 	void *ptr = NULL;
-	uint32_t flags;
-
-	spin_lock_irq(&memmap.lock, flags);
 
 	for (i = 0, n = PLATFORM_HEAP_BUFFER, heap = memmap.buffer;
 	     i < PLATFORM_HEAP_BUFFER;
@@ -684,16 +1069,62 @@ void *_balloc(int zone, uint32_t caps, size_t bytes)
 		if (!heap)
 			break;
 
-		ptr = alloc_heap_buffer(heap, zone, caps, bytes);
+		ptr = alloc_heap_buffer(heap, zone, caps, bytes, alignment);
 		if (ptr)
 			break;
 
 		/* Continue from the next heap */
 	}
 
+	return ptr;
+}
+
+/* allocates continuous buffers aligned to alignment, 0 for block alignment */
+static void *rballoc_heaps(int zone, uint32_t caps, size_t bytes,
+			   uint32_t alignment)
+{
+	void *ptr;
+	uint32_t flags;
+
+	spin_lock_irq(&memmap.lock, flags);
+	ptr = alloc_heaps_buffer(zone, caps, bytes, alignment);
 	spin_unlock_irq(&memmap.lock, flags);
 
-	return ptr;
+	if (ptr)
+		return ptr;
+
+	/* reclaim frees memory, so it's called without the lock held */
+	if (memmap.buffer_reclaim && memmap.buffer_reclaim()) {
+		spin_lock_irq(&memmap.lock, flags);
+		ptr = alloc_heaps_buffer(zone, caps, bytes, alignment);
+		spin_unlock_irq(&memmap.lock, flags);
+
+		if (ptr)
+			return ptr;
+	}
+
+	spin_lock_irq(&memmap.lock, flags);
+	alloc_fail(zone, caps, bytes);
+	spin_unlock_irq(&memmap.lock, flags);
+
+	return NULL;
+}
+
+/* allocates continuous buffers - not for direct use, clients use rballoc() */
+void *_balloc(int zone, uint32_t caps, size_t bytes)
+{
+	return rballoc_heaps(zone, caps, bytes, 0);
+}
+
+void *rballoc_align(int zone, uint32_t caps, size_t bytes, uint32_t alignment)
+{
+	if (alignment & (alignment - 1)) {
+		trace_mem_error("rballoc_align() error: invalid alignment %u",
+				alignment);
+		return NULL;
+	}
+
+	return rballoc_heaps(zone, caps, bytes, alignment);
 }
 
 void rfree(void *ptr)
@@ -721,6 +1152,10 @@ void rfree(void *ptr)
 		panic(SOF_IPC_PANIC_MEM);
 	}
 
+	/* same core frees of small blocks are cached */
+	if (rfree_magazine(ptr))
+		return;
+
 	/* free the block */
 	spin_lock_irq(&memmap.lock, flags);
 	free_block(ptr);
@@ -728,6 +1163,99 @@ void rfree(void *ptr)
 	memmap.heap_trace_updated = 1;
 }
 
+/* Returns size in bytes of block allocation at ptr after growing it in
+ * place to at least bytes when the blocks following it are free, or 0 if
+ * ptr is not a block allocation. memmap lock held.
+ */
+static uint32_t grow_blocks(void *ptr, size_t bytes)
+{
+	struct mm_heap *heap;
+	struct block_map *map;
+	struct block_hdr *hdr;
+	int block;
+	int count;
+	int extra;
+	int end;
+	int i;
+
+	heap = get_heap_from_ptr(ptr);
+	if (!heap)
+		return 0;
+
+	map = get_map_from_ptr(heap, ptr);
+	if (!map)
+		return 0;
+
+	block = ((uint32_t)ptr - map->base) / map->block_size;
+	hdr = &map->block[block];
+	if (map->base + block * map->block_size != (uint32_t)ptr ||
+	    !hdr->size)
+		return 0;
+
+	count = (bytes + map->block_size - 1) / map->block_size;
+	end = block + hdr->size;
+	if (count <= hdr->size ||
+	    block + count > block_mask_find(map, end, false))
+		return hdr->size * map->block_size;
+
+	/* following blocks are free, add them to allocation */
+	extra = block + count - end;
+	for (i = end; i < block + count; i++)
+		map->block[i].used = 1;
+
+	hdr->size = count;
+	map->free_count -= extra;
+	heap->info.used += extra * map->block_size;
+	heap->info.free -= extra * map->block_size;
+	block_mask_clear(map, end, extra);
+	heap_update_peak(heap, map);
+
+	if (map->first_free >= end && map->first_free < block + count)
+		map->first_free = block_mask_find(map, block + count, true);
+
+	return count * map->block_size;
+}
+
+void *rrealloc(void *ptr, int zone, uint32_t caps, size_t bytes)
+{
+	void *cached_ptr = ptr;
+	void *new_ptr;
+	uint32_t flags;
+	uint32_t size = 0;
+
+	if (ptr) {
+		/* operate only on cached addresses */
+		if (is_uncached(ptr))
+			cached_ptr = uncache_to_cache(ptr);
+
+		spin_lock_irq(&memmap.lock, flags);
+		size = grow_blocks(cached_ptr, bytes);
+		spin_unlock_irq(&memmap.lock, flags);
+
+		if (!size) {
+			trace_mem_error("rrealloc() error: invalid ptr = %p",
+					(uintptr_t)ptr);
+			return NULL;
+		}
+
+		if (size >= bytes)
+			return ptr;
+	}
+
+	/* move to new allocation */
+	if ((zone & RZONE_TYPE_MASK) == RZONE_BUFFER)
+		new_ptr = _balloc(zone, caps, bytes);
+	else
+		new_ptr = _malloc(zone, caps, bytes);
+
+	if (new_ptr && ptr) {
+		rmemcpy(new_ptr, ptr, size);
+		rfree(ptr);
+	}
+
+	return new_ptr;
+}
+
 /* TODO: all mm_pm_...() routines to be implemented for IMR storage */
 uint32_t mm_pm_context_size(void)
 {
@@ -820,9 +1348,134 @@ void heap_trace_all(int force) { }
 void heap_trace(struct mm_heap *heap, int size) { }
 #endif
 
+/* heaps of zone type and their number */
+static struct mm_heap *heap_zone(int zone, int *count)
+{
+	switch (zone & RZONE_TYPE_MASK) {
+	case RZONE_SYS:
+		*count = PLATFORM_HEAP_SYSTEM;
+		return memmap.system;
+	case RZONE_SYS_RUNTIME:
+		*count = PLATFORM_HEAP_SYSTEM_RUNTIME;
+		return memmap.system_runtime;
+	case RZONE_RUNTIME:
+		*count = PLATFORM_HEAP_RUNTIME;
+		return memmap.runtime;
+	case RZONE_BUFFER:
+		*count = PLATFORM_HEAP_BUFFER;
+		return memmap.buffer;
+	default:
+		return NULL;
+	}
+}
+
+int heap_stats(int zone, int index, struct mm_heap_stats *stats)
+{
+	struct mm_map_stats *map_stats;
+	struct block_map *map;
+	struct mm_heap *heap;
+	uint32_t flags;
+	int count;
+	int i;
+
+	heap = heap_zone(zone, &count);
+	if (!heap || index < 0 || index >= count)
+		return -EINVAL;
+
+	heap += index;
+
+	bzero(stats, sizeof(*stats));
+
+	spin_lock_irq(&memmap.lock, flags);
+
+	stats->heaps = count;
+	stats->base = heap->heap;
+	stats->size = heap->size;
+	stats->caps = heap->caps;
+	stats->used = heap->info.used;
+	stats->free = heap->info.free;
+	stats->peak = heap->info.peak;
+	stats->fail = memmap.fail[__builtin_ctz(zone & RZONE_TYPE_MASK)];
+	stats->maps = MIN(heap->blocks, HEAP_STATS_MAPS);
+
+	for (i = 0; i < stats->maps; i++) {
+		map = &heap->map[i];
+		map_stats = &stats->map[i];
+
+		map_stats->block_size = map->block_size;
+		map_stats->count = map->count;
+		map_stats->free = map->free_count;
+		map_stats->peak = map->peak_count;
+		map_stats->largest_free = block_mask_largest_run(map);
+	}
+
+	spin_unlock_irq(&memmap.lock, flags);
+
+	return 0;
+}
+
+/* restart high watermarks of heaps in zone */
+static void heap_zone_reset(int zone)
+{
+	struct block_map *map;
+	struct mm_heap *heap;
+	int count;
+	int i;
+	int j;
+
+	heap = heap_zone(zone, &count);
+
+	for (i = 0; i < count; i++) {
+		heap[i].info.peak = heap[i].info.used;
+
+		for (j = 0; j < heap[i].blocks; j++) {
+			map = &heap[i].map[j];
+			map->peak_count = map->count - map->free_count;
+		}
+	}
+}
+
+void heap_stats_reset(void)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&memmap.lock, flags);
+
+	heap_zone_reset(RZONE_SYS);
+	heap_zone_reset(RZONE_SYS_RUNTIME);
+	heap_zone_reset(RZONE_RUNTIME);
+	heap_zone_reset(RZONE_BUFFER);
+	bzero(memmap.fail, sizeof(memmap.fail));
+
+	spin_unlock_irq(&memmap.lock, flags);
+}
+
+void heap_set_buffer_reclaim(int (*reclaim)(void))
+{
+	memmap.buffer_reclaim = reclaim;
+}
+
+/* add heaps to heap index keeping it sorted by address */
+static void init_heap_index(struct mm_heap *heap, int count, int *size)
+{
+	int i;
+	int j;
+
+	for (i = 0; i < count; i++) {
+		for (j = *size; j > 0 &&
+		     memmap.heap_index[j - 1]->heap > heap[i].heap; j--)
+			memmap.heap_index[j] = memmap.heap_index[j - 1];
+
+		memmap.heap_index[j] = &heap[i];
+		(*size)++;
+	}
+}
+
 /* initialise map */
 void init_heap(struct sof *sof)
 {
+	int size = 0;
+
 	/* sanity check for malformed images or loader issues */
 	if (memmap.system[0].heap != HEAP_SYSTEM_0_BASE)
 		panic(SOF_IPC_PANIC_MEM);
@@ -835,6 +1488,13 @@ void init_heap(struct sof *sof)
 
 	init_heap_map(memmap.buffer, PLATFORM_HEAP_BUFFER);
 
+	init_heap_index(memmap.system_runtime, PLATFORM_HEAP_SYSTEM_RUNTIME,
+			&size);
+	init_heap_index(memmap.runtime, PLATFORM_HEAP_RUNTIME, &size);
+	init_heap_index(memmap.buffer, PLATFORM_HEAP_BUFFER, &size);
+	dcache_writeback_invalidate_region(memmap.heap_index,
+					   sizeof(memmap.heap_index));
+
 #if DEBUG_BLOCK_FREE
 	write_pattern((struct mm_heap *)&memmap.buffer, PLATFORM_HEAP_BUFFER,
 				  DEBUG_BLOCK_FREE_VALUE);
@@ -37,6 +37,8 @@
 #include <sof/lock.h>
 #include <sof/notifier.h>
 #include <sof/cpu.h>
+#include <sof/schedule.h>
+#include <platform/timer.h>
 #include <platform/clk.h>
 #include <platform/clk-map.h>
 #include <platform/platform.h>
@@ -52,6 +54,12 @@
 #define trace_clk_error(__e, ...) \
 	trace_error(TRACE_CLASS_CLK, __e, ##__VA_ARGS__)
 
+/* clock governor period in microseconds */
+#define CLK_GOV_PERIOD		10000
+
+/* periods with lower load before clock is scaled down */
+#define CLK_GOV_DOWN_PERIODS	50
+
 typedef int (*set_frequency)(uint32_t);
 
 struct clk_data {
@@ -68,6 +76,20 @@ struct clk_pdata {
 
 static struct clk_pdata *clk_pdata;
 
+#if CONFIG_CLK_GOVERNOR
+/* load based clock scaling of one core */
+struct clk_governor {
+	struct task work;
+	uint64_t last_time;	/* timer at end of last period */
+	uint64_t last_busy;	/* core busy time at end of last period */
+	uint32_t down_hz;	/* highest need while waiting to scale down */
+	uint32_t down_count;	/* periods waited to scale down */
+	uint32_t active;	/* active pipelines scheduled on core */
+};
+
+static struct clk_governor *clk_gov[PLATFORM_CORE_COUNT];
+#endif
+
 static inline uint32_t clock_get_freq(const struct freq_table *table,
 				      uint32_t size, uint32_t hz)
 {
@@ -172,3 +194,117 @@ void clock_init(void)
 			ssp_freq[SSP_DEFAULT_IDX].ticks_per_msec;
 	spinlock_init(&clk_pdata->clk[CLK_SSP].lock);
 }
+
+#if CONFIG_CLK_GOVERNOR
+/*
+ * Picks the lowest CPU frequency at which the cycles used in the last
+ * period still leave the configured headroom. Clock goes up at once to
+ * avoid xruns, but goes down only after the load stayed lower for
+ * CLK_GOV_DOWN_PERIODS, to the highest frequency needed meanwhile.
+ */
+static uint64_t clock_governor_run(void *data)
+{
+	struct clk_governor *gov = data;
+	int clock = CLK_CPU(cpu_get_id());
+	uint32_t freq = clk_pdata->clk[clock].freq;
+	uint64_t current = platform_timer_get(platform_timer);
+	uint64_t busy = schedule_load_busy();
+	uint64_t elapsed = current - gov->last_time;
+	uint64_t hz;
+	uint32_t cur_idx;
+	uint32_t idx;
+
+	if (!elapsed)
+		return CLK_GOV_PERIOD;
+
+	/* frequency that would run the busy cycles within headroom */
+	hz = (busy - gov->last_busy) * freq / elapsed * 100 /
+		(100 - CONFIG_CLK_GOVERNOR_HEADROOM);
+
+	gov->last_time = current;
+	gov->last_busy = busy;
+
+	idx = clock_get_freq(cpu_freq, ARRAY_SIZE(cpu_freq), hz);
+	cur_idx = clock_get_freq(cpu_freq, ARRAY_SIZE(cpu_freq), freq);
+
+	if (idx > cur_idx) {
+		tracev_clk("clock_governor_run() up, core %d hz %u",
+			   cpu_get_id(), cpu_freq[idx].freq);
+		gov->down_count = 0;
+		clock_set_freq(clock, cpu_freq[idx].freq);
+	} else if (idx < cur_idx) {
+		if (!gov->down_count || hz > gov->down_hz)
+			gov->down_hz = hz;
+
+		if (++gov->down_count >= CLK_GOV_DOWN_PERIODS) {
+			tracev_clk("clock_governor_run() down, core %d hz %u",
+				   cpu_get_id(), gov->down_hz);
+			gov->down_count = 0;
+			clock_set_freq(clock, gov->down_hz);
+		}
+	} else {
+		gov->down_count = 0;
+	}
+
+	return CLK_GOV_PERIOD;
+}
+
+int clock_governor_init(void)
+{
+	struct clk_governor *gov;
+
+	trace_clk("clock_governor_init(), core %d", cpu_get_id());
+
+	gov = rzalloc(RZONE_SYS, SOF_MEM_CAPS_RAM, sizeof(*gov));
+	if (!gov) {
+		trace_clk_error("clock_governor_init() error: alloc failed");
+		return -ENOMEM;
+	}
+
+	schedule_task_init(&gov->work, SOF_SCHEDULE_LL, SOF_TASK_PRI_LOW,
+			   clock_governor_run, gov, cpu_get_id(), 0);
+	clk_gov[cpu_get_id()] = gov;
+
+	/* no pipeline is running yet */
+	clock_set_freq(CLK_CPU(cpu_get_id()), cpu_freq[0].freq);
+
+	return 0;
+}
+
+/* Governor runs only while pipelines are active on the core, so idle cores
+ * are not woken up by it. Triggers are serialized with interrupts disabled
+ * on the core of the pipeline.
+ */
+void clock_governor_start(void)
+{
+	struct clk_governor *gov = clk_gov[cpu_get_id()];
+
+	if (!gov || gov->active++)
+		return;
+
+	trace_clk("clock_governor_start(), core %d", cpu_get_id());
+
+	/* start at default clock, scaled down once load is known */
+	clock_set_freq(CLK_CPU(cpu_get_id()), cpu_freq[CPU_DEFAULT_IDX].freq);
+
+	gov->last_time = platform_timer_get(platform_timer);
+	gov->last_busy = schedule_load_busy();
+	gov->down_count = 0;
+	schedule_task(&gov->work, CLK_GOV_PERIOD, 0, 0);
+}
+
+void clock_governor_stop(void)
+{
+	struct clk_governor *gov = clk_gov[cpu_get_id()];
+
+	if (!gov || !gov->active || --gov->active)
+		return;
+
+	trace_clk("clock_governor_stop(), core %d", cpu_get_id());
+
+	schedule_task_cancel(&gov->work);
+
+	/* nothing is running, core can idle at the lowest clock */
+	clock_set_freq(CLK_CPU(cpu_get_id()), cpu_freq[0].freq);
+}
+#endif
@@ -46,15 +46,25 @@
 #include <sof/drivers/timer.h>
 #include <sof/task.h>
 
+/*
+ * Queued tasks are kept in two binary min-heaps of the same size. The ready
+ * heap gives the next task to run, the deadline heap gives the tasks that
+ * missed their deadline without walking the whole queue.
+ */
 struct edf_schedule_data {
 	spinlock_t lock;
-	struct list_item list;	/* list of tasks in priority queue */
+	struct task **heap[EDF_HEAP_COUNT];	/* queued tasks */
+	uint32_t heap_size;	/* number of queued tasks */
+	uint32_t heap_max;	/* capacity of heaps */
 	struct list_item idle_list; /* list of queued idle tasks */
 	uint32_t clock;
 };
 
 #define SLOT_ALIGN_TRIES	10
 
+/* initial capacity of ready queue heaps */
+#define EDF_HEAP_INIT_SIZE	8
+
 static void schedule_edf(void);
 static void schedule_edf_task(struct task *task, uint64_t start,
 			      uint64_t deadline, uint32_t flags);
@@ -97,86 +107,197 @@ static inline void edf_reschedule(struct task *task, uint64_t current)
 	edf_pdata->deadline = task->start + delta;
 }
 
-/*
- * Find the first non running task with the earliest deadline.
- * TODO: Reduce cache invalidations by checking if the currently
- * running task AND the earliest queued task will both complete before their
- * deadlines. If so, then schedule the earlier queued task after the currently
- * running task has completed.
- */
-static inline struct task *edf_get_next(uint64_t current, struct task *ignore)
+/* does task a go before task b in heap ? */
+static inline bool edf_task_before(int heap, struct task *a, struct task *b)
 {
-	struct edf_schedule_data *sch =
-		(*arch_schedule_get_data())->edf_sch_data;
-	struct list_item *clist;
-	struct list_item *tlist;
-	uint64_t next_delta = UINT64_MAX;
-	int next_priority = SOF_TASK_PRI_LOW;
-	uint64_t delta;
-	uint64_t deadline;
-	int reschedule = 0;
-	struct task *edf_task_next = NULL;
-	struct task *edf_task;
-	struct edf_task_pdata *edf_pdata;
+	struct edf_task_pdata *a_pdata = edf_sch_get_pdata(a);
+	struct edf_task_pdata *b_pdata = edf_sch_get_pdata(b);
 
-	/* any tasks in the scheduler ? */
-	if (list_is_empty(&sch->list)) {
-		return NULL;
+	/* highest priority first in ready heap */
+	if (heap == EDF_HEAP_READY && a->priority != b->priority)
+		return a->priority < b->priority;
+
+	/* then earliest deadline */
+	return a_pdata->deadline < b_pdata->deadline;
+}
+
+static inline void edf_heap_set(struct edf_schedule_data *sch, int heap,
+				uint32_t i, struct task *task)
+{
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
+
+	sch->heap[heap][i] = task;
+	edf_pdata->heap_index[heap] = i;
+}
+
+static void edf_heap_sift_up(struct edf_schedule_data *sch, int heap,
+			     uint32_t i)
+{
+	struct task *task = sch->heap[heap][i];
+	uint32_t parent;
+
+	while (i) {
+		parent = (i - 1) / 2;
+		if (!edf_task_before(heap, task, sch->heap[heap][parent]))
+			break;
+
+		edf_heap_set(sch, heap, i, sch->heap[heap][parent]);
+		i = parent;
 	}
 
-	/* check every queued or running task in list */
-	list_for_item_safe(clist, tlist, &sch->list) {
-		edf_task = container_of(clist, struct task, list);
+	edf_heap_set(sch, heap, i, task);
+}
+
+static void edf_heap_sift_down(struct edf_schedule_data *sch, int heap,
+			       uint32_t i)
+{
+	struct task *task = sch->heap[heap][i];
+	struct task **tasks = sch->heap[heap];
+	uint32_t child;
 
-		/* only check queued tasks */
-		if (edf_task->state != SOF_TASK_STATE_QUEUED)
-			continue;
+	while ((child = 2 * i + 1) < sch->heap_size) {
+		/* pick the child that goes first */
+		if (child + 1 < sch->heap_size &&
+		    edf_task_before(heap, tasks[child + 1], tasks[child]))
+			child++;
+
+		if (!edf_task_before(heap, tasks[child], task))
+			break;
+
+		edf_heap_set(sch, heap, i, tasks[child]);
+		i = child;
+	}
+
+	edf_heap_set(sch, heap, i, task);
+}
+
+/* add task to ready queue, growing the heaps when full */
+static int edf_heap_insert(struct edf_schedule_data *sch, struct task *task)
+{
+	struct task **tasks;
+	uint32_t heap_max;
+	int heap;
+
+	if (sch->heap_size == sch->heap_max) {
+		heap_max = sch->heap_max ? 2 * sch->heap_max :
+			EDF_HEAP_INIT_SIZE;
+
+		for (heap = 0; heap < EDF_HEAP_COUNT; heap++) {
+			tasks = rrealloc(sch->heap[heap], RZONE_RUNTIME,
+					 SOF_MEM_CAPS_RAM,
+					 heap_max * sizeof(*tasks));
+			if (!tasks) {
+				trace_edf_sch_error("edf_heap_insert() error: "
+						    "no memory for %d tasks",
+						    heap_max);
+				return -ENOMEM;
+			}
+
+			sch->heap[heap] = tasks;
+		}
+
+		sch->heap_max = heap_max;
+	}
+
+	for (heap = 0; heap < EDF_HEAP_COUNT; heap++) {
+		sch->heap[heap][sch->heap_size] = task;
+		edf_heap_sift_up(sch, heap, sch->heap_size);
+	}
 
-		/* ignore the ignored tasks */
-		if (edf_task == ignore)
+	sch->heap_size++;
+
+	return 0;
+}
+
+/* remove task from ready queue */
+static void edf_heap_remove(struct edf_schedule_data *sch, struct task *task)
+{
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
+	struct task *last;
+	uint32_t i;
+	int heap;
+
+	sch->heap_size--;
+
+	for (heap = 0; heap < EDF_HEAP_COUNT; heap++) {
+		i = edf_pdata->heap_index[heap];
+		edf_pdata->heap_index[heap] = EDF_HEAP_NONE;
+
+		/* fill the hole with the last task and restore heap order */
+		last = sch->heap[heap][sch->heap_size];
+		if (i == sch->heap_size)
 			continue;
 
+		edf_heap_set(sch, heap, i, last);
+		if (i && edf_task_before(heap, last,
+					 sch->heap[heap][(i - 1) / 2]))
+			edf_heap_sift_up(sch, heap, i);
+		else
+			edf_heap_sift_down(sch, heap, i);
+	}
+}
+
+/*
+ * Handle queued tasks that missed their deadline. Only the tasks at the head
+ * of the deadline heap are visited, so the pass is bounded by the number of
+ * missed tasks. The first one is rescheduled, any further ones are cancelled.
+ */
+static void edf_handle_missed(struct edf_schedule_data *sch, uint64_t current)
+{
+	struct edf_task_pdata *edf_pdata;
+	struct task *edf_task;
+	int reschedule = 0;
+
+	while (sch->heap_size) {
+		edf_task = sch->heap[EDF_HEAP_DEADLINE][0];
 		edf_pdata = edf_sch_get_pdata(edf_task);
 
-		deadline = edf_pdata->deadline;
-
-		if (current < deadline) {
-			delta = deadline - current;
-
-			/* get highest priority */
-			if (edf_task->priority < next_priority) {
-				next_priority = edf_task->priority;
-				next_delta = delta;
-				edf_task_next = edf_task;
-			} else if (edf_task->priority == next_priority) {
-				/* get earliest deadline */
-				if (delta < next_delta) {
-					next_delta = delta;
-					edf_task_next = edf_task;
-				}
-			}
+		if (current < edf_pdata->deadline)
+			break;
+
+		/* missed scheduling - will be rescheduled */
+		trace_edf_sch("edf_handle_missed(), "
+			      "missed scheduling - will be rescheduled");
+
+		edf_heap_remove(sch, edf_task);
+
+		/* have we already tried to reschedule ? */
+		if (!reschedule) {
+			reschedule++;
+			trace_edf_sch("edf_handle_missed(), "
+				      "didn't try to reschedule yet");
+			edf_reschedule(edf_task, current);
+
+			/* can't fail, task has just been removed */
+			edf_heap_insert(sch, edf_task);
 		} else {
-			/* missed scheduling - will be rescheduled */
-			trace_edf_sch("edf_get_next(), "
-				   "missed scheduling - will be rescheduled");
-
-			/* have we already tried to reschedule ? */
-			if (!reschedule) {
-				reschedule++;
-				trace_edf_sch("edf_get_next(), "
-					       "didn't try to reschedule yet");
-				edf_reschedule(edf_task, current);
-			} else {
-				/* reschedule failed */
-				list_item_del(&edf_task->list);
-				edf_task->state = SOF_TASK_STATE_CANCEL;
-				trace_edf_sch_error("edf_get_next(), "
-						     "task cancelled");
-			}
+			/* reschedule failed */
+			edf_task->state = SOF_TASK_STATE_CANCEL;
+			trace_edf_sch_error("edf_handle_missed(), "
+					    "task cancelled");
 		}
 	}
+}
+
+/*
+ * Find the queued task with the highest priority and earliest deadline.
+ * TODO: Reduce cache invalidations by checking if the currently
+ * running task AND the earliest queued task will both complete before their
+ * deadlines. If so, then schedule the earlier queued task after the currently
+ * running task has completed.
+ */
+static inline struct task *edf_get_next(uint64_t current)
+{
+	struct edf_schedule_data *sch =
+		(*arch_schedule_get_data())->edf_sch_data;
+
+	edf_handle_missed(sch, current);
 
-	return edf_task_next;
+	/* any tasks in the scheduler ? */
+	if (!sch->heap_size)
+		return NULL;
+
+	return sch->heap[EDF_HEAP_READY][0];
 }
 
 /*
@@ -192,6 +313,7 @@ static struct task *sch_edf(void)
 	uint64_t current;
 	uint32_t flags;
 
+	struct edf_task_pdata *edf_pdata;
 	struct task *task;
 	struct task *future_task = NULL;
 
@@ -199,14 +321,14 @@ static struct task *sch_edf(void)
 
 	interrupt_clear(PLATFORM_SCHEDULE_IRQ);
 
-	while (!list_is_empty(&sch->list)) {
+	while (sch->heap_size) {
 		spin_lock_irq(&sch->lock, flags);
 
 		/* get the current time */
 		current = platform_timer_get(platform_timer);
 
 		/* get next task to be scheduled */
-		task = edf_get_next(current, NULL);
+		task = edf_get_next(current);
 		spin_unlock_irq(&sch->lock, flags);
 
 		/* any tasks ? */
@@ -216,12 +338,14 @@ static struct task *sch_edf(void)
 		/* can task be started now ? */
 		if (task->start <= current) {
 			/* yes, run current task */
+			edf_pdata = edf_sch_get_pdata(task);
+			edf_pdata->sched_start = task->start;
 			task->start = current;
 
 			/* init task for running */
 			spin_lock_irq(&sch->lock, flags);
 			task->state = SOF_TASK_STATE_PENDING;
-			list_item_del(&task->list);
+			edf_heap_remove(sch, task);
 			spin_unlock_irq(&sch->lock, flags);
 
 			/* now run task at correct run level */
@@ -245,6 +369,7 @@ static int schedule_edf_task_cancel(struct task *task)
 {
 	struct edf_schedule_data *sch =
 		(*arch_schedule_get_data())->edf_sch_data;
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
 	uint32_t flags;
 	int ret = 0;
 
@@ -256,9 +381,12 @@ static int schedule_edf_task_cancel(struct task *task)
 	 * if it is already running, nothing we can do about it atm
 	 */
 	if (task->state == SOF_TASK_STATE_QUEUED) {
-		/* delete task */
+		/* delete task from ready queue or idle list */
 		task->state = SOF_TASK_STATE_CANCEL;
-		list_item_del(&task->list);
+		if (edf_pdata->heap_index[EDF_HEAP_READY] != EDF_HEAP_NONE)
+			edf_heap_remove(sch, task);
+		else
+			list_item_del(&task->list);
 	}
 
 	spin_unlock_irq(&sch->lock, flags);
@@ -312,12 +440,15 @@ static void schedule_edf_task(struct task *task, uint64_t start,
 	/* calculate deadline - TODO: include MIPS */
 	edf_pdata->deadline = task->start + ticks_per_ms * deadline / 1000;
 
-	/* add task to the proper list */
+	/* add task to the ready queue or idle list */
 	if (flags & SOF_SCHEDULE_FLAG_IDLE) {
 		list_item_append(&task->list, &sch->idle_list);
 		need_sched = false;
 	} else {
-		list_item_append(&task->list, &sch->list);
+		if (edf_heap_insert(sch, task) < 0) {
+			spin_unlock_irq(&sch->lock, lock_flags);
+			return;
+		}
 		need_sched = true;
 	}
 
@@ -335,6 +466,7 @@ static void schedule_edf_task_complete(struct task *task)
 {
 	struct edf_schedule_data *sch =
 		(*arch_schedule_get_data())->edf_sch_data;
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
 	uint32_t flags;
 
 	tracev_edf_sch("schedule_edf_task_complete()");
@@ -349,6 +481,9 @@ static void schedule_edf_task_complete(struct task *task)
 	switch (task->state) {
 	case SOF_TASK_STATE_RUNNING:
 		task->state = SOF_TASK_STATE_COMPLETED;
+		schedule_timeline_record(task, edf_pdata->sched_start,
+					 edf_pdata->run_start,
+					 schedule_timeline_time());
 		break;
 	case SOF_TASK_STATE_QUEUED:
 	case SOF_TASK_STATE_PENDING:
@@ -369,12 +504,14 @@ static void schedule_edf_task_running(struct task *task)
 {
 	struct edf_schedule_data *sch =
 		(*arch_schedule_get_data())->edf_sch_data;
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
 	uint32_t flags;
 
 	tracev_edf_sch("schedule_edf_task_running()");
 
 	spin_lock_irq(&sch->lock, flags);
 	task->state = SOF_TASK_STATE_RUNNING;
+	edf_pdata->run_start = schedule_timeline_time();
 	spin_unlock_irq(&sch->lock, flags);
 }
 
@@ -390,7 +527,7 @@ static void schedule_edf(void)
 {
 	struct edf_schedule_data *sch =
 		(*arch_schedule_get_data())->edf_sch_data;
-	struct list_item *tlist;
+	struct edf_task_pdata *edf_pdata;
 	struct task *edf_task;
 	uint32_t flags;
 	uint64_t current;
@@ -400,16 +537,18 @@ static void schedule_edf(void)
 	spin_lock_irq(&sch->lock, flags);
 
 	/* make sure we have a queued task in the list first before we
-	   start scheduling as contexts switches are not free. */
-	list_for_item(tlist, &sch->list) {
-		edf_task = container_of(tlist, struct task, list);
+	 * start scheduling as contexts switches are not free.
+	 */
+	if (sch->heap_size) {
+		edf_task = sch->heap[EDF_HEAP_READY][0];
+		edf_pdata = edf_sch_get_pdata(sch->heap[EDF_HEAP_DEADLINE][0]);
 
-		/* schedule if we find any queued tasks
-		 * which reached its deadline
+		/* schedule if the next task can start or any task has
+		 * missed its deadline and needs rescheduling
 		 */
 		current = platform_timer_get(platform_timer);
-		if (edf_task->state == SOF_TASK_STATE_QUEUED &&
-		    edf_task->start <= current) {
+		if (edf_task->start <= current ||
+		    edf_pdata->deadline <= current) {
 			spin_unlock_irq(&sch->lock, flags);
 			goto schedule;
 		}
@@ -447,7 +586,6 @@ static int edf_scheduler_init(void)
 
 	sch = sch_data->edf_sch_data;
 
-	list_init(&sch->list);
 	list_init(&sch->idle_list);
 	spinlock_init(&sch->lock);
 	sch->clock = PLATFORM_SCHED_CLOCK;
@@ -479,7 +617,12 @@ static void edf_scheduler_free(void)
 	/* free arch tasks */
 	arch_free_tasks();
 
-	list_item_del(&sch->list);
+	rfree(sch->heap[EDF_HEAP_READY]);
+	rfree(sch->heap[EDF_HEAP_DEADLINE]);
+	sch->heap[EDF_HEAP_READY] = NULL;
+	sch->heap[EDF_HEAP_DEADLINE] = NULL;
+	sch->heap_size = 0;
+	sch->heap_max = 0;
 	list_item_del(&sch->idle_list);
 
 	spin_unlock_irq(&sch->lock, flags);
@@ -504,6 +647,9 @@ static int schedule_edf_task_init(struct task *task, uint32_t xflags)
 
 	edf_sch_set_pdata(task, edf_pdata);
 
+	edf_pdata->heap_index[EDF_HEAP_READY] = EDF_HEAP_NONE;
+	edf_pdata->heap_index[EDF_HEAP_DEADLINE] = EDF_HEAP_NONE;
+
 	return 0;
 }
 
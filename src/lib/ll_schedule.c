@@ -44,6 +44,7 @@
 #include <platform/clk.h>
 #include <platform/platform.h>
 #include <limits.h>
+#include <stdbool.h>
 
 /*
  * Generic delayed work queue support.
@@ -62,10 +63,20 @@
  * frequency changes.
  */
 
+/* initial capacity of ll task heap */
+#define LL_HEAP_INIT_SIZE	8
+
+/*
+ * Queued tasks are kept in a binary min-heap ordered by start time, so a
+ * queue run only visits the tasks that are due. Due tasks are moved to the
+ * run list in priority order before they are run.
+ */
 struct ll_schedule_data {
-	struct list_item tasks;			/* list of ll tasks */
+	struct task **heap;			/* queued ll tasks */
+	uint32_t heap_size;			/* number of queued ll tasks */
+	uint32_t heap_max;			/* capacity of heap */
+	struct list_item run;			/* list of due ll tasks */
 	uint64_t timeout;			/* timeout for next queue run */
-	uint32_t window_size;			/* window size for pending ll */
 	spinlock_t lock;
 	struct notifier notifier;		/* notify CPU freq changes */
 	struct timesource_data *ts;		/* time source for work queue */
@@ -133,46 +144,146 @@ static inline void ll_clear_timer(struct ll_schedule_data *queue)
 	}
 }
 
-/* is there any work pending in the current time window ? */
-static int is_ll_pending(struct ll_schedule_data *queue)
+static inline void insert_task_to_queue(struct task *w,
+					struct list_item *q_list)
 {
-	struct list_item *wlist;
 	struct task *ll_task;
-	uint64_t win_end;
-	uint64_t win_start;
-	int pending_count = 0;
-
-	/* get the current valid window of work */
-	win_end = ll_get_timer(queue);
-	win_start = win_end - queue->window_size;
+	struct list_item *wlist;
 
-	/* mark each valid work item in this time period as pending */
-	list_for_item(wlist, &queue->tasks) {
+	/* works are adding to queue in order */
+	list_for_item(wlist, q_list) {
 		ll_task = container_of(wlist, struct task, list);
+		if (w->priority <= ll_task->priority) {
+			list_item_append(&w->list, &ll_task->list);
+			return;
+		}
+	}
+
+	/* if task has not been added, means that it has the lowest
+	 * priority in queue and it should be added at the end of the list
+	 */
+	list_item_append(&w->list, q_list);
+}
+
+static inline void ll_heap_set(struct ll_schedule_data *queue, uint32_t i,
+			       struct task *ll_task)
+{
+	struct ll_task_pdata *ll_pdata = ll_sch_get_pdata(ll_task);
+
+	queue->heap[i] = ll_task;
+	ll_pdata->heap_index = i;
+}
+
+static void ll_heap_sift_up(struct ll_schedule_data *queue, uint32_t i)
+{
+	struct task *ll_task = queue->heap[i];
+	uint32_t parent;
+
+	while (i) {
+		parent = (i - 1) / 2;
+		if (queue->heap[parent]->start <= ll_task->start)
+			break;
 
-		/* correct the pending flag window for overflow */
-		if (win_end > win_start) {
-			/* mark pending work */
-			if (ll_task->start >= win_start &&
-				ll_task->start <= win_end) {
-				ll_task->state =
-					SOF_TASK_STATE_PENDING;
-				pending_count++;
-			} else {
-				ll_task->state = 0;
-			}
-		} else {
-			/* mark pending work */
-			if ((ll_task->start <= win_end ||
-				(ll_task->start >= win_start &&
-				ll_task->start < ULONG_LONG_MAX))) {
-				ll_task->state =
-					SOF_TASK_STATE_PENDING;
-				pending_count++;
-			} else {
-				ll_task->state = 0;
-			}
+		ll_heap_set(queue, i, queue->heap[parent]);
+		i = parent;
+	}
+
+	ll_heap_set(queue, i, ll_task);
+}
+
+static void ll_heap_sift_down(struct ll_schedule_data *queue, uint32_t i)
+{
+	struct task *ll_task = queue->heap[i];
+	uint32_t child;
+
+	while ((child = 2 * i + 1) < queue->heap_size) {
+		/* pick the earlier child */
+		if (child + 1 < queue->heap_size &&
+		    queue->heap[child + 1]->start < queue->heap[child]->start)
+			child++;
+
+		if (ll_task->start <= queue->heap[child]->start)
+			break;
+
+		ll_heap_set(queue, i, queue->heap[child]);
+		i = child;
+	}
+
+	ll_heap_set(queue, i, ll_task);
+}
+
+/* add task to heap, growing it when full */
+static int ll_heap_insert(struct ll_schedule_data *queue,
+			  struct task *ll_task)
+{
+	struct task **heap;
+	uint32_t heap_max;
+
+	if (queue->heap_size == queue->heap_max) {
+		heap_max = queue->heap_max ? 2 * queue->heap_max :
+			LL_HEAP_INIT_SIZE;
+		heap = rrealloc(queue->heap, RZONE_RUNTIME, SOF_MEM_CAPS_RAM,
+				heap_max * sizeof(*heap));
+		if (!heap) {
+			trace_ll_error("ll_heap_insert() error: no memory for "
+				       "%d tasks", heap_max);
+			return -ENOMEM;
 		}
+
+		queue->heap = heap;
+		queue->heap_max = heap_max;
+	}
+
+	queue->heap[queue->heap_size++] = ll_task;
+	ll_heap_sift_up(queue, queue->heap_size - 1);
+	ll_task->state = SOF_TASK_STATE_QUEUED;
+
+	return 0;
+}
+
+static void ll_heap_remove(struct ll_schedule_data *queue,
+			   struct task *ll_task)
+{
+	struct ll_task_pdata *ll_pdata = ll_sch_get_pdata(ll_task);
+	uint32_t i = ll_pdata->heap_index;
+	struct task *last;
+
+	ll_pdata->heap_index = LL_HEAP_NONE;
+
+	/* fill the hole with the last task and restore heap order */
+	last = queue->heap[--queue->heap_size];
+	if (i == queue->heap_size)
+		return;
+
+	ll_heap_set(queue, i, last);
+	if (i && queue->heap[(i - 1) / 2]->start > last->start)
+		ll_heap_sift_up(queue, i);
+	else
+		ll_heap_sift_down(queue, i);
+}
+
+/* task is in heap or on run list */
+static inline bool ll_task_is_queued(struct task *w)
+{
+	struct ll_task_pdata *ll_pdata = ll_sch_get_pdata(w);
+
+	return ll_pdata->heap_index != LL_HEAP_NONE ||
+		!list_is_empty(&w->list);
+}
+
+/* move due tasks from heap to run list, returns number of due tasks */
+static int ll_collect_pending(struct ll_schedule_data *queue)
+{
+	uint64_t current = ll_get_timer(queue);
+	struct task *ll_task;
+	int pending_count = 0;
+
+	while (queue->heap_size && queue->heap[0]->start <= current) {
+		ll_task = queue->heap[0];
+		ll_heap_remove(queue, ll_task);
+		ll_task->state = SOF_TASK_STATE_PENDING;
+		insert_task_to_queue(ll_task, &queue->run);
+		pending_count++;
 	}
 
 	return pending_count;
@@ -201,37 +312,50 @@ static inline void ll_next_timeout(struct ll_schedule_data *queue,
 /* run all pending work */
 static void run_ll(struct ll_schedule_data *queue, uint32_t *flags)
 {
-	struct list_item *wlist;
-	struct list_item *tlist;
 	struct task *ll_task;
 	uint64_t reschedule_usecs;
+	uint64_t sched_start;
+	uint64_t start;
+	uint64_t end;
 	int cpu = cpu_get_id();
 
-	/* check each work item in queue for pending */
-	list_for_item_safe(wlist, tlist, &queue->tasks) {
-		ll_task = container_of(wlist, struct task, list);
-
-		/* run work if its pending and remove from the queue */
-		if (ll_task->state == SOF_TASK_STATE_PENDING) {
-			/* work can run in non atomic context */
-			spin_unlock_irq(&queue->lock, *flags);
-			reschedule_usecs = ll_task->func(ll_task->data);
-			spin_lock_irq(&queue->lock, *flags);
-
-			/* do we need reschedule this work ? */
-			if (reschedule_usecs == 0) {
-				list_item_del(&ll_task->list);
-				atomic_sub(&ll_shared_ctx->total_num_work, 1);
-
-				/* don't enable irq, if no more work to do */
-				if (!atomic_sub(&queue->num_ll, 1))
-					ll_shared_ctx->timers[cpu] = NULL;
-			} else {
-				/* get next work timeout */
-				ll_next_timeout(queue, ll_task,
-						reschedule_usecs);
-			}
+	/* due tasks stay on run list until they have run */
+	while (!list_is_empty(&queue->run)) {
+		ll_task = list_first_item(&queue->run, struct task, list);
+		ll_task->state = SOF_TASK_STATE_RUNNING;
+		sched_start = ll_task->start;
+
+		/* work can run in non atomic context */
+		spin_unlock_irq(&queue->lock, *flags);
+		schedule_load_enter();
+		start = schedule_timeline_time();
+		reschedule_usecs = ll_task->func(ll_task->data);
+		end = schedule_timeline_time();
+		schedule_load_exit();
+		spin_lock_irq(&queue->lock, *flags);
+
+		schedule_timeline_record(ll_task, sched_start, start, end);
+
+		/* work cancelled while running */
+		if (list_is_empty(&ll_task->list))
+			continue;
+
+		list_item_del(&ll_task->list);
+
+		/* do we need reschedule this work ? */
+		if (reschedule_usecs) {
+			/* get next work timeout */
+			ll_next_timeout(queue, ll_task, reschedule_usecs);
+			if (!ll_heap_insert(queue, ll_task))
+				continue;
 		}
+
+		ll_task->state = SOF_TASK_STATE_COMPLETED;
+		atomic_sub(&ll_shared_ctx->total_num_work, 1);
+
+		/* don't enable irq, if no more work to do */
+		if (!atomic_sub(&queue->num_ll, 1))
+			ll_shared_ctx->timers[cpu] = NULL;
 	}
 }
 
@@ -253,18 +377,18 @@ static inline uint64_t calc_delta_ticks(uint64_t current, uint64_t work)
 static void queue_recalc_timers(struct ll_schedule_data *queue,
 				struct clock_notify_data *clk_data)
 {
-	struct list_item *wlist;
 	struct task *ll_task;
 	uint64_t delta_ticks;
 	uint64_t delta_msecs;
 	uint64_t current;
+	uint32_t i;
 
 	/* get current time */
 	current = ll_get_timer(queue);
 
 	/* recalculate timers for each work item */
-	list_for_item(wlist, &queue->tasks) {
-		ll_task = container_of(wlist, struct task, list);
+	for (i = 0; i < queue->heap_size; i++) {
+		ll_task = queue->heap[i];
 		delta_ticks = calc_delta_ticks(current, ll_task->start);
 		delta_msecs = delta_ticks /
 			clk_data->old_ticks_per_msec;
@@ -277,6 +401,10 @@ static void queue_recalc_timers(struct ll_schedule_data *queue,
 			ll_task->start = current +
 				(queue->ticks_per_msec >> 3);
 	}
+
+	/* rounding may have changed the order of tasks */
+	for (i = queue->heap_size / 2; i > 0; i--)
+		ll_heap_sift_down(queue, i - 1);
 }
 
 /* enable all registered timers */
@@ -327,9 +455,8 @@ static void queue_run(void *data)
 	spin_lock_irq(&queue->lock, flags);
 
 	/* run work if there is any pending */
-	if (is_ll_pending(queue)) {
+	if (ll_collect_pending(queue))
 		run_ll(queue, &flags);
-	}
 
 	/* re-calc timer and re-arm */
 	queue_reschedule(queue);
@@ -350,10 +477,7 @@ static void ll_notify(int message, void *data, void *event_data)
 	/* we need to re-calculate timer when CPU frequency changes */
 	if (message == CLOCK_NOTIFY_POST) {
 		/* CPU frequency update complete */
-		/* scale the window size to clock speed */
 		queue->ticks_per_msec = clock_ms_to_ticks(queue->ts->clk, 1);
-		queue->window_size =
-			queue->ticks_per_msec * PLATFORM_WORKQ_WINDOW / 1000;
 		queue_recalc_timers(queue, clk_data);
 	} else if (message == CLOCK_NOTIFY_PRE) {
 		/* CPU frequency update pending */
@@ -362,46 +486,17 @@ static void ll_notify(int message, void *data, void *event_data)
 	spin_unlock_irq(&queue->lock, flags);
 }
 
-static inline void insert_task_to_queue(struct task *w,
-					struct list_item *q_list)
-{
-	struct task *ll_task;
-	struct list_item *wlist;
-
-	/* works are adding to queue in order */
-	list_for_item(wlist, q_list) {
-		ll_task = container_of(wlist, struct task, list);
-		if (w->priority <= ll_task->priority) {
-			list_item_append(&w->list, &ll_task->list);
-			return;
-		}
-	}
-
-	/* if task has not been added, means that it has the lowest
-	 * priority in queue and it should be added at the end of the list
-	 */
-	list_item_append(&w->list, q_list);
-	return;
-}
-
 static void ll_schedule(struct ll_schedule_data *queue, struct task *w,
 			uint64_t start)
 {
 	struct ll_task_pdata *ll_pdata;
-	struct task *ll_task;
-	struct list_item *wlist;
 	uint32_t flags;
 
 	spin_lock_irq(&queue->lock, flags);
 
-	/* check to see if we are already scheduled ? */
-	list_for_item(wlist, &queue->tasks) {
-		ll_task = container_of(wlist, struct task, list);
-
-		/* keep original start */
-		if (ll_task == w)
-			goto out;
-	}
+	/* keep original start if we are already scheduled */
+	if (ll_task_is_queued(w))
+		goto out;
 
 	w->start = queue->ticks_per_msec * start / 1000;
 	ll_pdata = ll_sch_get_pdata(w);
@@ -412,8 +507,9 @@ static void ll_schedule(struct ll_schedule_data *queue, struct task *w,
 	else
 		w->start += ll_shared_ctx->last_tick;
 
-	/* insert work into list */
-	insert_task_to_queue(w, &queue->tasks);
+	/* insert work into heap */
+	if (ll_heap_insert(queue, w) < 0)
+		goto out;
 
 	ll_set_timer(queue);
 
@@ -432,29 +528,29 @@ static void schedule_ll_task(struct task *w, uint64_t start, uint64_t deadline,
 static void reschedule(struct ll_schedule_data *queue, struct task *w,
 		       uint64_t time)
 {
-	struct task *ll_task;
-	struct list_item *wlist;
+	struct ll_task_pdata *ll_pdata = ll_sch_get_pdata(w);
 	uint32_t flags;
 
 	spin_lock_irq(&queue->lock, flags);
 
-	/* check to see if we are already scheduled */
-	list_for_item(wlist, &queue->tasks) {
-		ll_task = container_of(wlist, struct task, list);
-
-		/* found it */
-		if (ll_task == w)
-			goto found;
+	/* already scheduled, just move it to the new start */
+	if (ll_task_is_queued(w)) {
+		w->start = time;
+		if (ll_pdata->heap_index != LL_HEAP_NONE) {
+			ll_heap_remove(queue, w);
+			ll_heap_insert(queue, w);
+		}
+		goto out;
 	}
 
-	insert_task_to_queue(w, &queue->tasks);
-
-	ll_set_timer(queue);
-
-found:
 	/* re-calc timer and re-arm */
 	w->start = time;
+	if (ll_heap_insert(queue, w) < 0)
+		goto out;
+
+	ll_set_timer(queue);
 
+out:
 	spin_unlock_irq(&queue->lock, flags);
 }
 
@@ -482,25 +578,20 @@ static int schedule_ll_task_cancel(struct task *w)
 {
 	struct ll_schedule_data *queue =
 		(*arch_schedule_get_data())->ll_sch_data;
-	struct task *ll_task;
-	struct list_item *wlist;
+	struct ll_task_pdata *ll_pdata = ll_sch_get_pdata(w);
 	uint32_t flags;
 	int ret = 0;
 
 	spin_lock_irq(&queue->lock, flags);
 
 	/* check to see if we are scheduled */
-	list_for_item(wlist, &queue->tasks) {
-		ll_task = container_of(wlist, struct task, list);
+	if (ll_task_is_queued(w))
+		ll_clear_timer(queue);
 
-		/* found it */
-		if (ll_task == w) {
-			ll_clear_timer(queue);
-			break;
-		}
-	}
+	/* remove work from heap or run list */
+	if (ll_pdata->heap_index != LL_HEAP_NONE)
+		ll_heap_remove(queue, w);
 
-	/* remove work from list */
 	w->state = SOF_TASK_STATE_CANCEL;
 	list_item_del(&w->list);
 
@@ -533,14 +624,16 @@ static struct ll_schedule_data *work_new_queue(struct timesource_data *ts)
 
 	/* init work queue */
 	queue = rmalloc(RZONE_SYS, SOF_MEM_CAPS_RAM, sizeof(*queue));
-	list_init(&queue->tasks);
+	queue->heap = rzalloc(RZONE_RUNTIME, SOF_MEM_CAPS_RAM,
+			      LL_HEAP_INIT_SIZE * sizeof(*queue->heap));
+	queue->heap_size = 0;
+	queue->heap_max = queue->heap ? LL_HEAP_INIT_SIZE : 0;
+	list_init(&queue->run);
 
 	spinlock_init(&queue->lock);
 	atomic_init(&queue->num_ll, 0);
 	queue->ts = ts;
 	queue->ticks_per_msec = clock_ms_to_ticks(queue->ts->clk, 1);
-	queue->window_size = queue->ticks_per_msec *
-		PLATFORM_WORKQ_WINDOW / 1000;
 
 	/* TODO: configurable through IPC */
 	queue->timeout = PLATFORM_WORKQ_DEFAULT_TIMEOUT;
@@ -599,6 +692,8 @@ static int schedule_ll_task_init(struct task *w, uint32_t xflags)
 	ll_sch_set_pdata(w, ll_pdata);
 
 	ll_pdata->flags = xflags;
+	ll_pdata->heap_index = LL_HEAP_NONE;
+	list_init(&w->list);
 
 	return 0;
 }
@@ -615,7 +710,11 @@ static void ll_scheduler_free(void)
 
 	notifier_unregister(&queue->notifier);
 
-	list_item_del(&queue->tasks);
+	rfree(queue->heap);
+	queue->heap = NULL;
+	queue->heap_size = 0;
+	queue->heap_max = 0;
+	list_item_del(&queue->run);
 
 	spin_unlock_irq(&queue->lock, flags);
 }
@@ -32,6 +32,7 @@
 #include <sof/schedule.h>
 #include <sof/edf_schedule.h>
 #include <sof/ll_schedule.h>
+#include <sof/interrupt.h>
 
 static const struct scheduler_ops *schedulers[SOF_SCHEDULE_COUNT] = {
 	&schedule_edf_ops,              /* SOF_SCHEDULE_EDF */
@@ -103,6 +104,128 @@ void schedule_task_complete(struct task *task)
 		task->ops->schedule_task_complete(task);
 }
 
+#if CONFIG_TRACE_SCHEDULE
+void schedule_timeline_record(struct task *task, uint64_t sched_start,
+			      uint64_t start, uint64_t end)
+{
+	struct schedule_timeline *tl = (*arch_schedule_get_data())->timeline;
+	struct schedule_timeline_event *event;
+
+	if (!tl)
+		return;
+
+	/* keep older runs, lost ones are only counted */
+	if (tl->w_idx - tl->r_idx == SCHEDULE_TIMELINE_SIZE) {
+		tl->dropped++;
+		return;
+	}
+
+	event = &tl->events[tl->w_idx % SCHEDULE_TIMELINE_SIZE];
+	event->task = (uint32_t)(uintptr_t)task;
+	event->type = task->type;
+	event->priority = task->priority;
+	event->sched_start = sched_start;
+	event->start = start;
+	event->end = end;
+	tl->w_idx++;
+}
+
+/*
+ * Each run is sent as one trace event with type and priority as ids. Start
+ * is truncated to 32 bits, tools/logger/sof-sched-timeline.py restores it
+ * from the trace timestamp.
+ */
+void schedule_timeline_flush(void)
+{
+	struct schedule_timeline *tl = (*arch_schedule_get_data())->timeline;
+	struct schedule_timeline_event event;
+	uint32_t dropped;
+	uint32_t delay;
+	uint32_t run;
+	uint32_t flags;
+
+	if (!tl)
+		return;
+
+	while (tl->r_idx != tl->w_idx) {
+		flags = interrupt_global_disable();
+		event = tl->events[tl->r_idx % SCHEDULE_TIMELINE_SIZE];
+		tl->r_idx++;
+		interrupt_global_enable(flags);
+
+		delay = event.start - event.sched_start;
+		run = event.end - event.start;
+
+		trace_event_with_ids(TRACE_CLASS_SCHEDULE, event.type,
+				     event.priority, "timeline task 0x%x "
+				     "start %u delay %u run %u", event.task,
+				     (uint32_t)event.start, delay, run);
+	}
+
+	if (tl->dropped) {
+		flags = interrupt_global_disable();
+		dropped = tl->dropped;
+		tl->dropped = 0;
+		interrupt_global_enable(flags);
+
+		trace_event(TRACE_CLASS_SCHEDULE, "timeline dropped %u",
+			    dropped);
+	}
+}
+#endif
+
+#if CONFIG_CLK_GOVERNOR
+void schedule_load_enter(void)
+{
+	struct schedule_load *load = &(*arch_schedule_get_data())->load;
+	uint32_t flags;
+
+	flags = interrupt_global_disable();
+
+	/* preempting task runs in busy time of the preempted one */
+	if (!load->depth++)
+		load->start = platform_timer_get(platform_timer);
+
+	interrupt_global_enable(flags);
+}
+
+void schedule_load_exit(void)
+{
+	struct schedule_load *load = &(*arch_schedule_get_data())->load;
+	uint32_t flags;
+
+	flags = interrupt_global_disable();
+
+	if (!--load->depth)
+		load->busy += platform_timer_get(platform_timer) - load->start;
+
+	interrupt_global_enable(flags);
+}
+
+uint64_t schedule_load_busy(void)
+{
+	struct schedule_load *load = &(*arch_schedule_get_data())->load;
+	uint64_t current;
+	uint64_t busy;
+	uint32_t flags;
+
+	flags = interrupt_global_disable();
+
+	/* account running tasks up to now */
+	if (load->depth) {
+		current = platform_timer_get(platform_timer);
+		load->busy += current - load->start;
+		load->start = current;
+	}
+
+	busy = load->busy;
+
+	interrupt_global_enable(flags);
+
+	return busy;
+}
+#endif
+
 int scheduler_init(void)
 {
 	struct schedule_data **sch = arch_schedule_get_data();
@@ -112,6 +235,12 @@ int scheduler_init(void)
 	/* init scheduler_data */
 	*sch = rzalloc(RZONE_SYS, SOF_MEM_CAPS_RAM, sizeof(**sch));
 
+#if CONFIG_TRACE_SCHEDULE
+	/* timeline is optional, scheduling works without it */
+	(*sch)->timeline = rzalloc(RZONE_SYS, SOF_MEM_CAPS_RAM,
+				   sizeof(*(*sch)->timeline));
+#endif
+
 	for (i = 0; i < SOF_SCHEDULE_COUNT; i++) {
 		if (schedulers[i]->scheduler_init) {
 			ret = schedulers[i]->scheduler_init();
@@ -141,4 +270,7 @@ void schedule(void)
 		if (schedulers[i]->scheduler_run)
 			schedulers[i]->scheduler_run();
 	}
+
+	/* core is idle, send recorded task runs */
+	schedule_timeline_flush();
 }
@@ -38,6 +38,7 @@
 #endif
 
 #define HEAP_BUFFER_SIZE	(1024 * 128)
+#define HEAP_BUFFER_BLOCK_SIZE	0x180
 #define SOF_STACK_SIZE		0x1000
 
 #define MAILBOX_DSPBOX_BASE	0
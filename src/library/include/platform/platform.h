@@ -45,6 +45,7 @@
  *  The choice depends on HW features on different platform
  */
 #define PLATFORM_DEFAULT_CLOCK CLK_CPU(0)
+#define PLATFORM_WORKQ_CLOCK	PLATFORM_DEFAULT_CLOCK
 
 /*! \def PLATFORM_WORKQ_DEFAULT_TIMEOUT
  *  \brief work queue default timeout in microseconds
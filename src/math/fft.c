@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <sof/audio/format.h>
+#include <sof/math/fft.h>
+
+/* A quarter period of sine wave as Q1.31, sin(2 * pi * n / FFT_SIZE_MAX) */
+static const int32_t fft_sine_table[FFT_SIZE_MAX / 4 + 1] = {
+	0, 26352928, 52701887, 79042909, 105372028, 131685278, 157978697,
+	184248325, 210490206, 236700388, 262874923, 289009871, 315101295,
+	341145265, 367137861, 393075166, 418953276, 444768294, 470516330,
+	496193509, 521795963, 547319836, 572761285, 598116479, 623381598,
+	648552838, 673626408, 698598533, 723465451, 748223418, 772868706,
+	797397602, 821806413, 846091463, 870249095, 894275671, 918167572,
+	941921200, 965532978, 988999351, 1012316784, 1035481766, 1058490808,
+	1081340445, 1104027237, 1126547765, 1148898640, 1171076495, 1193077991,
+	1214899813, 1236538675, 1257991320, 1279254516, 1300325060, 1321199781,
+	1341875533, 1362349204, 1382617710, 1402678000, 1422527051, 1442161874,
+	1461579514, 1480777044, 1499751576, 1518500250, 1537020244, 1555308768,
+	1573363068, 1591180426, 1608758157, 1626093616, 1643184191, 1660027308,
+	1676620432, 1692961062, 1709046739, 1724875040, 1740443581, 1755750017,
+	1770792044, 1785567396, 1800073849, 1814309216, 1828271356, 1841958164,
+	1855367581, 1868497586, 1881346202, 1893911494, 1906191570, 1918184581,
+	1929888720, 1941302225, 1952423377, 1963250501, 1973781967, 1984016189,
+	1993951625, 2003586779, 2012920201, 2021950484, 2030676269, 2039096241,
+	2047209133, 2055013723, 2062508835, 2069693342, 2076566160, 2083126254,
+	2089372638, 2095304370, 2100920556, 2106220352, 2111202959, 2115867626,
+	2120213651, 2124240380, 2127947206, 2131333572, 2134398966, 2137142927,
+	2139565043, 2141664948, 2143442326, 2144896910, 2146028480, 2146836866,
+	2147321946, 2147483647,
+};
+
+/* Twiddle factor exp(-j * 2 * pi * n / FFT_SIZE_MAX) for n in range
+ * 0 to FFT_SIZE_MAX / 2 - 1, found with sine wave symmetry.
+ */
+static inline void fft_twiddle(struct icomplex32 *w, int n)
+{
+	if (n <= FFT_SIZE_MAX / 4) {
+		w->real = fft_sine_table[FFT_SIZE_MAX / 4 - n];
+		w->imag = -fft_sine_table[n];
+	} else {
+		w->real = -fft_sine_table[n - FFT_SIZE_MAX / 4];
+		w->imag = -fft_sine_table[FFT_SIZE_MAX / 2 - n];
+	}
+}
+
+static void fft_bit_reverse(struct icomplex32 *buf, int size)
+{
+	struct icomplex32 tmp;
+	int bit;
+	int i;
+	int j = 0;
+
+	for (i = 1; i < size; i++) {
+		bit = size >> 1;
+		while (j & bit) {
+			j ^= bit;
+			bit >>= 1;
+		}
+		j ^= bit;
+
+		if (i < j) {
+			tmp = buf[i];
+			buf[i] = buf[j];
+			buf[j] = tmp;
+		}
+	}
+}
+
+void fft_32(struct icomplex32 *buf, int size, int inverse)
+{
+	struct icomplex32 w;
+	struct icomplex32 *a;
+	struct icomplex32 *b;
+	int64_t tr;
+	int64_t ti;
+	int step;
+	int half;
+	int len;
+	int i;
+	int j;
+
+	fft_bit_reverse(buf, size);
+
+	for (len = 2; len <= size; len <<= 1) {
+		half = len >> 1;
+		step = FFT_SIZE_MAX / len;
+		for (j = 0; j < half; j++) {
+			fft_twiddle(&w, j * step);
+			if (inverse)
+				w.imag = -w.imag;
+
+			for (i = j; i < size; i += len) {
+				a = &buf[i];
+				b = &buf[i + half];
+
+				/* Q1.31 x Q1.31 -> Q2.62, round to Q1.31 */
+				tr = (int64_t)w.real * b->real -
+					(int64_t)w.imag * b->imag;
+				ti = (int64_t)w.real * b->imag +
+					(int64_t)w.imag * b->real;
+				tr = Q_SHIFT_RND(tr, 62, 31);
+				ti = Q_SHIFT_RND(ti, 62, 31);
+
+				/* Butterfly with scaling by one half */
+				b->real = (a->real - tr + 1) >> 1;
+				b->imag = (a->imag - ti + 1) >> 1;
+				a->real = (a->real + tr + 1) >> 1;
+				a->imag = (a->imag + ti + 1) >> 1;
+			}
+		}
+	}
+}
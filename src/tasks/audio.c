@@ -37,6 +37,7 @@
 #include <sof/interrupt.h>
 #include <sof/ipc.h>
 #include <sof/agent.h>
+#include <sof/clk.h>
 #include <platform/idc.h>
 #include <platform/interrupt.h>
 #include <platform/shim.h>
@@ -64,6 +65,9 @@ int do_task_master_core(struct sof *sof)
 	/* init default audio components */
 	sys_comp_init();
 
+	/* init buffer reuse pool */
+	sys_buffer_init();
+
 	/* init self-registered modules */
 	sys_module_init();
 
@@ -78,6 +82,11 @@ int do_task_master_core(struct sof *sof)
 	if (ret < 0)
 		return ret;
 
+	/* scale core clock with load of its pipelines */
+	ret = clock_governor_init();
+	if (ret < 0)
+		return ret;
+
 	/* main audio IPC processing loop */
 	while (1) {
 		/* sleep until next IPC or DMA */
@@ -97,6 +106,13 @@ int do_task_master_core(struct sof *sof)
 
 int do_task_slave_core(struct sof *sof)
 {
+	int ret;
+
+	/* scale core clock with load of its pipelines */
+	ret = clock_governor_init();
+	if (ret < 0)
+		return ret;
+
 	/* main audio IDC processing loop */
 	while (1) {
 		/* sleep until next IDC */
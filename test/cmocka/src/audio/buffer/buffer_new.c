@@ -58,10 +58,100 @@ static void test_audio_buffer_new(void **state)
 	buffer_free(buf);
 }
 
+static void test_audio_buffer_new_reuses_pooled_buffer(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 256
+	};
+
+	sys_buffer_init();
+
+	struct comp_buffer *buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+
+	void *addr = buf->addr;
+
+	buffer_free(buf);
+
+	/* same size class gets pooled memory back */
+	test_buf_desc.size = 200;
+	buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+	assert_ptr_equal(buf->addr, addr);
+	assert_int_equal(buf->size, 200);
+	assert_int_equal(buf->free, 200);
+	assert_null(buf->alias);
+
+	buffer_free(buf);
+
+	/* larger size class gets new memory */
+	test_buf_desc.size = HEAP_BUFFER_BLOCK_SIZE * 2;
+	buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+	assert_ptr_not_equal(buf->addr, addr);
+
+	buffer_free(buf);
+
+	assert_int_equal(buffer_pool_trim(), 2);
+	assert_int_equal(buffer_pool_trim(), 0);
+}
+
+static void test_audio_buffer_new_pool_grow_in_class(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 200
+	};
+
+	sys_buffer_init();
+
+	struct comp_buffer *buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+	assert_int_equal(buf->alloc_size, 200);
+
+	void *addr = buf->addr;
+
+	buffer_free(buf);
+
+	/* same size class but more than pooled memory gets new memory */
+	test_buf_desc.size = HEAP_BUFFER_BLOCK_SIZE - 4;
+	buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+	assert_ptr_not_equal(buf->addr, addr);
+	assert_int_equal(buf->alloc_size, HEAP_BUFFER_BLOCK_SIZE - 4);
+	assert_int_equal(buf->free, HEAP_BUFFER_BLOCK_SIZE - 4);
+
+	buffer_free(buf);
+
+	/* smaller size reuses the bigger memory and keeps its size */
+	test_buf_desc.size = 100;
+	buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+	assert_int_equal(buf->size, 100);
+	assert_int_equal(buf->alloc_size, HEAP_BUFFER_BLOCK_SIZE - 4);
+	assert_int_equal(buffer_set_size(buf, HEAP_BUFFER_BLOCK_SIZE - 4), 0);
+	assert_int_not_equal(buffer_set_size(buf, HEAP_BUFFER_BLOCK_SIZE), 0);
+
+	buffer_free(buf);
+
+	assert_int_equal(buffer_pool_trim(), 2);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
-		cmocka_unit_test(test_audio_buffer_new)
+		cmocka_unit_test(test_audio_buffer_new),
+		cmocka_unit_test(test_audio_buffer_new_reuses_pooled_buffer),
+		cmocka_unit_test(test_audio_buffer_new_pool_grow_in_class)
 	};
 
 	cmocka_set_message_output(CM_OUTPUT_TAP);
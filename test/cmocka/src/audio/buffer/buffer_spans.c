@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sof/audio/component.h>
+#include <sof/audio/buffer.h>
+#include <sof/ipc.h>
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <cmocka.h>
+
+static void test_audio_buffer_spans_no_wrap(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 16
+	};
+
+	struct comp_buffer *buf = buffer_new(&test_buf_desc);
+	struct buffer_span spans[2];
+
+	assert_non_null(buf);
+
+	buf->w_ptr = buf->addr + 4;
+
+	assert_int_equal(buffer_write_spans(buf, 12, spans), 1);
+	assert_ptr_equal(spans[0].ptr, buf->addr + 4);
+	assert_int_equal(spans[0].bytes, 12);
+	assert_int_equal(spans[1].bytes, 0);
+
+	buffer_free(buf);
+}
+
+static void test_audio_buffer_spans_wrap(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 16
+	};
+
+	struct comp_buffer *buf = buffer_new(&test_buf_desc);
+	struct buffer_span spans[2];
+
+	assert_non_null(buf);
+
+	buf->r_ptr = buf->addr + 10;
+
+	assert_int_equal(buffer_read_spans(buf, 12, spans), 2);
+	assert_ptr_equal(spans[0].ptr, buf->addr + 10);
+	assert_int_equal(spans[0].bytes, 6);
+	assert_ptr_equal(spans[1].ptr, buf->addr);
+	assert_int_equal(spans[1].bytes, 6);
+
+	buffer_free(buf);
+}
+
+static void test_audio_buffer_wrap_ptr(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 16
+	};
+
+	struct comp_buffer *buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+
+	assert_int_equal(buffer_bytes_without_wrap(buf, buf->addr + 6), 10);
+	assert_int_equal(buffer_samples_without_wrap_s16(buf, buf->addr + 6),
+			 5);
+	assert_ptr_equal(buffer_wrap(buf, buf->addr + 15), buf->addr + 15);
+	assert_ptr_equal(buffer_wrap(buf, buf->addr + 16), buf->addr);
+	assert_ptr_equal(buffer_wrap(buf, buf->addr + 20), buf->addr + 4);
+
+	buffer_free(buf);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_audio_buffer_spans_no_wrap),
+		cmocka_unit_test(test_audio_buffer_spans_wrap),
+		cmocka_unit_test(test_audio_buffer_wrap_ptr),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
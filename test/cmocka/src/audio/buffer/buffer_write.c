@@ -30,6 +30,7 @@
 
 #include <sof/audio/component.h>
 #include <sof/audio/buffer.h>
+#include <sof/audio/pipeline.h>
 #include <sof/ipc.h>
 
 #include <stdio.h>
@@ -103,12 +104,197 @@ static void test_audio_buffer_fill_10_bytes(void **state)
 	buffer_free(buf);
 }
 
+static void test_audio_buffer_spsc_write_wrap_and_fill(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 10
+	};
+
+	struct comp_buffer *buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+
+	buffer_set_spsc(buf, true);
+
+	comp_update_buffer_produce(buf, 6);
+
+	assert_int_equal(buf->avail, 6);
+	assert_int_equal(buf->free, 4);
+
+	comp_update_buffer_consume(buf, 6);
+
+	assert_int_equal(buf->avail, 0);
+	assert_int_equal(buf->free, 10);
+	assert_ptr_equal(buf->w_ptr, buf->r_ptr);
+
+	/* wrap write pointer and fill the whole buffer */
+	comp_update_buffer_produce(buf, 10);
+
+	assert_int_equal(buf->avail, 10);
+	assert_int_equal(buf->free, 0);
+	assert_ptr_equal(buf->w_ptr, buf->addr + 6);
+	assert_ptr_equal(buf->w_ptr, buf->r_ptr);
+
+	comp_update_buffer_consume(buf, 8);
+
+	assert_int_equal(buf->avail, 2);
+	assert_int_equal(buf->free, 8);
+	assert_ptr_equal(buf->r_ptr, buf->addr + 4);
+
+	buffer_free(buf);
+}
+
+static void test_audio_buffer_alias_shares_free_space(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 10
+	};
+
+	struct comp_buffer *src = buffer_new(&test_buf_desc);
+	struct comp_buffer *sink = buffer_new(&test_buf_desc);
+
+	assert_non_null(src);
+	assert_non_null(sink);
+
+	buffer_set_spsc(src, true);
+	buffer_set_spsc(sink, true);
+
+	assert_int_equal(buffer_alias(sink, src), 0);
+	assert_ptr_equal(sink->addr, src->addr);
+	assert_true(src->no_bypass);
+	assert_true(sink->no_bypass);
+
+	comp_update_buffer_produce(src, 6);
+
+	assert_int_equal(src->avail, 6);
+	assert_int_equal(src->free, 4);
+
+	/* process 4 bytes in place */
+	comp_update_buffer_consume(src, 4);
+	comp_update_buffer_produce(sink, 4);
+
+	assert_int_equal(src->avail, 2);
+	assert_int_equal(src->free, 4);
+	assert_int_equal(sink->avail, 4);
+	assert_ptr_equal(sink->w_ptr, src->r_ptr);
+
+	comp_update_buffer_consume(sink, 4);
+
+	assert_int_equal(sink->avail, 0);
+	assert_int_equal(src->free, 8);
+
+	buffer_free(sink);
+
+	assert_false(src->no_bypass);
+
+	buffer_free(src);
+}
+
+static void test_audio_buffer_alias_locked_source(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 10
+	};
+
+	struct comp_dev host = { .is_dma_connected = 1 };
+	struct comp_dev eq = { 0 };
+	struct comp_dev volume = { 0 };
+	struct comp_buffer *src = buffer_new(&test_buf_desc);
+	struct comp_buffer *sink = buffer_new(&test_buf_desc);
+
+	assert_non_null(src);
+	assert_non_null(sink);
+
+	/* source buffer is filled by host DMA */
+	src->source = &host;
+	src->sink = &eq;
+	sink->source = &eq;
+	sink->sink = &volume;
+	buffer_set_spsc(src, false);
+	buffer_set_spsc(sink, true);
+
+	assert_int_equal(buffer_alias(sink, src), 0);
+
+	comp_update_buffer_produce(src, 6);
+
+	assert_int_equal(src->avail, 6);
+	assert_int_equal(src->free, 4);
+
+	/* process 4 bytes in place */
+	comp_update_buffer_produce(sink, 4);
+	comp_update_buffer_consume(src, 4);
+
+	assert_int_equal(src->avail, 2);
+	assert_int_equal(src->free, 4);
+	assert_int_equal(sink->avail, 4);
+
+	/* DMA fills the rest, free space still accounts for sink data */
+	comp_update_buffer_produce(src, 4);
+
+	assert_int_equal(src->avail, 6);
+	assert_int_equal(src->free, 0);
+
+	comp_update_buffer_consume(sink, 4);
+
+	assert_int_equal(src->free, 4);
+
+	buffer_free(sink);
+	buffer_free(src);
+}
+
+static void test_audio_buffer_locked_counts_bytes(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 10
+	};
+
+	struct pipeline ppl_source;
+	struct pipeline ppl_sink;
+	struct comp_dev source = { .pipeline = &ppl_source };
+	struct comp_dev sink = { .pipeline = &ppl_sink };
+	struct comp_buffer *buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+
+	/* buffer crossing pipelines is updated under lock */
+	buf->source = &source;
+	buf->sink = &sink;
+	buffer_set_spsc(buf, false);
+
+	comp_update_buffer_produce(buf, 6);
+	comp_update_buffer_consume(buf, 4);
+	comp_update_buffer_produce(buf, 8);
+
+	assert_int_equal(buf->avail, 10);
+	assert_int_equal(atomic_read(&buf->w_idx), 14);
+	assert_int_equal(atomic_read(&buf->r_idx), 4);
+
+	comp_update_buffer_consume(buf, 10);
+
+	assert_int_equal(buf->avail, 0);
+	assert_int_equal(atomic_read(&buf->r_idx), 14);
+
+	buffer_free(buf);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
 		cmocka_unit_test
 			(test_audio_buffer_write_10_bytes_out_of_256_and_read_back),
-		cmocka_unit_test(test_audio_buffer_fill_10_bytes)
+		cmocka_unit_test(test_audio_buffer_fill_10_bytes),
+		cmocka_unit_test(test_audio_buffer_spsc_write_wrap_and_fill),
+		cmocka_unit_test(test_audio_buffer_alias_shares_free_space),
+		cmocka_unit_test(test_audio_buffer_alias_locked_source),
+		cmocka_unit_test(test_audio_buffer_locked_counts_bytes)
 	};
 
 	cmocka_set_message_output(CM_OUTPUT_TAP);
@@ -61,4 +61,9 @@ void rfree(void *ptr)
 {
 	free(ptr);
 }
+
+void heap_set_buffer_reclaim(int (*reclaim)(void))
+{
+	(void)reclaim;
+}
 #endif
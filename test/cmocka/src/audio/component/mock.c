@@ -53,4 +53,19 @@ void pipeline_xrun(struct pipeline *p, struct comp_dev *dev, int32_t bytes)
 {
 }
 
+void *pipeline_arena_alloc(struct pipeline *p, size_t bytes)
+{
+	(void)p;
+
+	return calloc(bytes, 1);
+}
+
+bool pipeline_arena_free(struct pipeline *p, void *ptr)
+{
+	(void)p;
+
+	free(ptr);
+	return true;
+}
+
 #endif
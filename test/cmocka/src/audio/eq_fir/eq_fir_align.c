@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <sof/audio/component.h>
+#include <sof/audio/buffer.h>
+#include <sof/audio/eq_fir.h>
+#include <uapi/ipc/topology.h>
+#include <uapi/user/eq.h>
+
+#define EQ_TEST_FRAMES		48
+#define EQ_TEST_PERIODS		4
+#define EQ_TEST_CHANNELS	3
+#define EQ_TEST_LONG		256	/* run with FFT convolution */
+#define EQ_TEST_SHORT		8	/* run with direct form filter */
+
+/* ch 0 long response, ch 1 short response, ch 2 bypass */
+static const int16_t eq_test_assign[EQ_TEST_CHANNELS] = { 0, 1, -1 };
+
+static struct comp_driver comp_eq_fir;
+
+/* Mocking comp_register here so we can use the registered driver */
+int comp_register(struct comp_driver *drv)
+{
+	return memcpy_s(&comp_eq_fir, sizeof(comp_eq_fir), drv,
+			sizeof(*drv));
+}
+
+/* response that passes the input at half amplitude */
+static int16_t *add_response(int16_t *data, int length)
+{
+	struct sof_eq_fir_coef_data *eq = (struct sof_eq_fir_coef_data *)data;
+
+	eq->length = length;
+	eq->out_shift = 0;
+	eq->coef[0] = 1 << 14;
+
+	return data + SOF_EQ_FIR_COEF_NHEADER + length;
+}
+
+static struct sof_ipc_comp_process *create_ipc(void)
+{
+	struct sof_ipc_comp_process *ipc;
+	struct sof_eq_fir_config *config;
+	size_t size = sizeof(*config) +
+		(EQ_TEST_CHANNELS + 2 * SOF_EQ_FIR_COEF_NHEADER +
+		 EQ_TEST_LONG + EQ_TEST_SHORT) * sizeof(int16_t);
+	int16_t *data;
+
+	ipc = calloc(sizeof(*ipc) + size, 1);
+	assert_non_null(ipc);
+
+	ipc->comp.type = SOF_COMP_EQ_FIR;
+	ipc->config.hdr.size = sizeof(ipc->config);
+	ipc->config.periods_sink = 1;
+	ipc->config.periods_source = 1;
+	ipc->size = size;
+
+	config = (struct sof_eq_fir_config *)ipc->data;
+	config->size = size;
+	config->channels_in_config = EQ_TEST_CHANNELS;
+	config->number_of_responses = 2;
+	memcpy(config->data, eq_test_assign, sizeof(eq_test_assign));
+
+	data = add_response(&config->data[EQ_TEST_CHANNELS], EQ_TEST_LONG);
+	add_response(data, EQ_TEST_SHORT);
+
+	return ipc;
+}
+
+static void init_buffer(struct comp_buffer *buffer, int32_t *data)
+{
+	buffer->size = EQ_TEST_FRAMES * EQ_TEST_CHANNELS * sizeof(int32_t);
+	buffer->alloc_size = buffer->size;
+	buffer->addr = data;
+	buffer->end_addr = (char *)data + buffer->size;
+	buffer->r_ptr = data;
+	buffer->w_ptr = data;
+}
+
+/* frame of largest output magnitude in channel */
+static int peak_frame(int32_t *out, int ch)
+{
+	int peak = 0;
+	int i;
+
+	for (i = 1; i < EQ_TEST_PERIODS * EQ_TEST_FRAMES; i++)
+		if (abs(out[i * EQ_TEST_CHANNELS + ch]) >
+		    abs(out[peak * EQ_TEST_CHANNELS + ch]))
+			peak = i;
+
+	return peak;
+}
+
+static void test_audio_eq_fir_fft_align(void **state)
+{
+	struct sof_ipc_comp_process *ipc = create_ipc();
+	struct comp_buffer source = { 0 };
+	struct comp_buffer sink = { 0 };
+	int32_t in[EQ_TEST_FRAMES * EQ_TEST_CHANNELS] = { 0 };
+	int32_t out[EQ_TEST_PERIODS * EQ_TEST_FRAMES * EQ_TEST_CHANNELS];
+	int32_t period[EQ_TEST_FRAMES * EQ_TEST_CHANNELS];
+	struct comp_dev *dev;
+	int ch;
+	int i;
+
+	(void)state;
+
+	sys_comp_eq_fir_init();
+	dev = comp_eq_fir.ops.new((struct sof_ipc_comp *)ipc);
+	assert_non_null(dev);
+
+	list_init(&dev->bsource_list);
+	list_init(&dev->bsink_list);
+	dev->frames = EQ_TEST_FRAMES;
+	dev->params.channels = EQ_TEST_CHANNELS;
+	dev->params.frame_fmt = SOF_IPC_FRAME_S32_LE;
+	dev->params.direction = SOF_IPC_STREAM_PLAYBACK;
+
+	init_buffer(&source, in);
+	init_buffer(&sink, period);
+	/* peer components share the same stream format */
+	source.source = dev;
+	source.sink = dev;
+	sink.source = dev;
+	sink.sink = dev;
+	list_item_append(&source.sink_list, &dev->bsource_list);
+	list_item_append(&sink.source_list, &dev->bsink_list);
+
+	assert_int_equal(comp_eq_fir.ops.prepare(dev), 0);
+
+	/* impulse in all channels at first frame */
+	for (ch = 0; ch < EQ_TEST_CHANNELS; ch++)
+		in[ch] = 1 << 28;
+
+	for (i = 0; i < EQ_TEST_PERIODS; i++) {
+		comp_eq_fir.ops.process(dev, &source, &sink, EQ_TEST_FRAMES);
+		memcpy(&out[i * EQ_TEST_FRAMES * EQ_TEST_CHANNELS], period,
+		       sizeof(period));
+		memset(in, 0, sizeof(in));
+	}
+
+	/* FFT filter delays its output, the other channels must follow */
+	assert_true(peak_frame(out, 0) > 0);
+	assert_int_equal(peak_frame(out, 1), peak_frame(out, 0));
+	assert_int_equal(peak_frame(out, 2), peak_frame(out, 0));
+
+	comp_eq_fir.ops.free(dev);
+	free(ipc);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_audio_eq_fir_fft_align),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include <sof/alloc.h>
+#include <sof/audio/component.h>
+#include <sof/audio/buffer.h>
+
+#include <mock_trace.h>
+
+TRACE_IMPL()
+
+void *rballoc(int zone, uint32_t caps, size_t bytes)
+{
+	(void)zone;
+	(void)caps;
+
+	return malloc(bytes);
+}
+
+void *rzalloc(int zone, uint32_t caps, size_t bytes)
+{
+	(void)zone;
+	(void)caps;
+
+	return calloc(bytes, 1);
+}
+
+void *rrealloc(void *ptr, int zone, uint32_t caps, size_t bytes)
+{
+	(void)zone;
+	(void)caps;
+
+	return realloc(ptr, bytes);
+}
+
+void rfree(void *ptr)
+{
+	free(ptr);
+}
+
+void *comp_arena_alloc(struct comp_dev *dev, size_t bytes)
+{
+	(void)dev;
+
+	return calloc(bytes, 1);
+}
+
+void comp_arena_free(struct comp_dev *dev, void *ptr)
+{
+	(void)dev;
+
+	free(ptr);
+}
+
+int comp_set_state(struct comp_dev *dev, int cmd)
+{
+	return 0;
+}
+
+void comp_set_period_bytes(struct comp_dev *dev, uint32_t frames,
+			   enum sof_ipc_frame *format, uint32_t *period_bytes)
+{
+	*format = dev->params.frame_fmt;
+	*period_bytes = frames * comp_frame_bytes(dev);
+}
+
+int comp_get_copy_limits(struct comp_dev *dev, struct comp_copy_limits *cl)
+{
+	return -EINVAL;
+}
+
+void comp_update_buffer_produce(struct comp_buffer *buffer, uint32_t bytes)
+{
+}
+
+void comp_update_buffer_consume(struct comp_buffer *buffer, uint32_t bytes)
+{
+}
@@ -32,6 +32,11 @@ void rfree(void *ptr)
 	free(ptr);
 }
 
+void heap_set_buffer_reclaim(int (*reclaim)(void))
+{
+	(void)reclaim;
+}
+
 void pipeline_xrun(struct pipeline *p, struct comp_dev *dev, int32_t bytes)
 {
 }
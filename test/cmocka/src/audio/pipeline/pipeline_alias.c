@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <sof/audio/component.h>
+#include <sof/audio/pipeline.h>
+#include <sof/audio/buffer.h>
+#include <sof/schedule.h>
+#include "pipeline_mocks.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#define ALIAS_TEST_COMPS	4
+#define ALIAS_TEST_BUFFERS	(ALIAS_TEST_COMPS - 1)
+
+struct pipeline_alias_data {
+	struct pipeline *p;
+	struct comp_dev comp[ALIAS_TEST_COMPS];
+	struct comp_buffer buffer[ALIAS_TEST_BUFFERS];
+};
+
+static struct comp_driver drv_endpoint;
+
+static struct comp_driver drv_inplace = {
+	.flags = COMP_DRV_INPLACE,
+};
+
+/* host -> eq -> volume -> dai playback pipeline */
+static int setup(void **state)
+{
+	struct sof_ipc_pipe_new pipe_desc = { .core = 0, .priority = 2 };
+	struct pipeline_alias_data *data = calloc(1, sizeof(*data));
+	struct comp_buffer *buffer;
+	struct comp_dev *comp;
+	int i;
+
+	if (!data)
+		return -1;
+
+	data->p = pipeline_new(&pipe_desc, &data->comp[0]);
+	if (!data->p)
+		return -1;
+
+	for (i = 0; i < ALIAS_TEST_COMPS; i++) {
+		comp = &data->comp[i];
+		comp->comp.id = i;
+		comp->drv = i && i < ALIAS_TEST_COMPS - 1 ? &drv_inplace :
+			&drv_endpoint;
+		list_init(&comp->bsource_list);
+		list_init(&comp->bsink_list);
+	}
+
+	data->comp[0].comp.type = SOF_COMP_HOST;
+	data->comp[ALIAS_TEST_COMPS - 1].comp.type = SOF_COMP_DAI;
+
+	for (i = 0; i < ALIAS_TEST_BUFFERS; i++) {
+		buffer = &data->buffer[i];
+		buffer->ipc_buffer.size = 384;
+		buffer->source = &data->comp[i];
+		buffer->sink = &data->comp[i + 1];
+		list_item_append(&buffer->source_list,
+				 &data->comp[i].bsink_list);
+		list_item_append(&buffer->sink_list,
+				 &data->comp[i + 1].bsource_list);
+	}
+
+	*state = data;
+
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	struct pipeline_alias_data *data = *state;
+
+	free(data->p);
+	free(data);
+
+	return 0;
+}
+
+static void test_audio_pipeline_alias_dma_fed_buffer(void **state)
+{
+	struct pipeline_alias_data *data = *state;
+	struct comp_buffer *buffer = data->buffer;
+
+	assert_int_equal(pipeline_complete(data->p, &data->comp[0],
+					   &data->comp[ALIAS_TEST_COMPS - 1]),
+			 0);
+
+	/* buffers of DMA endpoints are locked */
+	assert_false(buffer[0].spsc);
+	assert_true(buffer[1].spsc);
+	assert_false(buffer[2].spsc);
+
+	/* eq processes in place in the buffer filled by host DMA */
+	assert_ptr_equal(buffer[1].alias, &buffer[0]);
+	assert_ptr_equal(buffer[0].alias_next, &buffer[1]);
+
+	/* buffer drained by DAI DMA keeps its own memory */
+	assert_null(buffer[2].alias);
+	assert_null(buffer[1].alias_next);
+}
+
+static void test_audio_pipeline_alias_other_pipeline_dma(void **state)
+{
+	struct pipeline_alias_data *data = *state;
+	struct sof_ipc_pipe_new pipe_desc = { .core = 0, .priority = 2 };
+	struct pipeline *host_p = pipeline_new(&pipe_desc, &data->comp[0]);
+	struct comp_buffer *buffer = data->buffer;
+
+	assert_non_null(host_p);
+
+	/* host is completed with its own pipeline, the eq can't rely on
+	 * the buffer being updated from the same task
+	 */
+	data->comp[0].comp.pipeline_id = 1;
+	data->comp[0].pipeline = host_p;
+
+	assert_int_equal(pipeline_complete(data->p, &data->comp[1],
+					   &data->comp[ALIAS_TEST_COMPS - 1]),
+			 0);
+
+	assert_false(buffer[0].spsc);
+	assert_null(buffer[1].alias);
+	assert_null(buffer[0].alias_next);
+
+	free(host_p);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown
+			(test_audio_pipeline_alias_dma_fed_buffer,
+			 setup, teardown),
+		cmocka_unit_test_setup_teardown
+			(test_audio_pipeline_alias_other_pipeline_dma,
+			 setup, teardown),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
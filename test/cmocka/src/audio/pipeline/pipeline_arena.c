@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ */
+
+#include <stdint.h>
+#include <sof/audio/component.h>
+#include <sof/audio/pipeline.h>
+#include <sof/schedule.h>
+#include "pipeline_mocks.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+static int setup(void **state)
+{
+	struct sof_ipc_pipe_new pipe_desc = { .core = 0, .priority = 2 };
+
+	*state = pipeline_new(&pipe_desc, NULL);
+
+	return *state ? 0 : -1;
+}
+
+static int teardown(void **state)
+{
+	free(*state);
+	return 0;
+}
+
+static void test_audio_pipeline_arena_alloc(void **state)
+{
+	struct pipeline *p = *state;
+	uint8_t *a = pipeline_arena_alloc(p, 100);
+	uint8_t *b = pipeline_arena_alloc(p, 20);
+
+	assert_non_null(a);
+	assert_non_null(b);
+	assert_int_equal(p->arena.live, 2);
+
+	/* allocations are aligned and don't overlap */
+	assert_int_equal((uintptr_t)a % PPL_ARENA_ALIGN, 0);
+	assert_ptr_equal(b, a + ALIGN(100, PPL_ARENA_ALIGN) +
+			 PPL_ARENA_HDR_SIZE);
+	assert_int_equal(a[0], 0);
+	assert_int_equal(b[19], 0);
+
+	/* last allocation is reused when freed */
+	assert_true(pipeline_arena_free(p, b));
+	assert_ptr_equal(pipeline_arena_alloc(p, 20), b);
+
+	/* large allocation gets its own chunk */
+	uint8_t *c = pipeline_arena_alloc(p, PPL_ARENA_CHUNK_SIZE * 2);
+
+	assert_non_null(c);
+	assert_ptr_equal(p->arena.chunks->data + PPL_ARENA_HDR_SIZE, c);
+
+	/* all memory is reused once everything is freed */
+	assert_true(pipeline_arena_free(p, a));
+	assert_true(pipeline_arena_free(p, b));
+	assert_true(pipeline_arena_free(p, c));
+	assert_int_equal(p->arena.live, 0);
+	assert_ptr_equal(pipeline_arena_alloc(p, 8), c);
+}
+
+static void test_audio_pipeline_arena_realloc_in_order(void **state)
+{
+	struct sof_ipc_pipe_new pipe_desc = { .core = 0, .priority = 2 };
+	struct pipeline *p = pipeline_new(&pipe_desc, NULL);
+	size_t size = PPL_ARENA_CHUNK_SIZE / 2 - PPL_ARENA_HDR_SIZE;
+	struct pipeline_arena_chunk *chunk;
+	uint8_t *a;
+	uint8_t *b;
+	uint8_t *c;
+
+	(void)state;
+
+	assert_non_null(p);
+
+	/* two delay lines filling one chunk */
+	a = pipeline_arena_alloc(p, size);
+	b = pipeline_arena_alloc(p, size);
+	chunk = p->arena.chunks;
+
+	assert_non_null(a);
+	assert_non_null(b);
+	assert_int_equal(chunk->used, chunk->size);
+
+	/* setup again frees and allocates each in order, e.g. on xrun */
+	assert_true(pipeline_arena_free(p, a));
+	assert_ptr_equal(pipeline_arena_alloc(p, size), a);
+	assert_true(pipeline_arena_free(p, b));
+	assert_ptr_equal(pipeline_arena_alloc(p, size), b);
+
+	/* smaller allocation splits freed block, rest is reused */
+	assert_true(pipeline_arena_free(p, a));
+	assert_ptr_equal(pipeline_arena_alloc(p, size / 2), a);
+	c = pipeline_arena_alloc(p, size / 4);
+	assert_ptr_equal(c, a + ALIGN(size / 2, PPL_ARENA_ALIGN) +
+			 PPL_ARENA_HDR_SIZE);
+
+	/* freed neighbours are merged back */
+	assert_true(pipeline_arena_free(p, a));
+	assert_true(pipeline_arena_free(p, c));
+	assert_ptr_equal(pipeline_arena_alloc(p, size), a);
+
+	/* no new chunk was needed */
+	assert_ptr_equal(p->arena.chunks, chunk);
+	assert_null(chunk->next);
+	assert_int_equal(p->arena.live, 2);
+
+	free(p);
+}
+
+static void test_audio_pipeline_arena_free_foreign(void **state)
+{
+	struct pipeline *p = *state;
+	int heap;
+
+	assert_false(pipeline_arena_free(p, &heap));
+}
+
+static void test_audio_pipeline_arena_release_in_use(void **state)
+{
+	struct sof_ipc_pipe_new pipe_desc = { .core = 0, .priority = 2 };
+	struct pipeline *p = pipeline_new(&pipe_desc, NULL);
+	struct comp_dev comp = { .state = COMP_STATE_READY };
+
+	(void)state;
+
+	assert_non_null(p);
+
+	list_init(&comp.bsource_list);
+	list_init(&comp.bsink_list);
+	comp.pipeline = p;
+	p->source_comp = &comp;
+
+	assert_non_null(pipeline_arena_alloc(p, 100));
+	assert_non_null(pipeline_arena_alloc(p, PPL_ARENA_CHUNK_SIZE));
+
+	/* pipeline is freed with component still holding arena memory */
+	assert_int_equal(pipeline_free(p), 0);
+	assert_null(p->arena.chunks);
+	assert_int_equal(p->arena.live, 0);
+	assert_null(comp.pipeline);
+	assert_true(comp.arena_released);
+
+	free(p);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_audio_pipeline_arena_alloc),
+		cmocka_unit_test(test_audio_pipeline_arena_realloc_in_order),
+		cmocka_unit_test(test_audio_pipeline_arena_free_foreign),
+		cmocka_unit_test(test_audio_pipeline_arena_release_in_use),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
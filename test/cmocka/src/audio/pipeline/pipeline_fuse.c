@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdint.h>
+#include <sof/audio/component.h>
+#include <sof/audio/pipeline.h>
+#include <sof/audio/buffer.h>
+#include <sof/schedule.h>
+#include "pipeline_mocks.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#define FUSE_TEST_COMPS		4
+#define FUSE_TEST_BUFFERS	(FUSE_TEST_COMPS - 1)
+
+/* two tiles as allocated by pipeline_prepare() */
+#define FUSE_TEST_TILES_BYTES \
+	(2 * PPL_FUSE_FRAMES * PLATFORM_MAX_CHANNELS * sizeof(int32_t))
+
+struct pipeline_fuse_data {
+	struct pipeline *p;
+	struct comp_dev comp[FUSE_TEST_COMPS];
+	struct comp_buffer buffer[FUSE_TEST_BUFFERS];
+	int copies[FUSE_TEST_COMPS];
+};
+
+static int mock_copy(struct comp_dev *dev)
+{
+	struct pipeline_fuse_data *data = comp_get_drvdata(dev);
+
+	data->copies[dev->comp.id]++;
+
+	return 0;
+}
+
+static int mock_process(struct comp_dev *dev, struct comp_buffer *source,
+			struct comp_buffer *sink, uint32_t frames)
+{
+	(void)dev;
+	(void)source;
+	(void)sink;
+	(void)frames;
+
+	return 0;
+}
+
+static struct comp_driver drv_copy = {
+	.ops = {
+		.copy = mock_copy,
+	},
+};
+
+static struct comp_driver drv_process = {
+	.flags = COMP_DRV_INPLACE,
+	.ops = {
+		.copy = mock_copy,
+		.process = mock_process,
+	},
+};
+
+/* host -> process -> process -> dai capture pipeline, the two middle
+ * components can be fused
+ */
+static int setup(void **state)
+{
+	struct sof_ipc_pipe_new pipe_desc = { .core = 0, .priority = 2 };
+	struct pipeline_fuse_data *data = calloc(1, sizeof(*data));
+	struct comp_buffer *buffer;
+	struct comp_dev *comp;
+	int i;
+
+	if (!data)
+		return -1;
+
+	data->p = pipeline_new(&pipe_desc, &data->comp[0]);
+	if (!data->p)
+		return -1;
+
+	for (i = 0; i < FUSE_TEST_COMPS; i++) {
+		comp = &data->comp[i];
+		comp->comp.id = i;
+		comp->drv = i && i < FUSE_TEST_COMPS - 1 ? &drv_process :
+			&drv_copy;
+		comp->state = COMP_STATE_ACTIVE;
+		comp->pipeline = data->p;
+		comp->params.direction = SOF_IPC_STREAM_CAPTURE;
+		comp->params.frame_fmt = SOF_IPC_FRAME_S32_LE;
+		comp->params.channels = 2;
+		list_init(&comp->bsource_list);
+		list_init(&comp->bsink_list);
+		comp_set_drvdata(comp, data);
+	}
+
+	for (i = 0; i < FUSE_TEST_BUFFERS; i++) {
+		buffer = &data->buffer[i];
+		buffer->source = &data->comp[i];
+		buffer->sink = &data->comp[i + 1];
+		buffer->spsc = true;
+		list_item_append(&buffer->source_list,
+				 &data->comp[i].bsink_list);
+		list_item_append(&buffer->sink_list,
+				 &data->comp[i + 1].bsource_list);
+	}
+
+	data->p->source_comp = &data->comp[0];
+	data->p->sink_comp = &data->comp[FUSE_TEST_COMPS - 1];
+	data->p->fuse_tiles = malloc(FUSE_TEST_TILES_BYTES);
+
+	*state = data;
+
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	struct pipeline_fuse_data *data = *state;
+
+	free(data->p->fuse_tiles);
+	free(data->p);
+	free(data);
+
+	return 0;
+}
+
+/* runs one pipeline task copy, every component must be copied once */
+static void pipeline_fuse_copy(struct pipeline_fuse_data *data)
+{
+	int i;
+
+	data->p->pipe_task.func(data->p->pipe_task.data);
+
+	for (i = 0; i < FUSE_TEST_COMPS; i++)
+		assert_int_equal(data->copies[i], 1);
+}
+
+static void test_audio_pipeline_fuse_chain(void **state)
+{
+	struct pipeline_fuse_data *data = *state;
+
+	pipeline_fuse_copy(data);
+
+	assert_int_equal(data->p->copy_order_count, FUSE_TEST_COMPS);
+	assert_int_equal(data->p->copy_order[0].fused, 0);
+	assert_int_equal(data->p->copy_order[1].fused, 2);
+}
+
+static void test_audio_pipeline_fuse_skips_aliased_buffer(void **state)
+{
+	struct pipeline_fuse_data *data = *state;
+
+	/* in place sink buffer of first component shares its memory */
+	assert_int_equal(buffer_alias(&data->buffer[1], &data->buffer[0]), 0);
+	assert_true(data->buffer[1].no_bypass);
+
+	pipeline_fuse_copy(data);
+
+	assert_int_equal(data->p->copy_order_count, FUSE_TEST_COMPS);
+	assert_int_equal(data->p->copy_order[1].fused, 0);
+	assert_int_equal(data->p->copy_order[2].fused, 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_audio_pipeline_fuse_chain,
+						setup, teardown),
+		cmocka_unit_test_setup_teardown
+			(test_audio_pipeline_fuse_skips_aliased_buffer,
+			 setup, teardown),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
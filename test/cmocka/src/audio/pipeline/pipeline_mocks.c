@@ -31,10 +31,12 @@
 #include "pipeline_mocks.h"
 
 #include <mock_trace.h>
+#include <stdlib.h>
 
 TRACE_IMPL()
 
 struct ipc *_ipc;
+struct timer *platform_timer;
 
 void platform_dai_timestamp(struct comp_dev *dai,
 	struct sof_ipc_stream_posn *posn)
@@ -64,14 +66,15 @@ int schedule_task_init(struct task *task, uint16_t type, uint16_t priority,
 		       uint64_t (*func)(void *data), void *data, uint16_t core,
 		       uint32_t xflags)
 {
-	(void)task;
 	(void)type;
 	(void)priority;
-	(void)func;
-	(void)data;
 	(void)core;
 	(void)xflags;
 
+	/* tests can run the task */
+	task->func = func;
+	task->data = data;
+
 	return 0;
 }
 
@@ -81,6 +84,33 @@ int schedule_task_cancel(struct task *task)
 	return 0;
 }
 
+void *rballoc(int zone, uint32_t caps, size_t bytes)
+{
+	(void)zone;
+	(void)caps;
+	return malloc(bytes);
+}
+
+void *rballoc_align(int zone, uint32_t caps, size_t bytes, uint32_t alignment)
+{
+	(void)zone;
+	(void)caps;
+	return aligned_alloc(alignment, ALIGN(bytes, alignment));
+}
+
+uint64_t platform_timer_get(struct timer *timer)
+{
+	(void)timer;
+	return 0;
+}
+
+uint64_t clock_ms_to_ticks(int clock, uint64_t ms)
+{
+	(void)clock;
+	(void)ms;
+	return 0;
+}
+
 void rfree(void *ptr)
 {
 	(void)ptr;
@@ -127,3 +157,43 @@ void __panic(uint32_t p, char *filename, uint32_t linenum)
 	(void)filename;
 	(void)linenum;
 }
+
+void buffer_set_spsc(struct comp_buffer *buffer, bool spsc)
+{
+	buffer->spsc = spsc;
+}
+
+int buffer_alias(struct comp_buffer *buffer, struct comp_buffer *source)
+{
+	buffer->alias = source;
+	source->alias_next = buffer;
+	buffer->no_bypass = true;
+	source->no_bypass = true;
+	return 0;
+}
+
+int buffer_unalias(struct comp_buffer *buffer)
+{
+	(void)buffer;
+	return 0;
+}
+
+void comp_update_buffer_produce(struct comp_buffer *buffer, uint32_t bytes)
+{
+	(void)buffer;
+	(void)bytes;
+}
+
+void comp_update_buffer_consume(struct comp_buffer *buffer, uint32_t bytes)
+{
+	(void)buffer;
+	(void)bytes;
+}
+
+int comp_set_state(struct comp_dev *dev, int cmd)
+{
+	(void)dev;
+	(void)cmd;
+
+	return 0;
+}
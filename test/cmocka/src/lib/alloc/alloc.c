@@ -339,9 +339,234 @@ static void test_lib_alloc(void **state)
 	}
 }
 
+static void *buffer_blocks(int count)
+{
+	return rballoc(RZONE_BUFFER, SOF_MEM_CAPS_RAM,
+		       count * HEAP_BUFFER_BLOCK_SIZE);
+}
+
+static void test_lib_alloc_fragmented_run(void **state)
+{
+	char *block[10];
+	char *run;
+	int i;
+
+	(void)state;
+
+	for (i = 0; i < ARRAY_SIZE(block); ++i) {
+		block[i] = buffer_blocks(1);
+		assert_ptr_equal(block[i],
+				 block[0] + i * HEAP_BUFFER_BLOCK_SIZE);
+	}
+
+	/* leave free gaps of 1, 2 and 3 blocks */
+	rfree(block[1]);
+	rfree(block[3]);
+	rfree(block[4]);
+	rfree(block[6]);
+	rfree(block[7]);
+	rfree(block[8]);
+
+	/* each run goes to the first gap it fits in */
+	run = buffer_blocks(3);
+	assert_ptr_equal(run, block[6]);
+	rfree(run);
+
+	run = buffer_blocks(2);
+	assert_ptr_equal(run, block[3]);
+	rfree(run);
+
+	run = buffer_blocks(1);
+	assert_ptr_equal(run, block[1]);
+	rfree(run);
+
+	/* run longer than any gap goes after the last used block */
+	run = buffer_blocks(4);
+	assert_ptr_equal(run, block[9] + HEAP_BUFFER_BLOCK_SIZE);
+	rfree(run);
+
+	rfree(block[0]);
+	rfree(block[2]);
+	rfree(block[5]);
+	rfree(block[9]);
+}
+
+static void test_lib_alloc_align(void **state)
+{
+	uint32_t alignment;
+	char *mem;
+	int i;
+
+	(void)state;
+
+	for (alignment = 16; alignment <= 1024; alignment <<= 2) {
+		mem = rzalloc_align(RZONE_RUNTIME, SOF_MEM_CAPS_RAM, 48,
+				    alignment);
+		assert_non_null(mem);
+		assert_int_equal((uintptr_t)mem & (alignment - 1), 0);
+
+		for (i = 0; i < 48; ++i)
+			assert_int_equal(mem[i], 0);
+
+		rfree(mem);
+
+		mem = rballoc_align(RZONE_BUFFER, SOF_MEM_CAPS_RAM, 1000,
+				    alignment);
+		assert_non_null(mem);
+		assert_int_equal((uintptr_t)mem & (alignment - 1), 0);
+
+		rfree(mem);
+	}
+
+	/* alignment must be power of 2 */
+	assert_null(rzalloc_align(RZONE_RUNTIME, SOF_MEM_CAPS_RAM, 48, 48));
+	assert_null(rballoc_align(RZONE_BUFFER, SOF_MEM_CAPS_RAM, 48, 48));
+}
+
+static void test_lib_alloc_realloc_grow(void **state)
+{
+	char *mem = buffer_blocks(1);
+	char *next;
+
+	(void)state;
+
+	assert_non_null(mem);
+	mem[0] = 0x5a;
+
+	/* following blocks are free, so allocation grows in place */
+	assert_ptr_equal(rrealloc(mem, RZONE_BUFFER, SOF_MEM_CAPS_RAM,
+				  3 * HEAP_BUFFER_BLOCK_SIZE), mem);
+	assert_int_equal(mem[0], 0x5a);
+
+	/* and the blocks it grew into are in use */
+	next = buffer_blocks(1);
+	assert_ptr_equal(next, mem + 3 * HEAP_BUFFER_BLOCK_SIZE);
+
+	rfree(next);
+	rfree(mem);
+}
+
+static void test_lib_alloc_realloc_move(void **state)
+{
+	char *mem = buffer_blocks(1);
+	char *next = buffer_blocks(1);
+	char *moved;
+	int i;
+
+	(void)state;
+
+	assert_non_null(mem);
+	assert_ptr_equal(next, mem + HEAP_BUFFER_BLOCK_SIZE);
+
+	for (i = 0; i < HEAP_BUFFER_BLOCK_SIZE; ++i)
+		mem[i] = i;
+
+	/* following block is used, so allocation moves and is copied */
+	moved = rrealloc(mem, RZONE_BUFFER, SOF_MEM_CAPS_RAM,
+			 2 * HEAP_BUFFER_BLOCK_SIZE);
+	assert_ptr_equal(moved, next + HEAP_BUFFER_BLOCK_SIZE);
+
+	for (i = 0; i < HEAP_BUFFER_BLOCK_SIZE; ++i)
+		assert_int_equal(moved[i], (char)i);
+
+	/* old blocks are freed */
+	assert_ptr_equal(buffer_blocks(1), mem);
+
+	rfree(mem);
+	rfree(moved);
+	rfree(next);
+}
+
+static void test_lib_alloc_realloc_shrink(void **state)
+{
+	char *mem = buffer_blocks(3);
+	char *next;
+
+	(void)state;
+
+	assert_non_null(mem);
+
+	/* smaller size keeps allocation and all its blocks */
+	assert_ptr_equal(rrealloc(mem, RZONE_BUFFER, SOF_MEM_CAPS_RAM,
+				  HEAP_BUFFER_BLOCK_SIZE), mem);
+
+	next = buffer_blocks(1);
+	assert_ptr_equal(next, mem + 3 * HEAP_BUFFER_BLOCK_SIZE);
+
+	rfree(next);
+	rfree(mem);
+}
+
+static char *reclaim_held;
+static int reclaim_calls;
+
+/* gives one held block back to the heap */
+static int reclaim_block(void)
+{
+	char *block = reclaim_held;
+
+	reclaim_calls++;
+
+	if (!block)
+		return 0;
+
+	reclaim_held = *(char **)block;
+	rfree(block);
+
+	return 1;
+}
+
+static void test_lib_alloc_buffer_reclaim(void **state)
+{
+	char *held = NULL;
+	char *block;
+	char *mem;
+
+	(void)state;
+
+	/* fill buffer heap with blocks linked through their memory */
+	while ((block = buffer_blocks(1))) {
+		*(char **)block = held;
+		held = block;
+	}
+
+	heap_set_buffer_reclaim(reclaim_block);
+	reclaim_held = held;
+	reclaim_calls = 0;
+
+	/* failed allocation is retried with the reclaimed block */
+	mem = buffer_blocks(1);
+	assert_ptr_equal(mem, held);
+	assert_int_equal(reclaim_calls, 1);
+
+	/* allocation fails when nothing could be reclaimed */
+	held = reclaim_held;
+	reclaim_held = NULL;
+	assert_null(buffer_blocks(1));
+	assert_int_equal(reclaim_calls, 2);
+
+	heap_set_buffer_reclaim(NULL);
+	rfree(mem);
+
+	while (held) {
+		block = held;
+		held = *(char **)block;
+		rfree(block);
+	}
+}
+
+static const struct CMUnitTest map_tests[] = {
+	cmocka_unit_test_setup(test_lib_alloc_fragmented_run, clear_sys),
+	cmocka_unit_test_setup(test_lib_alloc_align, clear_sys),
+	cmocka_unit_test_setup(test_lib_alloc_realloc_grow, clear_sys),
+	cmocka_unit_test_setup(test_lib_alloc_realloc_move, clear_sys),
+	cmocka_unit_test_setup(test_lib_alloc_realloc_shrink, clear_sys),
+	cmocka_unit_test_setup(test_lib_alloc_buffer_reclaim, clear_sys),
+};
+
 int main(void)
 {
-	struct CMUnitTest tests[ARRAY_SIZE(test_cases)];
+	struct CMUnitTest tests[ARRAY_SIZE(test_cases) + ARRAY_SIZE(map_tests)];
 
 	int i;
 
@@ -355,6 +580,9 @@ int main(void)
 		t->teardown_func = NULL;
 	}
 
+	for (i = 0; i < ARRAY_SIZE(map_tests); ++i)
+		tests[ARRAY_SIZE(test_cases) + i] = map_tests[i];
+
 	cmocka_set_message_output(CM_OUTPUT_TAP);
 
 	return cmocka_run_group_tests(tests, setup, teardown);
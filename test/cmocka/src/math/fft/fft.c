@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <sof/math/fft.h>
+
+/* Max error in Q1.31 compared to double precision DFT */
+#define CMP_TOLERANCE 0.000000005
+
+static struct icomplex32 buf[FFT_SIZE_MAX];
+static double ref_real[FFT_SIZE_MAX];
+static double ref_imag[FFT_SIZE_MAX];
+
+/* Pseudo random test signal in range -0.5 to 0.5 */
+static double test_signal(int n, int phase)
+{
+	return 0.5 * sin(0.1 * n * n + phase) * cos(1.7 * n + 3 * phase);
+}
+
+static void test_fft_size(int size, int inverse)
+{
+	double sign = inverse ? 1.0 : -1.0;
+	double re;
+	double im;
+	double w;
+	double diff;
+	int n;
+	int k;
+
+	for (n = 0; n < size; n++) {
+		ref_real[n] = test_signal(n, 0);
+		ref_imag[n] = test_signal(n, 1);
+		buf[n].real = lround(ref_real[n] * 2147483648.0);
+		buf[n].imag = lround(ref_imag[n] * 2147483648.0);
+	}
+
+	fft_32(buf, size, inverse);
+
+	for (k = 0; k < size; k++) {
+		re = 0;
+		im = 0;
+		for (n = 0; n < size; n++) {
+			w = sign * 2 * M_PI * n * k / size;
+			re += ref_real[n] * cos(w) - ref_imag[n] * sin(w);
+			im += ref_real[n] * sin(w) + ref_imag[n] * cos(w);
+		}
+
+		/* The FFT scales the output by 1 / size */
+		diff = fmax(fabs(re / size - buf[k].real / 2147483648.0),
+			    fabs(im / size - buf[k].imag / 2147483648.0));
+		if (diff > CMP_TOLERANCE) {
+			printf("%s: diff for size %d bin %d = %.12f\n",
+			       __func__, size, k, diff);
+		}
+
+		assert_true(diff <= CMP_TOLERANCE);
+	}
+}
+
+static void test_math_fft_forward(void **state)
+{
+	(void)state;
+
+	int size;
+
+	for (size = 2; size <= FFT_SIZE_MAX; size <<= 1)
+		test_fft_size(size, 0);
+}
+
+static void test_math_fft_inverse(void **state)
+{
+	(void)state;
+
+	int size;
+
+	for (size = 2; size <= FFT_SIZE_MAX; size <<= 1)
+		test_fft_size(size, 1);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_math_fft_forward),
+		cmocka_unit_test(test_math_fft_inverse),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+
+# Converts scheduler timeline trace (CONFIG_TRACE_SCHEDULE) to Chrome trace
+# JSON for chrome://tracing or Perfetto.
+# Input is sof-logger raw output, e.g.:
+#   sof-logger -l sof-apl.ldc -t -r | sof-sched-timeline.py -o timeline.json
+
+import argparse
+import json
+import re
+import sys
+
+# raw entry: core level class-type.priority timestamp delta (file:line) text
+ENTRY = re.compile(r'^(\d+) \d+ SCHEDULE-(\d+)\.(\d+) ([\d.]+) \S+ \(\S+\) '
+		   r'timeline task 0x([0-9a-f]+) start (\d+) delay (\d+) '
+		   r'run (\d+)')
+DROPPED = re.compile(r'^(\d+) \d+ SCHEDULE ([\d.]+) \S+ \(\S+\) '
+		     r'timeline dropped (\d+)')
+COLOR = re.compile(r'\x1b\[[0-9;]*m')
+
+TYPES = ['EDF', 'LL']
+
+def task_run(match, clock):
+	core, sch_type, priority, stamp, task, start, delay, run = \
+		match.groups()
+
+	# start was sent as low 32 bits, restore it from trace timestamp
+	stamp = int(round(float(stamp) * clock))
+	start = stamp - ((stamp - int(start)) & 0xffffffff)
+
+	sch_type = int(sch_type)
+	name = '%s pri %s 0x%s' % (TYPES[sch_type] if sch_type < len(TYPES)
+				   else sch_type, priority, task)
+
+	return {
+		'name': name,
+		'cat': 'task',
+		'ph': 'X',
+		'pid': 0,
+		'tid': int(core),
+		'ts': start / clock,
+		'dur': int(run) / clock,
+		'args': {'delay_us': int(delay) / clock},
+	}
+
+def dropped_runs(match):
+	core, stamp, count = match.groups()
+
+	return {
+		'name': 'dropped %s' % count,
+		'cat': 'task',
+		'ph': 'i',
+		's': 't',
+		'pid': 0,
+		'tid': int(core),
+		'ts': float(stamp),
+	}
+
+def main():
+	parser = argparse.ArgumentParser(description='Convert SOF scheduler '
+					 'timeline trace to Chrome trace JSON')
+	parser.add_argument('-i', '--input', type=argparse.FileType('r'),
+			    default=sys.stdin, help='sof-logger -r output')
+	parser.add_argument('-o', '--output', type=argparse.FileType('w'),
+			    default=sys.stdout, help='JSON output')
+	parser.add_argument('-c', '--clock', type=float, default=19.2,
+			    help='timestamp clock in MHz, as for sof-logger')
+	args = parser.parse_args()
+
+	events = []
+	cores = set()
+
+	for line in args.input:
+		line = COLOR.sub('', line)
+
+		match = ENTRY.match(line)
+		if match:
+			events.append(task_run(match, args.clock))
+		else:
+			match = DROPPED.match(line)
+			if not match:
+				continue
+			events.append(dropped_runs(match))
+
+		cores.add(events[-1]['tid'])
+
+	for core in sorted(cores):
+		events.append({'name': 'thread_name', 'ph': 'M', 'pid': 0,
+			       'tid': core, 'args': {'name': 'core %d' % core}})
+
+	json.dump({'traceEvents': events, 'displayTimeUnit': 'ns'},
+		  args.output, indent=1)
+
+if __name__ == '__main__':
+	main()
@@ -9,7 +9,8 @@ dnl Define macro for pipeline widget
 dnl Pipeline name)
 define(`N_PIPELINE', `PIPELINE.'PIPELINE_ID`.'$1)
 
-dnl W_PIPELINE(stream, period, priority, frames, core, initiator, platform)
+dnl W_PIPELINE(stream, period, priority, frames, core, initiator, platform,
+dnl            [batch])
 define(`W_PIPELINE',
 `SectionVendorTuples."'N_PIPELINE($1)`_tuples" {'
 `	tokens "sof_sched_tokens"'
@@ -19,6 +20,8 @@ define(`W_PIPELINE',
 `		SOF_TKN_SCHED_CORE'		STR($5)
 `		SOF_TKN_SCHED_FRAMES'		STR($4)
 `		SOF_TKN_SCHED_TIME_DOMAIN'	STR($6)
+`ifelse(`$8', `', `', `		SOF_TKN_SCHED_BATCH		"$8"
+')'
 `	}'
 `}'
 `SectionData."'N_PIPELINE($1)`_data" {'